@@ -0,0 +1,90 @@
+#include "alloc_counter.h"
+
+#if defined(BIGWASH_COUNT_ALLOCATIONS)
+
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace
+{
+    // Тривиальный thread_local: доступен и до конструкторов потока
+    thread_local std::uint64_t allocations = 0;
+
+    void* allocate(std::size_t size)
+    {
+        ++allocations;
+        if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        ++allocations;
+        std::size_t align = static_cast<std::size_t>(alignment);
+        std::size_t rounded = size == 0 ? align : (size + align - 1) / align * align;
+#if defined(_MSC_VER)
+        void* memory = _aligned_malloc(rounded, align);
+#else
+        void* memory = std::aligned_alloc(align, rounded);
+#endif
+        if (memory) return memory;
+        throw std::bad_alloc();
+    }
+
+    void freeAligned(void* memory)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    ++allocations;
+    return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { freeAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { freeAligned(memory); }
+
+bool allocationCountingEnabled()
+{
+    return true;
+}
+
+std::uint64_t threadAllocationCount()
+{
+    return allocations;
+}
+
+#else
+
+bool allocationCountingEnabled()
+{
+    return false;
+}
+
+std::uint64_t threadAllocationCount()
+{
+    return 0;
+}
+
+#endif
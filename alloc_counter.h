@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Счётчик выделений кучи для проверки бюджета кадра. Сам счёт включается
+// сборкой с BIGWASH_COUNT_ALLOCATIONS: тогда alloc_counter.cpp подменяет
+// глобальные operator new. Без неё функции ничего не считают.
+bool allocationCountingEnabled();
+
+// Выделений текущим потоком с его запуска. Поток подсказок и прочие
+// фоновые потоки считаются отдельно и в бюджет кадра не входят.
+std::uint64_t threadAllocationCount();
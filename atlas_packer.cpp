@@ -0,0 +1,183 @@
+// Офлайн-упаковщик атласа: собирает все картинки из описания в одну
+// текстуру и пишет рядом таблицу UV-прямоугольников.
+//
+// Использование: atlas_packer <описание.txt> <atlas.png> <atlas_uv.txt> [ширина]
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const unsigned PADDING = 2; // Поля вокруг каждого спрайта против протекания при сглаживании
+    // Сторона текстуры, которую держат все видеокарты, куда ставится игра.
+    // Упаковщик работает при сборке, часто без дисплея, поэтому не
+    // спрашивает видеокарту машины сборки (для этого нужен контекст OpenGL).
+    const unsigned MAX_ATLAS_SIZE = 4096;
+
+    struct SpriteEntry
+    {
+        std::string name;
+        const sf::Image* image;
+        sf::IntRect source;
+        sf::IntRect placed;
+    };
+
+    std::string directoryOf(const std::string& path)
+    {
+        std::size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // Копирует область и растягивает её крайние пиксели на поля
+    void blitWithBorder(sf::Image& atlas, const SpriteEntry& entry)
+    {
+        const int width = entry.source.width;
+        const int height = entry.source.height;
+        const int pad = static_cast<int>(PADDING);
+
+        for (int y = -pad; y < height + pad; ++y)
+        {
+            for (int x = -pad; x < width + pad; ++x)
+            {
+                int srcX = entry.source.left + std::min(std::max(x, 0), width - 1);
+                int srcY = entry.source.top + std::min(std::max(y, 0), height - 1);
+                atlas.setPixel(entry.placed.left + x, entry.placed.top + y,
+                    entry.image->getPixel(srcX, srcY));
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: atlas_packer <manifest.txt> <atlas.png> <atlas_uv.txt> [width]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string manifestPath = argv[1];
+    const std::string atlasPath = argv[2];
+    const std::string tablePath = argv[3];
+    const unsigned atlasWidth = argc > 4 ? static_cast<unsigned>(std::stoul(argv[4])) : 2048;
+
+    std::ifstream manifest(manifestPath);
+    if (!manifest)
+    {
+        std::cerr << "Failed to open atlas manifest " << manifestPath << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Картинки хранятся отдельно, чтобы кадры одной полосы ссылались на одну копию
+    std::vector<std::unique_ptr<sf::Image>> images;
+    std::vector<SpriteEntry> entries;
+    const std::string baseDir = directoryOf(manifestPath);
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(manifest, line))
+    {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string name, file;
+        int frames = 0;
+        if (!(fields >> name)) continue; // Пустая строка из пробелов
+        if (!(fields >> file))
+        {
+            std::cerr << manifestPath << ":" << lineNumber << ": expected <name> <file> [frames]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        fields >> frames;
+
+        images.emplace_back(new sf::Image());
+        sf::Image& image = *images.back();
+        if (!image.loadFromFile(baseDir + file))
+        {
+            std::cerr << "Failed to load " << baseDir + file << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        sf::Vector2u size = image.getSize();
+        if (frames <= 0)
+        {
+            entries.push_back({ name, &image, sf::IntRect(0, 0, size.x, size.y), sf::IntRect() });
+        }
+        else
+        {
+            int frameWidth = static_cast<int>(size.x) / frames;
+            for (int i = 0; i < frames; ++i)
+            {
+                entries.push_back({ name + std::to_string(i + 1), &image,
+                    sf::IntRect(i * frameWidth, 0, frameWidth, size.y), sf::IntRect() });
+            }
+        }
+    }
+
+    // Полочная упаковка: высокие спрайты первыми, строки слева направо
+    std::vector<SpriteEntry*> order;
+    for (auto& entry : entries) order.push_back(&entry);
+    std::stable_sort(order.begin(), order.end(), [](const SpriteEntry* a, const SpriteEntry* b) {
+        return a->source.height > b->source.height;
+    });
+
+    unsigned shelfX = 0, shelfY = 0, shelfHeight = 0;
+    for (SpriteEntry* entry : order)
+    {
+        unsigned width = entry->source.width + 2 * PADDING;
+        unsigned height = entry->source.height + 2 * PADDING;
+        if (width > atlasWidth)
+        {
+            std::cerr << "Sprite " << entry->name << " is wider than the atlas (" << atlasWidth << ")" << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (shelfX + width > atlasWidth)
+        {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        entry->placed = sf::IntRect(shelfX + PADDING, shelfY + PADDING, entry->source.width, entry->source.height);
+        shelfX += width;
+        shelfHeight = std::max(shelfHeight, height);
+    }
+
+    unsigned atlasHeight = (shelfY + shelfHeight + 3) & ~3u;
+    if (atlasWidth > MAX_ATLAS_SIZE || atlasHeight > MAX_ATLAS_SIZE)
+    {
+        std::cerr << "Warning: atlas " << atlasWidth << "x" << atlasHeight << " exceeds " << MAX_ATLAS_SIZE
+            << " on a side, some GPUs will not load it" << std::endl;
+    }
+
+    sf::Image atlas;
+    atlas.create(atlasWidth, atlasHeight, sf::Color::Transparent);
+    for (const auto& entry : entries)
+    {
+        blitWithBorder(atlas, entry);
+    }
+
+    if (!atlas.saveToFile(atlasPath))
+    {
+        std::cerr << "Failed to save " << atlasPath << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream table(tablePath);
+    table << "# generated by atlas_packer from " << manifestPath << ", do not edit" << std::endl;
+    table << "# <name> <left> <top> <width> <height>" << std::endl;
+    for (const auto& entry : entries)
+    {
+        table << entry.name << " " << entry.placed.left << " " << entry.placed.top << " "
+            << entry.placed.width << " " << entry.placed.height << std::endl;
+    }
+
+    std::cout << "Packed " << entries.size() << " sprites into " << atlasWidth << "x" << atlasHeight << " atlas" << std::endl;
+    return table ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,248 @@
+#include "bigwash_engine.h"
+
+#include <new>
+#include <vector>
+
+#include "board_logic.h"
+
+// Рабочие буферы под один размер доски. Всё выделяется в bw_create,
+// вызовы правил памяти не выделяют и исключений наружу не пускают.
+struct bw_context
+{
+    bw_context(int width, int height, int tileTypes) :
+        width(width),
+        height(height),
+        tileTypes(tileTypes),
+        tileMap(height, std::vector<int>(width, 0)),
+        mask(height, std::vector<bool>(width, false)),
+        classifier(width, height)
+    {
+        scratch.placed.reserve(width * height);
+        scratch.drops.reserve(width * height);
+        scratch.filled.reserve(width * height);
+        moves.reserve(2 * width * height);
+    }
+
+    int width;
+    int height;
+    int tileTypes;
+    std::vector<std::vector<int>> tileMap;
+    std::vector<std::vector<bool>> mask;
+    MatchClassifier classifier;
+    CascadeScratch scratch;
+    std::vector<BoardMove> moves;
+};
+
+namespace
+{
+    const int MIN_BOARD_SIDE = 3;
+    const int MAX_BOARD_SIDE = 64;
+
+    // Только значения, которые может дать игра: пусто, закрытая клетка,
+    // цвет контекста с линией или бомбой и бесцветная цветная бомба.
+    // Иначе, например, цветную бомбу можно было бы поставить в закрытую клетку.
+    bool isValidCell(int32_t value, int tileTypes)
+    {
+        if (value == 0 || value == BLOCKED_TILE) return true;
+        if (value == makeTile(0, SpecialTile::ColorBomb)) return true;
+        if (value < 0 || tileSpecial(value) == SpecialTile::ColorBomb || (value >> SPECIAL_SHIFT) >= SPECIAL_TILE_KINDS)
+        {
+            return false;
+        }
+        return tileColor(value) >= 1 && tileColor(value) <= tileTypes;
+    }
+
+    // Доска вызывающего переносится в рабочую; false — значение вне кодировки
+    bool loadBoard(bw_context& context, const int32_t* cells)
+    {
+        for (int y = 0; y < context.height; ++y)
+        {
+            const int32_t* row = cells + y * context.width;
+            for (int x = 0; x < context.width; ++x)
+            {
+                if (!isValidCell(row[x], context.tileTypes)) return false;
+                context.tileMap[y][x] = row[x];
+            }
+        }
+        return true;
+    }
+
+    void storeBoard(const bw_context& context, int32_t* cells)
+    {
+        for (int y = 0; y < context.height; ++y)
+        {
+            int32_t* row = cells + y * context.width;
+            for (int x = 0; x < context.width; ++x)
+            {
+                row[x] = context.tileMap[y][x];
+            }
+        }
+    }
+
+    int32_t writeMoves(const bw_context& context, bw_move* moves, int32_t capacity)
+    {
+        int32_t count = static_cast<int32_t>(context.moves.size());
+        for (int32_t i = 0; i < count && i < capacity; ++i)
+        {
+            const BoardMove& move = context.moves[i];
+            moves[i] = { move.fromX, move.fromY, move.toX, move.toY };
+        }
+        return count;
+    }
+
+    int32_t resolveOne(bw_context& context, int32_t* cells, const bw_move& move, bw_rng& rng, bw_move_result& result)
+    {
+        if (!loadBoard(context, cells)) return BW_ERROR_BOARD;
+
+        GameRandom random;
+        random.setState(rng.state, rng.increment);
+        BoardMove boardMove = { move.from_x, move.from_y, move.to_x, move.to_y };
+        MoveOutcome outcome = resolveMove(context.tileMap, context.classifier, context.tileTypes, random, boardMove, context.scratch);
+
+        result.legal = outcome.legal ? 1 : 0;
+        result.cleared = outcome.cleared;
+        result.cascade_depth = outcome.cascadeDepth;
+        result.specials_created = outcome.specialsCreated;
+        if (outcome.legal)
+        {
+            storeBoard(context, cells);
+            rng.state = random.getState();
+            rng.increment = random.getIncrement();
+        }
+        return BW_OK;
+    }
+}
+
+int32_t bw_abi_version(void)
+{
+    return BW_ABI_VERSION;
+}
+
+bw_context* bw_create(int32_t width, int32_t height, int32_t tile_types)
+{
+    if (width < MIN_BOARD_SIDE || width > MAX_BOARD_SIDE || height < MIN_BOARD_SIDE || height > MAX_BOARD_SIDE ||
+        tile_types < 3 || tile_types > MAX_TILE_TYPES)
+    {
+        return nullptr;
+    }
+    try
+    {
+        return new bw_context(width, height, tile_types);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void bw_destroy(bw_context* context)
+{
+    delete context;
+}
+
+void bw_rng_seed(bw_rng* rng, uint64_t seed, uint64_t stream)
+{
+    if (!rng) return;
+    GameRandom random;
+    random.seed(seed, stream);
+    rng->state = random.getState();
+    rng->increment = random.getIncrement();
+}
+
+int32_t bw_has_matches(bw_context* context, const int32_t* cells)
+{
+    if (!context || !cells) return BW_ERROR_ARGUMENT;
+    if (!loadBoard(*context, cells)) return BW_ERROR_BOARD;
+    return hasMatches(context->tileMap) ? 1 : 0;
+}
+
+int32_t bw_find_matches(bw_context* context, const int32_t* cells, uint8_t* mask)
+{
+    if (!context || !cells || !mask) return BW_ERROR_ARGUMENT;
+    if (!loadBoard(*context, cells)) return BW_ERROR_BOARD;
+
+    findMatches(context->tileMap, context->mask);
+    int32_t count = 0;
+    for (int y = 0; y < context->height; ++y)
+    {
+        for (int x = 0; x < context->width; ++x)
+        {
+            bool marked = context->mask[y][x];
+            mask[y * context->width + x] = marked ? 1 : 0;
+            count += marked ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+int32_t bw_enumerate_moves(bw_context* context, const int32_t* cells, bw_move* moves, int32_t capacity)
+{
+    if (!context || !cells || (!moves && capacity > 0)) return BW_ERROR_ARGUMENT;
+    if (!loadBoard(*context, cells)) return BW_ERROR_BOARD;
+
+    findPossibleMoves(context->tileMap, context->moves);
+    return writeMoves(*context, moves, capacity);
+}
+
+int32_t bw_apply_gravity(bw_context* context, int32_t* cells)
+{
+    if (!context || !cells) return BW_ERROR_ARGUMENT;
+    if (!loadBoard(*context, cells)) return BW_ERROR_BOARD;
+
+    int32_t dropped = collapseColumns(context->tileMap, context->scratch.drops);
+    storeBoard(*context, cells);
+    return dropped;
+}
+
+int32_t bw_refill(bw_context* context, int32_t* cells, bw_rng* rng)
+{
+    if (!context || !cells || !rng) return BW_ERROR_ARGUMENT;
+    if (!loadBoard(*context, cells)) return BW_ERROR_BOARD;
+
+    GameRandom random;
+    random.setState(rng->state, rng->increment);
+    int32_t filled = refillEmpty(context->tileMap, context->tileTypes, random, context->scratch.filled);
+    storeBoard(*context, cells);
+    rng->state = random.getState();
+    rng->increment = random.getIncrement();
+    return filled;
+}
+
+int32_t bw_resolve_move(bw_context* context, int32_t* cells, const bw_move* move, bw_rng* rng,
+    bw_move_result* result)
+{
+    if (!context || !cells || !move || !rng || !result) return BW_ERROR_ARGUMENT;
+    return resolveOne(*context, cells, *move, *rng, *result);
+}
+
+int32_t bw_resolve_moves_batch(bw_context* context, int32_t* cells, int32_t count,
+    const bw_move* moves, bw_rng* rngs, bw_move_result* results)
+{
+    if (!context || count < 0 || (count > 0 && (!cells || !moves || !rngs || !results))) return BW_ERROR_ARGUMENT;
+
+    const int boardSize = context->width * context->height;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        int32_t status = resolveOne(*context, cells + static_cast<std::size_t>(i) * boardSize, moves[i], rngs[i], results[i]);
+        if (status != BW_OK) return status;
+    }
+    return BW_OK;
+}
+
+int32_t bw_enumerate_moves_batch(bw_context* context, const int32_t* cells, int32_t count,
+    bw_move* moves, int32_t capacity, int32_t* counts)
+{
+    if (!context || count < 0 || capacity < 0 || (count > 0 && (!cells || !counts || (!moves && capacity > 0))))
+    {
+        return BW_ERROR_ARGUMENT;
+    }
+
+    const int boardSize = context->width * context->height;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        if (!loadBoard(*context, cells + static_cast<std::size_t>(i) * boardSize)) return BW_ERROR_BOARD;
+        findPossibleMoves(context->tileMap, context->moves);
+        counts[i] = writeMoves(*context, moves + static_cast<std::size_t>(i) * capacity, capacity);
+    }
+    return BW_OK;
+}
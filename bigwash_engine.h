@@ -0,0 +1,103 @@
+#ifndef BIGWASH_ENGINE_H
+#define BIGWASH_ENGINE_H
+
+/* Правила Big wash как разделяемая библиотека с C ABI: поиск совпадений,
+ * гравитация, досыпание, перечисление ходов и каскад целиком. Это те же
+ * функции board_logic, что вызывает игра.
+ *
+ * Все буферы принадлежат вызывающему. Доска — width * height значений
+ * int32 построчно (ячейка y * width + x), кодировка как в игре: цвет
+ * 1..tile_types в младших четырёх битах, бонус (линия или бомба) — в
+ * следующих, 9 — закрытая клетка, 0 — пустая, 0x40 — цветная бомба без
+ * цвета. Другие значения отвергаются. Пакетные функции берут count досок
+ * подряд в одном буфере, так что один вызов обрабатывает тысячи досок без
+ * промежуточных копий.
+ *
+ * Контекст хранит рабочие буферы под размер доски. Один контекст нельзя
+ * использовать из нескольких потоков одновременно; разные — можно. */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(BIGWASH_ENGINE_BUILD)
+#    define BW_API __declspec(dllexport)
+#  else
+#    define BW_API __declspec(dllimport)
+#  endif
+#else
+#  define BW_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Меняется при несовместимом изменении структур или сигнатур */
+#define BW_ABI_VERSION 1
+
+enum
+{
+    BW_OK = 0,
+    BW_ERROR_ARGUMENT = -1, /* Нулевой указатель или размеры вне диапазона */
+    BW_ERROR_BOARD = -2     /* Значение клетки вне кодировки или цвет больше tile_types */
+};
+
+typedef struct bw_context bw_context;
+
+/* Генератор новых тайлов (PCG32), по одному на доску. Те же state и
+ * increment, что пишет сохранение игры. */
+typedef struct bw_rng
+{
+    uint64_t state;
+    uint64_t increment;
+} bw_rng;
+
+typedef struct bw_move
+{
+    int32_t from_x, from_y;
+    int32_t to_x, to_y;
+} bw_move;
+
+typedef struct bw_move_result
+{
+    int32_t legal;            /* 0 — ход откатан, доска не изменилась */
+    int32_t cleared;          /* Удалено клеток за каскад */
+    int32_t cascade_depth;    /* Шагов удаления */
+    int32_t specials_created;
+} bw_move_result;
+
+BW_API int32_t bw_abi_version(void);
+
+/* NULL, если размеры вне 3..64 или типов тайлов не 3..8 */
+BW_API bw_context* bw_create(int32_t width, int32_t height, int32_t tile_types);
+BW_API void bw_destroy(bw_context* context);
+
+BW_API void bw_rng_seed(bw_rng* rng, uint64_t seed, uint64_t stream);
+
+/* 1 — есть готовая тройка, 0 — нет, <0 — ошибка */
+BW_API int32_t bw_has_matches(bw_context* context, const int32_t* cells);
+/* mask[i] = 1 для клеток линий от трёх; возвращает их число */
+BW_API int32_t bw_find_matches(bw_context* context, const int32_t* cells, uint8_t* mask);
+/* Пишет до capacity легальных ходов, возвращает их полное число */
+BW_API int32_t bw_enumerate_moves(bw_context* context, const int32_t* cells, bw_move* moves, int32_t capacity);
+/* Гравитация на месте; возвращает число упавших тайлов */
+BW_API int32_t bw_apply_gravity(bw_context* context, int32_t* cells);
+/* Заполняет пустые клетки; возвращает их число */
+BW_API int32_t bw_refill(bw_context* context, int32_t* cells, bw_rng* rng);
+/* Ход до устойчивой доски, как в игре. Нелегальный ход — BW_OK и legal = 0. */
+BW_API int32_t bw_resolve_move(bw_context* context, int32_t* cells, const bw_move* move, bw_rng* rng,
+    bw_move_result* result);
+
+/* Пакеты: доска i лежит в cells + i * width * height, ей соответствуют
+ * moves[i], rngs[i] и results[i]. */
+BW_API int32_t bw_resolve_moves_batch(bw_context* context, int32_t* cells, int32_t count,
+    const bw_move* moves, bw_rng* rngs, bw_move_result* results);
+/* Для доски i ходы пишутся в moves + i * capacity, полное число — в counts[i] */
+BW_API int32_t bw_enumerate_moves_batch(bw_context* context, const int32_t* cells, int32_t count,
+    bw_move* moves, int32_t capacity, int32_t* counts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
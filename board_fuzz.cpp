@@ -0,0 +1,253 @@
+// Дифференциальная проверка ядер доски: быстрые версии из board_logic
+// против эталонных из board_reference на случайных досках. Формы, закрытые
+// клетки, бонусы, пустоты и зерно досыпания берутся из входных байт.
+// Любое расхождение в маске совпадений, результате падения, досыпании или
+// наборе легальных ходов печатает доску и роняет процесс.
+//
+// Собирается двумя способами (см. BIGWASH_BUILD_FUZZ в CMakeLists.txt):
+// с clang — как цель libFuzzer (BIGWASH_LIBFUZZER), иначе — как
+// самостоятельная программа со своим генератором входов:
+//
+//   board_fuzz [--cases N] [--seconds N] [--seed N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "board_logic.h"
+#include "board_reference.h"
+
+namespace
+{
+    const int MIN_SIDE = 1;
+    const int MAX_SIDE = 12;
+    const std::size_t HEADER_BYTES = 7; // Ширина, высота, число типов, зерно
+
+    // Буферы живут между случаями: цель libFuzzer вызывается миллионы раз
+    struct FuzzBoards
+    {
+        std::vector<std::vector<int>> original;
+        std::vector<std::vector<int>> fast;
+        std::vector<std::vector<int>> reference;
+        std::vector<std::vector<bool>> fastMask;
+        std::vector<std::vector<bool>> referenceMask;
+        std::vector<BoardMove> fastMoves;
+        std::vector<BoardMove> referenceMoves;
+        std::vector<TileDrop> fastDrops;
+        std::vector<TileDrop> referenceDrops;
+        std::vector<int> fastFilled;
+        std::vector<int> referenceFilled;
+    };
+
+    FuzzBoards boards;
+
+    std::uint8_t byteAt(const std::uint8_t* data, std::size_t size, std::size_t index)
+    {
+        return index < size ? data[index] : 0;
+    }
+
+    // Байт клетки в значение: закрытые, пустые, обычные, полосы, бомбы и цветные бомбы
+    int decodeCell(std::uint8_t byte, int tileTypes)
+    {
+        int kind = byte & 0x7;
+        int color = 1 + (byte >> 3) % tileTypes;
+        switch (kind)
+        {
+        case 0: return BLOCKED_TILE;
+        case 1: return 0;
+        case 5: return makeTile(color, static_cast<SpecialTile>(1 + (byte >> 6) % 3));
+        case 6: return (byte & 0xC0) == 0xC0 ? makeTile(0, SpecialTile::ColorBomb) : color;
+        default: return color;
+        }
+    }
+
+    void resize(std::vector<std::vector<int>>& board, int width, int height)
+    {
+        board.resize(height);
+        for (std::vector<int>& row : board) row.assign(width, 0);
+    }
+
+    void resizeMask(std::vector<std::vector<bool>>& mask, int width, int height)
+    {
+        mask.resize(height);
+        for (std::vector<bool>& row : mask) row.assign(width, false);
+    }
+
+    [[noreturn]] void fail(const char* kernel)
+    {
+        std::cerr << "Mismatch in " << kernel << " on board:" << std::endl;
+        for (const std::vector<int>& row : boards.original)
+        {
+            for (int value : row) std::cerr << ' ' << value;
+            std::cerr << std::endl;
+        }
+        std::abort();
+    }
+
+    bool sameMoves(const std::vector<BoardMove>& first, const std::vector<BoardMove>& second)
+    {
+        return std::equal(first.begin(), first.end(), second.begin(), second.end(),
+            [](const BoardMove& a, const BoardMove& b)
+            {
+                return a.fromX == b.fromX && a.fromY == b.fromY && a.toX == b.toX && a.toY == b.toY;
+            });
+    }
+
+    bool sameDrops(const std::vector<TileDrop>& first, const std::vector<TileDrop>& second)
+    {
+        return std::equal(first.begin(), first.end(), second.begin(), second.end(),
+            [](const TileDrop& a, const TileDrop& b)
+            {
+                return a.x == b.x && a.fromY == b.fromY && a.toY == b.toY;
+            });
+    }
+
+    // Перекрашивает клетки, замыкающие тройку слева или сверху: получается
+    // устоявшаяся доска, на которой ходы ищутся быстрым путём
+    void breakMatches(std::vector<std::vector<int>>& board, int tileTypes)
+    {
+        int height = static_cast<int>(board.size());
+        int width = static_cast<int>(board[0].size());
+        auto closesLine = [&board](int x, int y)
+        {
+            int color = tileColor(board[y][x]);
+            return (x >= 2 && tileColor(board[y][x - 1]) == color && tileColor(board[y][x - 2]) == color) ||
+                (y >= 2 && tileColor(board[y - 1][x]) == color && tileColor(board[y - 2][x]) == color);
+        };
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                int& value = board[y][x];
+                if (!isMatchable(value)) continue;
+                // Два запрета исключают не больше двух цветов из трёх и более
+                while (closesLine(x, y))
+                {
+                    value = (value & ~TILE_COLOR_MASK) | (tileColor(value) % tileTypes + 1);
+                }
+            }
+        }
+    }
+
+    void compareMoves(const char* kernel)
+    {
+        boards.fast = boards.original;
+        boards.reference = boards.original;
+        findPossibleMoves(boards.fast, boards.fastMoves);
+        referenceFindPossibleMoves(boards.reference, boards.referenceMoves);
+        if (!sameMoves(boards.fastMoves, boards.referenceMoves)) fail(kernel);
+        if (hasPossibleMove(boards.fast) == boards.referenceMoves.empty()) fail("hasPossibleMove");
+        if (boards.fast != boards.original || boards.reference != boards.original) fail("move search left the board changed");
+    }
+
+    void runCase(const std::uint8_t* data, std::size_t size)
+    {
+        int width = MIN_SIDE + byteAt(data, size, 0) % (MAX_SIDE - MIN_SIDE + 1);
+        int height = MIN_SIDE + byteAt(data, size, 1) % (MAX_SIDE - MIN_SIDE + 1);
+        int tileTypes = 3 + byteAt(data, size, 2) % (MAX_TILE_TYPES - 2);
+        std::uint32_t seed = 0;
+        for (int i = 0; i < 4; ++i) seed |= static_cast<std::uint32_t>(byteAt(data, size, 3 + i)) << (8 * i);
+
+        resize(boards.original, width, height);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                boards.original[y][x] = decodeCell(byteAt(data, size, HEADER_BYTES + y * width + x), tileTypes);
+            }
+        }
+
+        // Совпадения и легальные ходы — на исходной доске, она может быть неустоявшейся
+        resizeMask(boards.fastMask, width, height);
+        resizeMask(boards.referenceMask, width, height);
+        findMatches(boards.original, boards.fastMask);
+        referenceFindMatches(boards.original, boards.referenceMask);
+        if (boards.fastMask != boards.referenceMask) fail("findMatches");
+
+        bool anyMarked = std::any_of(boards.referenceMask.begin(), boards.referenceMask.end(),
+            [](const std::vector<bool>& row) { return std::find(row.begin(), row.end(), true) != row.end(); });
+        if (hasMatches(boards.original) != anyMarked) fail("hasMatches");
+
+        compareMoves("findPossibleMoves");
+
+        // Падение и досыпание — после удаления найденных совпадений
+        clearMarked(boards.fast, boards.referenceMask);
+        clearMarked(boards.reference, boards.referenceMask);
+        collapseColumns(boards.fast, boards.fastDrops);
+        referenceCollapseColumns(boards.reference, boards.referenceDrops);
+        if (boards.fast != boards.reference || !sameDrops(boards.fastDrops, boards.referenceDrops)) fail("collapseColumns");
+
+        GameRandom fastRandom(seed);
+        GameRandom referenceRandom(seed);
+        refillEmpty(boards.fast, tileTypes, fastRandom, boards.fastFilled);
+        referenceRefillEmpty(boards.reference, tileTypes, referenceRandom, boards.referenceFilled);
+        if (boards.fast != boards.reference || boards.fastFilled != boards.referenceFilled ||
+            fastRandom.getState() != referenceRandom.getState())
+        {
+            fail("refillEmpty");
+        }
+
+        // Та же доска без готовых совпадений
+        breakMatches(boards.original, tileTypes);
+        if (hasMatches(boards.original)) fail("breakMatches");
+        compareMoves("findPossibleMoves on a settled board");
+    }
+}
+
+#ifdef BIGWASH_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    runCase(data, size);
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    long long cases = 0; // 0 — ограничение только по времени
+    int seconds = 60;
+    std::uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--cases" && hasValue) cases = std::max(0LL, std::atoll(argv[++i]));
+        else if (arg == "--seconds" && hasValue) seconds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            std::cerr << "Usage: board_fuzz [--cases N] [--seconds N] [--seed N]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Входы того же вида, что у libFuzzer: заголовок и байт на клетку
+    GameRandom random(seed);
+    std::vector<std::uint8_t> input(HEADER_BYTES + MAX_SIDE * MAX_SIDE);
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::seconds(seconds);
+    long long done = 0;
+    while (cases == 0 || done < cases)
+    {
+        for (std::uint8_t& byte : input) byte = static_cast<std::uint8_t>(random.next());
+        runCase(input.data(), input.size());
+        ++done;
+
+        if ((done & 0xFFF) == 0 && std::chrono::steady_clock::now() >= deadline) break;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << done << " cases, no mismatches, " << static_cast<long long>(done / elapsed * 60.0)
+        << " cases/minute" << std::endl;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#include "board_input.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+    // Доля клетки, после которой перетаскивание считается свайпом
+    const float SWIPE_FRACTION = 0.3f;
+
+    bool isAdjacent(sf::Vector2i a, sf::Vector2i b)
+    {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y) == 1;
+    }
+}
+
+BoardInput::BoardInput(const BoardShape& shape, sf::Vector2f origin, float cellSize, InputQueue& queue) :
+    shape(shape),
+    origin(origin),
+    inverseCellSize(1.0f / cellSize),
+    swipeThreshold(cellSize * SWIPE_FRACTION),
+    queue(queue)
+{
+}
+
+void BoardInput::setShape(const BoardShape& newShape)
+{
+    shape = newShape;
+    cancel();
+}
+
+void BoardInput::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
+{
+    switch (event.type)
+    {
+    case sf::Event::MouseButtonPressed:
+        if (event.mouseButton.button == sf::Mouse::Left && !touchActive)
+            press(window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y)));
+        break;
+    case sf::Event::MouseMoved:
+        if (!touchActive)
+            move(window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y)));
+        break;
+    case sf::Event::MouseButtonReleased:
+        if (event.mouseButton.button == sf::Mouse::Left && !touchActive)
+            release(window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y)));
+        break;
+    case sf::Event::TouchBegan:
+        if (event.touch.finger == 0)
+        {
+            touchActive = true;
+            press(window.mapPixelToCoords(sf::Vector2i(event.touch.x, event.touch.y)));
+        }
+        break;
+    case sf::Event::TouchMoved:
+        if (event.touch.finger == 0)
+            move(window.mapPixelToCoords(sf::Vector2i(event.touch.x, event.touch.y)));
+        break;
+    case sf::Event::TouchEnded:
+        if (event.touch.finger == 0)
+        {
+            release(window.mapPixelToCoords(sf::Vector2i(event.touch.x, event.touch.y)));
+            touchActive = false;
+        }
+        break;
+    case sf::Event::LostFocus:
+        cancel();
+        break;
+    default:
+        break;
+    }
+}
+
+sf::Vector2i BoardInput::cellAt(sf::Vector2f point) const
+{
+    // floor, а не приведение к int: точка левее доски не должна попасть в столбец 0
+    int x = static_cast<int>(std::floor((point.x - origin.x) * inverseCellSize));
+    int y = static_cast<int>(std::floor((point.y - origin.y) * inverseCellSize));
+    return shape.isPlayable(x, y) ? sf::Vector2i(x, y) : sf::Vector2i(-1, -1);
+}
+
+void BoardInput::press(sf::Vector2f point)
+{
+    sf::Vector2i cell = cellAt(point);
+    if (cell.x == -1)
+    {
+        deselect();
+        pressed = false;
+        return;
+    }
+
+    // Второе касание по соседней клетке — обмен без свайпа
+    if (selected.x != -1 && isAdjacent(selected, cell))
+    {
+        swap(selected, cell);
+        pressed = false;
+        return;
+    }
+
+    select(cell);
+    pressPoint = point;
+    pressed = true;
+    swiped = false;
+}
+
+void BoardInput::move(sf::Vector2f point)
+{
+    if (!pressed || swiped || selected.x == -1) return;
+
+    sf::Vector2f delta = point - pressPoint;
+    if (std::abs(delta.x) < swipeThreshold && std::abs(delta.y) < swipeThreshold) return;
+
+    // Направление свайпа — по преобладающей оси
+    sf::Vector2i target = selected;
+    if (std::abs(delta.x) >= std::abs(delta.y))
+        target.x += delta.x > 0 ? 1 : -1;
+    else
+        target.y += delta.y > 0 ? 1 : -1;
+
+    swiped = true;
+    if (shape.isPlayable(target.x, target.y))
+    {
+        swap(selected, target);
+    }
+    else
+    {
+        deselect();
+    }
+}
+
+void BoardInput::release(sf::Vector2f point)
+{
+    if (!pressed) return;
+    pressed = false;
+
+    if (swiped || selected.x == -1) return;
+
+    // Быстрое перетаскивание могло не дать ни одного события движения
+    sf::Vector2i cell = cellAt(point);
+    if (cell.x != -1 && isAdjacent(selected, cell))
+    {
+        swap(selected, cell);
+    }
+    // Иначе выделение остаётся до второго касания
+}
+
+void BoardInput::cancel()
+{
+    pressed = false;
+    touchActive = false;
+    deselect();
+}
+
+void BoardInput::select(sf::Vector2i cell)
+{
+    selected = cell;
+    push({ InputEvent::Type::Select, cell.x, cell.y });
+}
+
+void BoardInput::deselect()
+{
+    if (selected.x == -1) return;
+
+    selected = { -1, -1 };
+    push({ InputEvent::Type::Deselect });
+}
+
+void BoardInput::swap(sf::Vector2i from, sf::Vector2i to)
+{
+    selected = { -1, -1 };
+    push({ InputEvent::Type::Swap, from.x, from.y, to.x, to.y });
+}
+
+void BoardInput::push(const InputEvent& event)
+{
+    InputEvent tagged = event;
+    tagged.tag = tag;
+    if (!queue.push(tagged))
+    {
+        std::cerr << "Input queue overflow, event dropped" << std::endl;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+#include "board_shape.h"
+#include "spsc_queue.h"
+
+// Намерение игрока, которое слой ввода отдаёт симуляции. Координаты уже
+// переведены в клетки доски, пиксели до симуляции не доходят.
+struct InputEvent
+{
+    enum class Type
+    {
+        Select,   // Выделить клетку (x, y)
+        Deselect, // Снять выделение
+        Swap,     // Поменять (x, y) с соседней (targetX, targetY)
+        Restart
+    };
+
+    Type type;
+    int x = -1, y = -1;
+    int targetX = -1, targetY = -1;
+    std::uint32_t tag = 0; // Метка замера задержки, 0 — без замера
+};
+
+typedef SpscQueue<InputEvent, 64> InputQueue;
+
+// Слой ввода потока отрисовки. Точка переводится в клетку одним аффинным
+// преобразованием и проверкой маски формы доски, поэтому задержка ввода не
+// зависит от размера поля. Поддерживаются нажатие-и-свайп, два касания
+// подряд по соседним клеткам и сенсорный экран (первый палец).
+class BoardInput
+{
+public:
+    BoardInput(const BoardShape& shape, sf::Vector2f origin, float cellSize, InputQueue& queue);
+
+    // Мышь (левая кнопка) и касания. Пиксели переводятся через вид окна.
+    void handleEvent(const sf::Event& event, const sf::RenderWindow& window);
+
+    void press(sf::Vector2f point);
+    void move(sf::Vector2f point);
+    void release(sf::Vector2f point);
+    // Жест прерван (например, окно потеряло фокус)
+    void cancel();
+
+    // Игровая клетка под точкой или (-1, -1)
+    sf::Vector2i cellAt(sf::Vector2f point) const;
+
+    // Форма поля сменилась (другой уровень); начатый жест сбрасывается
+    void setShape(const BoardShape& newShape);
+    // Метка для намерений из следующих событий, 0 — снять
+    void setTag(std::uint32_t newTag) { tag = newTag; }
+
+private:
+    void select(sf::Vector2i cell);
+    void deselect();
+    void swap(sf::Vector2i from, sf::Vector2i to);
+    void push(const InputEvent& event);
+
+    BoardShape shape; // Своя копия: симуляция может менять уровень в своём потоке
+    sf::Vector2f origin;
+    float inverseCellSize;
+    float swipeThreshold; // Минимальная длина свайпа в единицах вида
+    InputQueue& queue;
+
+    sf::Vector2i selected = { -1, -1 };
+    sf::Vector2f pressPoint;
+    bool pressed = false;
+    bool swiped = false;
+    bool touchActive = false; // Пока палец на экране, эмуляция мыши игнорируется
+    std::uint32_t tag = 0;
+};
@@ -0,0 +1,378 @@
+#include "board_logic.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+bool hasMatches(const std::vector<std::vector<int>>& tileMap)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+
+    // Оптимизированная проверка без полного поиска
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width - 2; x++)
+        {
+            if (tileColor(tileMap[y][x]) == tileColor(tileMap[y][x + 1]) &&
+                tileColor(tileMap[y][x]) == tileColor(tileMap[y][x + 2]) &&
+                isMatchable(tileMap[y][x])) return true;
+        }
+    }
+
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height - 2; y++)
+        {
+            if (tileColor(tileMap[y][x]) == tileColor(tileMap[y + 1][x]) &&
+                tileColor(tileMap[y][x]) == tileColor(tileMap[y + 2][x]) &&
+                isMatchable(tileMap[y][x])) return true;
+        }
+    }
+    return false;
+}
+
+void findMatches(const std::vector<std::vector<int>>& tileMap, std::vector<std::vector<bool>>& mask)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    for (auto& row : mask) std::fill(row.begin(), row.end(), false);
+
+    // Один проход по сериям одного цвета: серия от трёх клеток — совпадение.
+    // Все клетки серии одного цвета, поэтому сопоставимы они все или ни одна.
+    for (int y = 0; y < height; ++y)
+    {
+        const std::vector<int>& row = tileMap[y];
+        int start = 0;
+        for (int x = 1; x <= width; ++x)
+        {
+            if (x < width && tileColor(row[x]) == tileColor(row[start])) continue;
+            if (x - start >= 3 && isMatchable(row[start]))
+            {
+                std::fill(mask[y].begin() + start, mask[y].begin() + x, true);
+            }
+            start = x;
+        }
+    }
+
+    for (int x = 0; x < width; ++x)
+    {
+        int start = 0;
+        for (int y = 1; y <= height; ++y)
+        {
+            if (y < height && tileColor(tileMap[y][x]) == tileColor(tileMap[start][x])) continue;
+            if (y - start >= 3 && isMatchable(tileMap[start][x]))
+            {
+                for (int i = start; i < y; ++i) mask[i][x] = true;
+            }
+            start = y;
+        }
+    }
+}
+
+bool isColorBombSwap(int first, int second)
+{
+    return (tileSpecial(first) == SpecialTile::ColorBomb && second != 0 && second != BLOCKED_TILE) ||
+        (tileSpecial(second) == SpecialTile::ColorBomb && first != 0 && first != BLOCKED_TILE);
+}
+
+bool isLegalMove(std::vector<std::vector<int>>& tileMap, const BoardMove& move)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    if (move.fromX < 0 || move.fromX >= width || move.fromY < 0 || move.fromY >= height ||
+        move.toX < 0 || move.toX >= width || move.toY < 0 || move.toY >= height ||
+        std::abs(move.toX - move.fromX) + std::abs(move.toY - move.fromY) != 1)
+    {
+        return false;
+    }
+
+    int& first = tileMap[move.fromY][move.fromX];
+    int& second = tileMap[move.toY][move.toX];
+    if (first == BLOCKED_TILE || second == BLOCKED_TILE) return false;
+
+    std::swap(first, second);
+    bool legal = isColorBombSwap(first, second) || hasMatches(tileMap);
+    std::swap(first, second);
+    return legal;
+}
+
+namespace
+{
+    // Есть ли линия от трёх клеток через (x, y)
+    bool matchesThrough(const std::vector<std::vector<int>>& tileMap, int x, int y)
+    {
+        int value = tileMap[y][x];
+        if (!isMatchable(value)) return false;
+        int color = tileColor(value);
+        int height = static_cast<int>(tileMap.size());
+        int width = static_cast<int>(tileMap[0].size());
+
+        int left = x;
+        while (left > 0 && tileColor(tileMap[y][left - 1]) == color) --left;
+        int right = x;
+        while (right + 1 < width && tileColor(tileMap[y][right + 1]) == color) ++right;
+        if (right - left >= 2) return true;
+
+        int top = y;
+        while (top > 0 && tileColor(tileMap[top - 1][x]) == color) --top;
+        int bottom = y;
+        while (bottom + 1 < height && tileColor(tileMap[bottom + 1][x]) == color) ++bottom;
+        return bottom - top >= 2;
+    }
+
+    // isLegalMove для доски без готовых совпадений: после обмена новая
+    // линия может пройти только через одну из двух клеток обмена
+    bool isLegalOnSettledBoard(std::vector<std::vector<int>>& tileMap, const BoardMove& move)
+    {
+        int& first = tileMap[move.fromY][move.fromX];
+        int& second = tileMap[move.toY][move.toX];
+        if (first == BLOCKED_TILE || second == BLOCKED_TILE) return false;
+
+        std::swap(first, second);
+        bool legal = isColorBombSwap(first, second) ||
+            matchesThrough(tileMap, move.fromX, move.fromY) ||
+            matchesThrough(tileMap, move.toX, move.toY);
+        std::swap(first, second);
+        return legal;
+    }
+
+    // Обходит обмены в порядке findPossibleMoves; visit возвращает false, чтобы остановиться
+    template <typename Visitor>
+    void forEachLegalMove(std::vector<std::vector<int>>& tileMap, Visitor visit)
+    {
+        int height = static_cast<int>(tileMap.size());
+        int width = static_cast<int>(tileMap[0].size());
+        // На доске с готовым совпадением легален любой обмен, который его
+        // не разрушил; такие доски проверяются полным поиском
+        bool settled = !hasMatches(tileMap);
+        auto legal = [&](const BoardMove& move)
+        {
+            return settled ? isLegalOnSettledBoard(tileMap, move) : isLegalMove(tileMap, move);
+        };
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width - 1; x++)
+            {
+                BoardMove move = { x, y, x + 1, y };
+                if (legal(move) && !visit(move)) return;
+            }
+        }
+
+        for (int x = 0; x < width; x++)
+        {
+            for (int y = 0; y < height - 1; y++)
+            {
+                BoardMove move = { x, y, x, y + 1 };
+                if (legal(move) && !visit(move)) return;
+            }
+        }
+    }
+}
+
+void findPossibleMoves(std::vector<std::vector<int>>& tileMap, std::vector<BoardMove>& moves)
+{
+    moves.clear();
+    forEachLegalMove(tileMap, [&moves](const BoardMove& move)
+    {
+        moves.push_back(move);
+        return true;
+    });
+}
+
+bool hasPossibleMove(std::vector<std::vector<int>>& tileMap)
+{
+    bool found = false;
+    forEachLegalMove(tileMap, [&found](const BoardMove&)
+    {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+void placeSpecials(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int colorBombTarget,
+    std::vector<PlacedSpecial>& placed)
+{
+    placed.clear();
+    classifier.detonate(tileMap, colorBombTarget);
+
+    for (int i = 0; i < classifier.getGroupCount(); ++i)
+    {
+        const MatchGroup& group = classifier.getGroup(i);
+        SpecialTile special = specialForShape(group.shape, group.horizontal);
+        int& pivotValue = tileMap[group.pivotY][group.pivotX];
+        if (special == SpecialTile::None || tileSpecial(pivotValue) != SpecialTile::None)
+        {
+            continue; // Бонус в опорной клетке уже сработал в этой маске
+        }
+
+        pivotValue = makeTile(special == SpecialTile::ColorBomb ? 0 : group.color, special);
+        classifier.keepCell(group.pivotX, group.pivotY);
+        placed.push_back({ group.pivotX, group.pivotY, special });
+    }
+}
+
+int clearMarked(std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& mask)
+{
+    int cleared = 0;
+    for (std::size_t y = 0; y < tileMap.size(); ++y)
+    {
+        for (std::size_t x = 0; x < tileMap[y].size(); ++x)
+        {
+            if (mask[y][x])
+            {
+                tileMap[y][x] = 0;
+                cleared++;
+            }
+        }
+    }
+    return cleared;
+}
+
+int collapseColumns(std::vector<std::vector<int>>& tileMap, std::vector<TileDrop>& drops)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    drops.clear();
+
+    for (int x = 0; x < width; ++x)
+    {
+        int writeY = height - 1;
+        for (int y = height - 1; y >= 0; --y)
+        {
+            if (tileMap[y][x] == BLOCKED_TILE)
+            {
+                writeY = y - 1; // Закрытая клетка — дно для тайлов над ней
+            }
+            else if (tileMap[y][x] != 0)
+            {
+                if (writeY != y)
+                {
+                    tileMap[writeY][x] = tileMap[y][x];
+                    tileMap[y][x] = 0;
+                    drops.push_back({ x, y, writeY });
+                }
+                writeY--;
+            }
+        }
+    }
+    return static_cast<int>(drops.size());
+}
+
+int refillEmpty(std::vector<std::vector<int>>& tileMap, int tileTypeCount, GameRandom& random, std::vector<int>& filled)
+{
+    return refillEmpty(tileMap, SpawnPolicy(tileTypeCount), random, filled);
+}
+
+int refillEmpty(std::vector<std::vector<int>>& tileMap, const SpawnPolicy& spawn, GameRandom& random, std::vector<int>& filled)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    filled.clear();
+
+    // Закрытые клетки хранят BLOCKED_TILE, поэтому пустая клетка всегда игровая
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            if (tileMap[y][x] == 0)
+            {
+                tileMap[y][x] = spawn.draw(tileMap, x, y, random);
+                filled.push_back(y * width + x);
+            }
+        }
+    }
+    return static_cast<int>(filled.size());
+}
+
+namespace
+{
+    // Шаги удаления, пока на доске есть совпадения. Первый шаг уже
+    // размечен в классификаторе.
+    void runCascade(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, const SpawnPolicy& spawn,
+        GameRandom& random, int colorBombTarget, CascadeScratch& scratch, GameStats* stats, MoveOutcome& outcome)
+    {
+        while (true)
+        {
+            placeSpecials(tileMap, classifier, colorBombTarget, scratch.placed);
+            outcome.specialsCreated += static_cast<int>(scratch.placed.size());
+            outcome.cascadeDepth++;
+            if (stats)
+            {
+                for (const PlacedSpecial& placed : scratch.placed) stats->recordSpecialCreated(placed.special);
+                stats->recordClears(tileMap, classifier.getClearMask());
+                stats->recordCascadeStep(outcome.cascadeDepth);
+            }
+            outcome.cleared += clearMarked(tileMap, classifier.getClearMask());
+
+            collapseColumns(tileMap, scratch.drops);
+            refillEmpty(tileMap, spawn, random, scratch.filled);
+
+            if (!hasMatches(tileMap)) break;
+            classifier.classify(tileMap);
+            colorBombTarget = 0;
+        }
+        if (stats) stats->recordCascade(outcome.cascadeDepth);
+    }
+}
+
+MoveOutcome resolveMove(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int tileTypeCount,
+    GameRandom& random, const BoardMove& move, CascadeScratch& scratch, GameStats* stats)
+{
+    return resolveMove(tileMap, classifier, SpawnPolicy(tileTypeCount), random, move, scratch, stats);
+}
+
+MoveOutcome resolveMove(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, const SpawnPolicy& spawn,
+    GameRandom& random, const BoardMove& move, CascadeScratch& scratch, GameStats* stats)
+{
+    MoveOutcome outcome;
+    if (!isLegalMove(tileMap, move)) return outcome;
+    outcome.legal = true;
+
+    std::swap(tileMap[move.fromY][move.fromX], tileMap[move.toY][move.toX]);
+    int first = tileMap[move.fromY][move.fromX];
+    int second = tileMap[move.toY][move.toX];
+
+    // Первый шаг: цветная бомба или совпадения с опорой в клетках обмена
+    int colorBombTarget = 0;
+    if (isColorBombSwap(first, second))
+    {
+        classifier.clearAll();
+        if (tileSpecial(first) == SpecialTile::ColorBomb)
+        {
+            classifier.markCell(move.fromX, move.fromY);
+            colorBombTarget = tileColor(second);
+        }
+        if (tileSpecial(second) == SpecialTile::ColorBomb)
+        {
+            classifier.markCell(move.toX, move.toY);
+            colorBombTarget = tileColor(first);
+        }
+    }
+    else
+    {
+        classifier.classify(tileMap, move.fromX, move.fromY, move.toX, move.toY);
+    }
+
+    runCascade(tileMap, classifier, spawn, random, colorBombTarget, scratch, stats, outcome);
+    return outcome;
+}
+
+MoveOutcome settleBoard(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int tileTypeCount,
+    GameRandom& random, CascadeScratch& scratch, GameStats* stats)
+{
+    return settleBoard(tileMap, classifier, SpawnPolicy(tileTypeCount), random, scratch, stats);
+}
+
+MoveOutcome settleBoard(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, const SpawnPolicy& spawn,
+    GameRandom& random, CascadeScratch& scratch, GameStats* stats)
+{
+    MoveOutcome outcome;
+    if (!hasMatches(tileMap)) return outcome;
+    outcome.legal = true;
+
+    classifier.classify(tileMap);
+    runCascade(tileMap, classifier, spawn, random, 0, scratch, stats, outcome);
+    return outcome;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "game_random.h"
+#include "game_stats.h"
+#include "match_classifier.h"
+#include "spawn_policy.h"
+
+// Правила доски без графики и без SFML. Их вызывает и машина состояний
+// игры, и библиотека движка bigwash_engine, поэтому у инструментов те же
+// правила, что в игре. Доска — tileMap[y][x] со значениями из tile_value.h:
+// пустая клетка 0, закрытая — BLOCKED_TILE.
+
+// Обмен двух соседних клеток
+struct BoardMove
+{
+    int fromX, fromY;
+    int toX, toY;
+};
+
+// Тайл, упавший при гравитации, в порядке обработки (снизу вверх по столбцам)
+struct TileDrop
+{
+    int x;
+    int fromY;
+    int toY;
+};
+
+// Бонус, оставленный группой в опорной клетке
+struct PlacedSpecial
+{
+    int x;
+    int y;
+    SpecialTile special;
+};
+
+// Буферы каскада; выделяются при первом ходе и дальше переиспользуются
+struct CascadeScratch
+{
+    std::vector<PlacedSpecial> placed;
+    std::vector<TileDrop> drops;
+    std::vector<int> filled; // y * ширина + x
+
+    // Под доску из cells клеток: дальше шаги каскада память не выделяют
+    void reserve(std::size_t cells)
+    {
+        placed.reserve(cells);
+        drops.reserve(cells);
+        filled.reserve(cells);
+    }
+};
+
+// Итог хода, доведённого до устойчивой доски
+struct MoveOutcome
+{
+    bool legal = false;      // Нелегальный ход откатывается, доска не меняется
+    int cleared = 0;         // Удалено клеток за весь каскад
+    int cascadeDepth = 0;    // Шагов удаления
+    int specialsCreated = 0;
+};
+
+bool hasMatches(const std::vector<std::vector<int>>& tileMap);
+// Маска всех линий от трёх клеток; mask должна быть размером с доску
+void findMatches(const std::vector<std::vector<int>>& tileMap, std::vector<std::vector<bool>>& mask);
+
+// Обмен цветной бомбы с любым тайлом — всегда ход
+bool isColorBombSwap(int first, int second);
+// Обмен соседних игровых клеток, после которого есть совпадение или
+// срабатывает цветная бомба. Доска пробно меняется и возвращается.
+bool isLegalMove(std::vector<std::vector<int>>& tileMap, const BoardMove& move);
+// Все легальные ходы: сначала горизонтальные по строкам, потом вертикальные по столбцам
+void findPossibleMoves(std::vector<std::vector<int>>& tileMap, std::vector<BoardMove>& moves);
+// Есть ли хоть один ход; останавливается на первом найденном
+bool hasPossibleMove(std::vector<std::vector<int>>& tileMap);
+
+// Шаг удаления после classify() или markCell(): бонусы под ударом
+// срабатывают цепочкой, группы особой формы оставляют бонус в опорной
+// клетке. Клетки маски ещё не очищены.
+void placeSpecials(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int colorBombTarget,
+    std::vector<PlacedSpecial>& placed);
+// Очищает клетки маски, возвращает их число
+int clearMarked(std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& mask);
+// Тайлы падают до дна или до закрытой клетки; возвращает число упавших
+int collapseColumns(std::vector<std::vector<int>>& tileMap, std::vector<TileDrop>& drops);
+// Пустые клетки заполняются по столбцам сверху вниз; возвращает их число.
+// Без правил досыпания цвета равновероятны.
+int refillEmpty(std::vector<std::vector<int>>& tileMap, int tileTypeCount, GameRandom& random, std::vector<int>& filled);
+int refillEmpty(std::vector<std::vector<int>>& tileMap, const SpawnPolicy& spawn, GameRandom& random, std::vector<int>& filled);
+
+// Ход целиком, в том же порядке, что машина состояний игры: обмен,
+// удаление с бонусами, падение, досыпание, пока есть совпадения.
+// stats, если задан, считает удаления, бонусы и каскад так же, как в игре.
+MoveOutcome resolveMove(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int tileTypeCount,
+    GameRandom& random, const BoardMove& move, CascadeScratch& scratch, GameStats* stats = nullptr);
+MoveOutcome resolveMove(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, const SpawnPolicy& spawn,
+    GameRandom& random, const BoardMove& move, CascadeScratch& scratch, GameStats* stats = nullptr);
+// Снять готовые совпадения (например, после начального заполнения);
+// legal в итоге — были ли совпадения
+MoveOutcome settleBoard(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, int tileTypeCount,
+    GameRandom& random, CascadeScratch& scratch, GameStats* stats = nullptr);
+MoveOutcome settleBoard(std::vector<std::vector<int>>& tileMap, MatchClassifier& classifier, const SpawnPolicy& spawn,
+    GameRandom& random, CascadeScratch& scratch, GameStats* stats = nullptr);
@@ -0,0 +1,302 @@
+// Перебор дерева ходов на глубину N, как perft у шахматных движков. От
+// доски уровня с заданным зерном перебираются все легальные обмены
+// (findPossibleMoves), каждый доводится до устойчивой доски через
+// resolveMove, и так до нужной глубины. Все дети узла досыпаются из копии
+// генератора этого узла, поэтому дерево и счёт не зависят ни от порядка
+// обхода, ни от числа потоков.
+//
+// Число узлов по глубинам и сумма хэшей досок последней глубины — эталон
+// для проверки правил после оптимизаций; узлы в секунду — скорость движка.
+// Потоки берут поддеревья по одному: под первыми ходами, а если их мало
+// на все потоки — под вторыми.
+//
+// Использование: board_perft [--depth N] [--seed N] [--level файл]
+//                            [--tile-types N] [--threads N] [--divide]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board_logic.h"
+#include "level_layout.h"
+
+namespace
+{
+    const int MAX_DEPTH = 8;
+    const std::size_t TASKS_PER_THREAD = 4; // Меньше поддеревьев на поток — делим на глубине 2
+
+    struct PerftOptions
+    {
+        int depth = 3;
+        std::uint32_t seed = 1;
+        std::string levelPath = "levels/level1.txt";
+        int tileTypes = 6;
+        int threads = 1; // 0 — по числу ядер
+        bool divide = false; // Счёт под каждым первым ходом
+    };
+
+    // Узлов на каждой глубине (0 — корень) и сумма хэшей досок последней.
+    // Сумма не зависит от порядка, в котором потоки сложат поддеревья.
+    struct PerftCounts
+    {
+        std::uint64_t nodes[MAX_DEPTH + 1] = {};
+        std::uint64_t leafHash = 0;
+        std::uint64_t illegal = 0; // Ходы из findPossibleMoves, которые resolveMove не принял
+
+        void add(const PerftCounts& other)
+        {
+            for (int ply = 0; ply <= MAX_DEPTH; ++ply) nodes[ply] += other.nodes[ply];
+            leafHash += other.leafHash;
+            illegal += other.illegal;
+        }
+    };
+
+    // FNV-1a, как у раскладок уровней и партий сервера
+    std::uint64_t hashBoard(const std::vector<std::vector<int>>& tileMap)
+    {
+        std::uint64_t hash = 14695981039346656037ULL;
+        for (const std::vector<int>& row : tileMap)
+        {
+            for (int value : row)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    hash = (hash ^ static_cast<std::uint8_t>(static_cast<std::uint32_t>(value) >> (8 * i))) * 1099511628211ULL;
+                }
+            }
+        }
+        return hash;
+    }
+
+    // Буферы одного потока: доска, генератор и ходы на каждую глубину,
+    // чтобы обход не выделял память
+    class PerftWorker
+    {
+    public:
+        PerftWorker(const LevelLayout& level, const SpawnPolicy& spawn, int depth) :
+            spawn(spawn),
+            classifier(level.width, level.height),
+            depth(depth),
+            boards(depth + 1, std::vector<std::vector<int>>(level.height, std::vector<int>(level.width, 0))),
+            randoms(depth + 1),
+            moves(depth + 1)
+        {
+        }
+
+        // Ход move из узла глубины ply с доской board; false, если правила его не приняли
+        bool playFrom(const std::vector<std::vector<int>>& board, const GameRandom& random, int ply, const BoardMove& move,
+            PerftCounts& counts)
+        {
+            boards[ply] = board;
+            randoms[ply] = random;
+            return play(ply, move, counts);
+        }
+        // Поддерево под тем же ходом
+        void walkMove(const std::vector<std::vector<int>>& board, const GameRandom& random, int ply, const BoardMove& move,
+            PerftCounts& counts)
+        {
+            if (playFrom(board, random, ply, move, counts)) walk(ply + 1, counts);
+        }
+
+        const std::vector<std::vector<int>>& getBoard(int ply) const { return boards[ply]; }
+        const GameRandom& getRandom(int ply) const { return randoms[ply]; }
+
+    private:
+        // Ход из узла ply в ply + 1; false, если правила его не приняли
+        bool play(int ply, const BoardMove& move, PerftCounts& counts)
+        {
+            std::vector<std::vector<int>>& child = boards[ply + 1];
+            for (std::size_t y = 0; y < child.size(); ++y)
+            {
+                std::copy(boards[ply][y].begin(), boards[ply][y].end(), child[y].begin());
+            }
+            randoms[ply + 1] = randoms[ply];
+            // Фаза досыпания по числу сделанных ходов, как в игре после countMove
+            spawn.setMovesMade(ply + 1);
+
+            MoveOutcome outcome = resolveMove(child, classifier, spawn, randoms[ply + 1], move, scratch);
+            if (!outcome.legal)
+            {
+                counts.illegal++;
+                return false;
+            }
+            counts.nodes[ply + 1]++;
+            return true;
+        }
+
+        void walk(int ply, PerftCounts& counts)
+        {
+            if (ply == depth)
+            {
+                counts.leafHash += hashBoard(boards[ply]);
+                return;
+            }
+            std::vector<BoardMove>& legal = moves[ply];
+            findPossibleMoves(boards[ply], legal);
+            for (const BoardMove& move : legal)
+            {
+                if (play(ply, move, counts)) walk(ply + 1, counts);
+            }
+        }
+
+        SpawnPolicy spawn; // Своя фаза, таблицы общие
+        MatchClassifier classifier;
+        CascadeScratch scratch;
+        int depth;
+        std::vector<std::vector<std::vector<int>>> boards; // [ply]
+        std::vector<GameRandom> randoms;                   // [ply]
+        std::vector<std::vector<BoardMove>> moves;         // [ply]
+    };
+
+    // Начальная доска в том же порядке, что у игры и сервера: поставленные
+    // тайлы уровня, заполнение по столбцам, снятие готовых совпадений
+    void startBoard(const LevelLayout& level, const SpawnPolicy& spawn, std::uint32_t seed,
+        std::vector<std::vector<int>>& tileMap, GameRandom& random)
+    {
+        tileMap.assign(level.height, std::vector<int>(level.width, 0));
+        for (int y = 0; y < level.height; ++y)
+        {
+            for (int x = 0; x < level.width; ++x)
+            {
+                tileMap[y][x] = level.cell(x, y);
+            }
+        }
+        MatchClassifier classifier(level.width, level.height);
+        CascadeScratch scratch;
+        random.seed(seed);
+        refillEmpty(tileMap, spawn, random, scratch.filled);
+        settleBoard(tileMap, classifier, spawn, random, scratch);
+    }
+
+    // Поддерево для потока: ход move из узла глубины ply
+    struct PerftTask
+    {
+        std::size_t rootMove; // Под каким первым ходом, для --divide
+        int ply;
+        std::vector<std::vector<int>> board;
+        GameRandom random;
+        BoardMove move;
+        PerftCounts counts;
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    PerftOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue) options.depth = std::min(std::max(1, std::atoi(argv[++i])), MAX_DEPTH);
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--level" && hasValue) options.levelPath = argv[++i];
+        else if (arg == "--tile-types" && hasValue) options.tileTypes = std::max(3, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--divide") options.divide = true;
+        else
+        {
+            std::cerr << "Usage: board_perft [--depth N] [--seed N] [--level file] [--tile-types N] [--threads N] [--divide]"
+                << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.threads == 0)
+    {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    LevelLayout level;
+    if (!loadLevel(options.levelPath, level))
+    {
+        return EXIT_FAILURE;
+    }
+    SpawnPolicy spawn(level.spawn, options.tileTypes);
+
+    std::vector<std::vector<int>> root;
+    GameRandom random;
+    startBoard(level, spawn, options.seed, root, random);
+    std::vector<BoardMove> rootMoves;
+    findPossibleMoves(root, rootMoves);
+
+    auto begin = std::chrono::steady_clock::now();
+
+    // Первых ходов мало на все потоки — первый ход делается здесь,
+    // а потокам раздаются поддеревья вторых
+    std::vector<PerftCounts> subtrees(rootMoves.size());
+    std::vector<PerftTask> tasks;
+    bool splitDeeper = options.depth >= 3 && rootMoves.size() < TASKS_PER_THREAD * options.threads;
+    PerftWorker splitter(level, spawn, options.depth);
+    std::vector<BoardMove> childMoves;
+    for (std::size_t index = 0; index < rootMoves.size(); ++index)
+    {
+        if (!splitDeeper)
+        {
+            tasks.push_back({ index, 0, root, random, rootMoves[index], PerftCounts() });
+            continue;
+        }
+        if (!splitter.playFrom(root, random, 0, rootMoves[index], subtrees[index])) continue;
+        std::vector<std::vector<int>> child = splitter.getBoard(1);
+        findPossibleMoves(child, childMoves);
+        for (const BoardMove& move : childMoves)
+        {
+            tasks.push_back({ index, 1, child, splitter.getRandom(1), move, PerftCounts() });
+        }
+    }
+
+    std::atomic<std::size_t> nextTask(0);
+    auto work = [&]()
+    {
+        PerftWorker worker(level, spawn, options.depth);
+        for (std::size_t index = nextTask.fetch_add(1); index < tasks.size(); index = nextTask.fetch_add(1))
+        {
+            PerftTask& task = tasks[index];
+            worker.walkMove(task.board, task.random, task.ply, task.move, task.counts);
+        }
+    };
+
+    int threadCount = std::min<int>(options.threads, std::max<int>(1, static_cast<int>(tasks.size())));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i) threads.emplace_back(work);
+    work();
+    for (std::thread& thread : threads) thread.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    for (const PerftTask& task : tasks) subtrees[task.rootMove].add(task.counts);
+    PerftCounts total;
+    total.nodes[0] = 1;
+    for (const PerftCounts& subtree : subtrees) total.add(subtree);
+
+    if (options.divide)
+    {
+        for (std::size_t i = 0; i < rootMoves.size(); ++i)
+        {
+            const BoardMove& move = rootMoves[i];
+            std::cout << move.fromX << ',' << move.fromY << '-' << move.toX << ',' << move.toY << ": "
+                << subtrees[i].nodes[options.depth] << std::endl;
+        }
+    }
+
+    std::uint64_t nodes = 0;
+    for (int ply = 1; ply <= options.depth; ++ply)
+    {
+        std::cout << "depth " << ply << ": " << total.nodes[ply] << std::endl;
+        nodes += total.nodes[ply];
+    }
+    std::cout << "leaf hash " << std::hex << std::setw(16) << std::setfill('0') << total.leafHash << std::dec << std::endl;
+    std::cout << nodes << " nodes in " << elapsed << " s, " << static_cast<long long>(nodes / std::max(elapsed, 1e-9))
+        << " nodes/s, " << threadCount << (threadCount == 1 ? " thread" : " threads") << std::endl;
+
+    if (total.illegal > 0)
+    {
+        std::cerr << total.illegal << " moves from findPossibleMoves were rejected by resolveMove" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "board_reference.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+void referenceFindMatches(const std::vector<std::vector<int>>& tileMap, std::vector<std::vector<bool>>& mask)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    for (auto& row : mask) std::fill(row.begin(), row.end(), false);
+
+    // Горизонтальные совпадения
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width - 2; ++x)
+        {
+            int value = tileMap[y][x];
+            if (isMatchable(value) &&
+                tileColor(value) == tileColor(tileMap[y][x + 1]) &&
+                tileColor(value) == tileColor(tileMap[y][x + 2]))
+            {
+                mask[y][x] = mask[y][x + 1] = mask[y][x + 2] = true;
+            }
+        }
+    }
+
+    // Вертикальные совпадения
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height - 2; ++y)
+        {
+            int value = tileMap[y][x];
+            if (isMatchable(value) &&
+                tileColor(value) == tileColor(tileMap[y + 1][x]) &&
+                tileColor(value) == tileColor(tileMap[y + 2][x]))
+            {
+                mask[y][x] = mask[y + 1][x] = mask[y + 2][x] = true;
+            }
+        }
+    }
+}
+
+// Пузырьковое падение: пока под каким-то тайлом пустая клетка, тайл
+// опускается на одну клетку. Закрытая клетка не пуста и не падает, поэтому
+// держит тайлы над собой. Для каждого тайла помним исходную строку, и
+// падения восстанавливаются по итоговой доске.
+int referenceCollapseColumns(std::vector<std::vector<int>>& tileMap, std::vector<TileDrop>& drops)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    drops.clear();
+
+    std::vector<std::vector<int>> origin(height, std::vector<int>(width, -1));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (tileMap[y][x] != 0 && tileMap[y][x] != BLOCKED_TILE) origin[y][x] = y;
+        }
+    }
+
+    bool moved = true;
+    while (moved)
+    {
+        moved = false;
+        for (int y = 0; y < height - 1; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                int value = tileMap[y][x];
+                if (value != 0 && value != BLOCKED_TILE && tileMap[y + 1][x] == 0)
+                {
+                    std::swap(tileMap[y][x], tileMap[y + 1][x]);
+                    std::swap(origin[y][x], origin[y + 1][x]);
+                    moved = true;
+                }
+            }
+        }
+    }
+
+    // Тайлы столбца не обгоняют друг друга: снизу вверх по итоговым
+    // клеткам — тот же порядок, что снизу вверх по исходным
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = height - 1; y >= 0; --y)
+        {
+            if (origin[y][x] >= 0 && origin[y][x] != y) drops.push_back({ x, origin[y][x], y });
+        }
+    }
+    return static_cast<int>(drops.size());
+}
+
+// Досыпание построчно. Правило игры — k-е значение генератора достаётся
+// k-й пустой клетке в порядке столбцов, поэтому значения берутся заранее,
+// а номер клетки считается по числу пустых до неё.
+int referenceRefillEmpty(std::vector<std::vector<int>>& tileMap, int tileTypeCount, GameRandom& random, std::vector<int>& filled)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    filled.clear();
+
+    int emptyCount = 0;
+    for (const std::vector<int>& row : tileMap)
+    {
+        emptyCount += static_cast<int>(std::count(row.begin(), row.end(), 0));
+    }
+    std::vector<int> values(emptyCount);
+    for (int& value : values) value = random.nextInt(1, tileTypeCount);
+
+    std::vector<std::vector<bool>> empty(height, std::vector<bool>(width, false));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x) empty[y][x] = tileMap[y][x] == 0;
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (!empty[y][x]) continue;
+            int rank = 0;
+            for (int cx = 0; cx < width; ++cx)
+            {
+                for (int cy = 0; cy < height; ++cy)
+                {
+                    if (empty[cy][cx] && (cx < x || (cx == x && cy < y))) rank++;
+                }
+            }
+            tileMap[y][x] = values[rank];
+            filled.push_back(y * width + x);
+        }
+    }
+
+    // Клетки в порядке столбцов, как их отдаёт игра
+    std::sort(filled.begin(), filled.end(), [width](int a, int b)
+        {
+            return a % width != b % width ? a % width < b % width : a / width < b / width;
+        });
+    return static_cast<int>(filled.size());
+}
+
+namespace
+{
+    bool referenceIsLegalMove(std::vector<std::vector<int>>& tileMap, const BoardMove& move)
+    {
+        int& first = tileMap[move.fromY][move.fromX];
+        int& second = tileMap[move.toY][move.toX];
+        if (first == BLOCKED_TILE || second == BLOCKED_TILE) return false;
+
+        std::swap(first, second);
+        bool legal = isColorBombSwap(first, second) || hasMatches(tileMap);
+        std::swap(first, second);
+        return legal;
+    }
+}
+
+void referenceFindPossibleMoves(std::vector<std::vector<int>>& tileMap, std::vector<BoardMove>& moves)
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    moves.clear();
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width - 1; x++)
+        {
+            BoardMove move = { x, y, x + 1, y };
+            if (referenceIsLegalMove(tileMap, move)) moves.push_back(move);
+        }
+    }
+
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height - 1; y++)
+        {
+            BoardMove move = { x, y, x, y + 1 };
+            if (referenceIsLegalMove(tileMap, move)) moves.push_back(move);
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include "board_logic.h"
+
+// Эталонные ядра доски: прямые и заведомо верные версии findMatches,
+// collapseColumns, refillEmpty и findPossibleMoves. Совпадения и ходы — в
+// том виде, в каком они были до оптимизаций; падение и досыпание написаны
+// заново другим способом, чтобы не сверять код сам с собой. В игре не
+// используются, их вызывает только board_fuzz, чтобы сверять с ними
+// быстрые версии из board_logic.
+// Семантика должна оставаться прежней: менять их можно только вместе
+// с правилами игры.
+
+void referenceFindMatches(const std::vector<std::vector<int>>& tileMap, std::vector<std::vector<bool>>& mask);
+int referenceCollapseColumns(std::vector<std::vector<int>>& tileMap, std::vector<TileDrop>& drops);
+int referenceRefillEmpty(std::vector<std::vector<int>>& tileMap, int tileTypeCount, GameRandom& random, std::vector<int>& filled);
+// Каждый обмен проверяется полным поиском совпадений по доске
+void referenceFindPossibleMoves(std::vector<std::vector<int>>& tileMap, std::vector<BoardMove>& moves);
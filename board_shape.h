@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Форма доски: какие клетки игровые. Задаётся строками сверху вниз,
+// '#' — закрытая (угловая) клетка, любой другой символ — игровая.
+// Проверка клетки — одно обращение к плоскому массиву.
+class BoardShape
+{
+public:
+    BoardShape(int width, int height, const char* const* rows) :
+        width(width),
+        height(height),
+        playable(width * height, 0)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                playable[y * width + x] = rows[y][x] != '#';
+            }
+        }
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    bool contains(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    bool isPlayable(int x, int y) const { return contains(x, y) && playable[y * width + x]; }
+    void setPlayable(int x, int y, bool value) { if (contains(x, y)) playable[y * width + x] = value; }
+
+private:
+    int width;
+    int height;
+    std::vector<std::uint8_t> playable;
+};
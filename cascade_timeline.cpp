@@ -0,0 +1,134 @@
+#include "cascade_timeline.h"
+
+#include <algorithm>
+
+namespace
+{
+    const int CASCADE_RESERVE_STEPS = 4;
+}
+
+CascadeTimeline::CascadeTimeline(int width, int height, float removeSeconds, float secondsPerRow) :
+    width(width),
+    height(height),
+    removeSeconds(removeSeconds),
+    secondsPerRow(secondsPerRow),
+    landed(width, 0.0f),
+    fallStart(width, 0.0f),
+    spawnCount(width, 0),
+    spawnSeen(width, 0)
+{
+    // Шаг каскада — до трёх записей на клетку; запас на несколько шагов,
+    // чтобы обычный ход не растил вектор
+    entries.reserve(static_cast<std::size_t>(CASCADE_RESERVE_STEPS) * 3 * width * height);
+}
+
+void CascadeTimeline::begin(float now)
+{
+    entries.clear();
+    next = 0;
+    added = 0;
+    std::fill(landed.begin(), landed.end(), now);
+    std::fill(fallStart.begin(), fallStart.end(), now);
+    endTime = now;
+}
+
+void CascadeTimeline::addClears(const std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& mask,
+    const std::vector<PlacedSpecial>& placed, int depth)
+{
+    // Шаг ждёт только свои столбцы, включая опорные клетки бонусов
+    bool any = false;
+    float start = 0.0f;
+    auto touch = [this, &any, &start](int x)
+    {
+        start = any ? std::max(start, landed[x]) : landed[x];
+        any = true;
+    };
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            if (mask[y][x])
+            {
+                touch(x);
+                break;
+            }
+        }
+    }
+    for (const PlacedSpecial& special : placed) touch(special.x);
+    if (!any) return;
+
+    for (const PlacedSpecial& special : placed)
+    {
+        add({ start, special.x, special.y, TimelineAction::SetValue, tileMap[special.y][special.x], 0 });
+    }
+    if (depth > 1)
+    {
+        add({ start, 0, 0, TimelineAction::Combo, depth, 0 });
+    }
+
+    float done = start + removeSeconds;
+    for (int x = 0; x < width; ++x)
+    {
+        bool cleared = false;
+        for (int y = 0; y < height; ++y)
+        {
+            if (!mask[y][x]) continue;
+            add({ start, x, y, TimelineAction::Remove, tileMap[y][x], 0 });
+            cleared = true;
+        }
+        if (cleared)
+        {
+            fallStart[x] = done;
+            landed[x] = done;
+        }
+    }
+    endTime = std::max(endTime, done);
+}
+
+void CascadeTimeline::addFalls(const std::vector<std::vector<int>>& tileMap, const std::vector<TileDrop>& drops,
+    const std::vector<int>& filled)
+{
+    auto finish = [this](int x, float time)
+    {
+        landed[x] = std::max(landed[x], time);
+        endTime = std::max(endTime, time);
+    };
+
+    // Источники пустеют раньше, чем в них падают тайлы сверху: при равном
+    // времени записи применяются в порядке добавления
+    for (const TileDrop& drop : drops)
+    {
+        add({ fallStart[drop.x], drop.x, drop.fromY, TimelineAction::SetValue, 0, 0 });
+    }
+    for (const TileDrop& drop : drops)
+    {
+        float start = fallStart[drop.x];
+        add({ start, drop.x, drop.toY, TimelineAction::Fall, tileMap[drop.toY][drop.x], drop.fromY });
+        finish(drop.x, start + (drop.toY - drop.fromY) * secondsPerRow);
+    }
+
+    // Новые тайлы столбца въезжают из строки над доской друг за другом:
+    // нижний — сразу, каждый следующий — через строку пути
+    std::fill(spawnCount.begin(), spawnCount.end(), 0);
+    std::fill(spawnSeen.begin(), spawnSeen.end(), 0);
+    for (int cell : filled) spawnCount[cell % width]++;
+    for (int cell : filled)
+    {
+        int x = cell % width;
+        int y = cell / width;
+        int above = spawnCount[x] - 1 - spawnSeen[x]++; // refillEmpty идёт по столбцу сверху вниз
+        float start = fallStart[x] + above * secondsPerRow;
+        add({ start, x, y, TimelineAction::Fall, tileMap[y][x], -1 });
+        finish(x, start + (y + 1) * secondsPerRow);
+    }
+
+    // Порядок добавления вместо stable_sort: тому нужен временный буфер из кучи
+    std::sort(entries.begin() + next, entries.end(),
+        [](const TimelineEntry& a, const TimelineEntry& b) { return a.time < b.time || (a.time == b.time && a.order < b.order); });
+}
+
+void CascadeTimeline::add(const TimelineEntry& entry)
+{
+    entries.push_back(entry);
+    entries.back().order = added++;
+}
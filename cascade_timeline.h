@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "board_logic.h"
+
+// Что запись расписания делает с клеткой
+enum class TimelineAction
+{
+    SetValue, // Сменить значение без анимации: бонус в опорной клетке, опустевший источник падения
+    Remove,   // Тайл value исчезает
+    Fall,     // В клетку падает тайл value из строки fromY (над доской — отрицательной)
+    Combo,    // Начался шаг каскада глубже первого, value — глубина
+};
+
+struct TimelineEntry
+{
+    float time; // Время симуляции начала
+    int x;
+    int y;
+    TimelineAction action;
+    int value;
+    int fromY;
+    int order = 0; // Номер добавления в каскаде: при равном времени раньше добавленная раньше
+};
+
+// Расписание анимаций каскада, который посчитан целиком в момент хода.
+// Шаги не ждут всей доски: удаления шага начинаются, как только улеглись
+// столбцы, которых они касаются, а падения и досыпание в столбце — сразу
+// по окончании удалений этого шага. Досыпание идёт вместе с падением:
+// новые тайлы столбца въезжают сверху один за другим, как колонна, без
+// ожидания, пока упадут старые. Время — оценка по скоростям
+// анимаций; если тайл на шаг симуляции опоздал, запись ждёт его сама.
+class CascadeTimeline
+{
+public:
+    CascadeTimeline(int width, int height, float removeSeconds, float secondsPerRow);
+
+    // Новый каскад: все столбцы свободны с now
+    void begin(float now);
+    // Удаления шага: после placeSpecials, до clearMarked — в tileMap ещё
+    // удаляемые тайлы, а бонусы уже в опорных клетках
+    void addClears(const std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& mask,
+        const std::vector<PlacedSpecial>& placed, int depth);
+    // Падения и досыпание того же шага: после collapseColumns и refillEmpty
+    void addFalls(const std::vector<std::vector<int>>& tileMap, const std::vector<TileDrop>& drops,
+        const std::vector<int>& filled);
+
+    // Очередная запись, время которой пришло, иначе nullptr
+    const TimelineEntry* peek(float now) const
+    {
+        return next < entries.size() && entries[next].time <= now ? &entries[next] : nullptr;
+    }
+    void pop() { ++next; }
+    bool isFinished() const { return next == entries.size(); }
+    // Оценка времени, когда доска уляжется
+    float getEndTime() const { return endTime; }
+
+private:
+    void add(const TimelineEntry& entry);
+
+    int width;
+    int height;
+    float removeSeconds;
+    float secondsPerRow;
+
+    std::vector<TimelineEntry> entries; // По времени; при равном — в порядке добавления
+    std::size_t next = 0;
+    int added = 0;
+    std::vector<float> landed;    // Когда столбец улёгся
+    std::vector<float> fallStart; // Начало падений в столбце на текущем шаге
+    std::vector<int> spawnCount;  // Новых тайлов в столбце на текущем шаге
+    std::vector<int> spawnSeen;
+    float endTime = 0.0f;
+};
@@ -0,0 +1,136 @@
+/* Проверка C ABI движка из настоящего C: создание контекста, пакетные
+ * вызовы и отказ на неверных аргументах и значениях клеток. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigwash_engine.h"
+
+#define WIDTH 8
+#define HEIGHT 8
+#define TILE_TYPES 6
+#define BOARD_SIZE (WIDTH * HEIGHT)
+#define BOARDS 4
+
+static int failures = 0;
+
+static void check(int condition, const char* what)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+/* Доска без совпадений, где ход (2,0)-(3,0) собирает тройку в первой строке */
+static void makeBoard(int32_t* cells)
+{
+    int x, y;
+    for (y = 0; y < HEIGHT; ++y)
+    {
+        for (x = 0; x < WIDTH; ++x) cells[y * WIDTH + x] = 1 + (x + 2 * y) % TILE_TYPES;
+    }
+    cells[1] = 1;
+    cells[3] = 1;
+}
+
+int main(void)
+{
+    static int32_t boards[BOARDS * BOARD_SIZE];
+    static int32_t before[BOARD_SIZE];
+    static bw_move found[BOARDS * 2 * BOARD_SIZE];
+    bw_move moves[BOARDS];
+    bw_rng rngs[BOARDS];
+    bw_move_result results[BOARDS];
+    int32_t counts[BOARDS];
+    const bw_move swap = { 2, 0, 3, 0 };
+    const bw_move illegal = { 0, 7, 1, 7 };
+    bw_move_result result;
+    bw_context* context;
+    int i;
+
+    check(bw_abi_version() == BW_ABI_VERSION, "ABI version");
+    check(bw_create(2, HEIGHT, TILE_TYPES) == NULL, "board side below 3 is refused");
+    check(bw_create(WIDTH, 65, TILE_TYPES) == NULL, "board side above 64 is refused");
+    check(bw_create(WIDTH, HEIGHT, 9) == NULL, "more than 8 tile types are refused");
+
+    context = bw_create(WIDTH, HEIGHT, TILE_TYPES);
+    if (!context)
+    {
+        fprintf(stderr, "bw_create failed\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < BOARDS; ++i)
+    {
+        makeBoard(boards + i * BOARD_SIZE);
+        moves[i] = swap;
+        bw_rng_seed(&rngs[i], 100 + i, 1);
+    }
+    check(bw_has_matches(context, boards) == 0, "sample board has no matches");
+
+    check(bw_enumerate_moves_batch(context, boards, BOARDS, found, 2 * BOARD_SIZE, counts) == BW_OK, "enumerate batch");
+    for (i = 0; i < BOARDS; ++i) check(counts[i] > 0 && counts[i] == counts[0], "every board has the same moves");
+    check(bw_enumerate_moves_batch(context, boards, BOARDS, NULL, 0, counts) == BW_OK && counts[0] > 0,
+        "enumerate batch counts moves without a buffer");
+
+    check(bw_resolve_moves_batch(context, boards, BOARDS, moves, rngs, results) == BW_OK, "resolve batch");
+    for (i = 0; i < BOARDS; ++i)
+    {
+        check(results[i].legal == 1 && results[i].cleared >= 3 && results[i].cascade_depth >= 1, "batch move clears a line");
+        check(bw_has_matches(context, boards + i * BOARD_SIZE) == 0, "board is settled after the move");
+    }
+
+    makeBoard(before);
+    memcpy(boards, before, sizeof(before));
+    check(bw_resolve_move(context, boards, &illegal, &rngs[0], &result) == BW_OK && result.legal == 0,
+        "swap without a match is not legal");
+    check(memcmp(boards, before, sizeof(before)) == 0, "illegal move leaves the board unchanged");
+
+    /* Неверные аргументы */
+    check(bw_has_matches(NULL, boards) == BW_ERROR_ARGUMENT, "null context");
+    check(bw_has_matches(context, NULL) == BW_ERROR_ARGUMENT, "null cells");
+    check(bw_resolve_moves_batch(context, boards, -1, moves, rngs, results) == BW_ERROR_ARGUMENT, "negative count");
+    check(bw_enumerate_moves_batch(context, boards, BOARDS, NULL, 4, counts) == BW_ERROR_ARGUMENT,
+        "capacity without a buffer");
+    check(bw_resolve_moves_batch(context, boards, 0, NULL, NULL, NULL) == BW_OK, "empty batch");
+
+    /* Значения клеток: допустимые */
+    memcpy(boards, before, sizeof(before));
+    boards[WIDTH * 7] = 0;
+    boards[WIDTH * 7 + 1] = 9;    /* Закрытая клетка */
+    boards[WIDTH * 7 + 2] = 0x40; /* Цветная бомба */
+    boards[WIDTH * 7 + 3] = 0x31; /* Бомба цвета 1 */
+    boards[WIDTH * 7 + 4] = 0x16; /* Линия последнего цвета контекста */
+    check(bw_has_matches(context, boards) >= 0, "every encoded tile kind is accepted");
+
+    /* Недопустимые: в клетку 7 последней строки */
+    {
+        const int32_t bad[] = { -1, 7, 8, 0x19, 0x10, 0x30, 0x43, 0x50, 0x100 };
+        for (i = 0; i < (int)(sizeof(bad) / sizeof(bad[0])); ++i)
+        {
+            memcpy(boards, before, sizeof(before));
+            boards[WIDTH * 7 + 7] = bad[i];
+            if (bw_has_matches(context, boards) != BW_ERROR_BOARD)
+            {
+                fprintf(stderr, "FAILED: cell value 0x%x was accepted\n", (unsigned)bad[i]);
+                failures++;
+            }
+        }
+    }
+
+    /* Плохая доска посреди пакета останавливает его */
+    for (i = 0; i < BOARDS; ++i) makeBoard(boards + i * BOARD_SIZE);
+    boards[2 * BOARD_SIZE + 5] = 0x19;
+    check(bw_resolve_moves_batch(context, boards, BOARDS, moves, rngs, results) == BW_ERROR_BOARD,
+        "bad board in a batch is reported");
+
+    bw_destroy(context);
+    bw_destroy(NULL);
+
+    if (failures > 0) return EXIT_FAILURE;
+    printf("Engine C ABI smoke test passed\n");
+    return 0;
+}
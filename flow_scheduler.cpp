@@ -0,0 +1,180 @@
+#include "flow_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <new>
+
+namespace
+{
+    const std::size_t FLOW_WHEEL_SLOTS = 1024; // Около 8.5 с при шаге 1/120, дальше — по второму кругу
+    const std::size_t FLOW_FRAME_BYTES = 512;  // Кадры сценариев маленькие: ссылки и ожидающий объект
+    const std::size_t FLOW_FRAME_SLOTS = 32;
+
+    // Пул кадров корутин. Сценарии создаются редко (один на партию или
+    // сессию), поэтому мьютекс не мешает; кадр больше ячейки или сверх
+    // пула идёт в кучу и попадает в счётчик выделений.
+    struct FramePool
+    {
+        std::mutex mutex;
+        alignas(std::max_align_t) unsigned char memory[FLOW_FRAME_SLOTS][FLOW_FRAME_BYTES];
+        void* free[FLOW_FRAME_SLOTS];
+        std::size_t freeCount = 0;
+
+        FramePool()
+        {
+            for (std::size_t i = 0; i < FLOW_FRAME_SLOTS; ++i) free[freeCount++] = memory[FLOW_FRAME_SLOTS - 1 - i];
+        }
+
+        bool owns(void* pointer) const
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(pointer);
+            return bytes >= &memory[0][0] && bytes < &memory[0][0] + sizeof(memory);
+        }
+    };
+
+    FramePool& framePool()
+    {
+        static FramePool pool;
+        return pool;
+    }
+}
+
+void* FlowTask::promise_type::operator new(std::size_t size)
+{
+    if (size <= FLOW_FRAME_BYTES)
+    {
+        FramePool& pool = framePool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.freeCount > 0) return pool.free[--pool.freeCount];
+    }
+    return ::operator new(size);
+}
+
+void FlowTask::promise_type::operator delete(void* pointer, std::size_t size)
+{
+    FramePool& pool = framePool();
+    if (!pool.owns(pointer))
+    {
+        ::operator delete(pointer, size);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.free[pool.freeCount++] = pointer;
+}
+
+FlowScheduler::FlowScheduler(float tickSeconds) :
+    tickSeconds(tickSeconds),
+    slots(FLOW_WHEEL_SLOTS, nullptr)
+{
+}
+
+FlowScheduler::~FlowScheduler()
+{
+    for (FlowWaiter* first : slots) destroyList(first);
+    destroyList(ready);
+}
+
+void FlowScheduler::destroyList(FlowWaiter* first)
+{
+    while (first)
+    {
+        // Ожидающий объект живёт в кадре: next читается до уничтожения
+        FlowWaiter* next = first->next;
+        first->handle.destroy();
+        first = next;
+    }
+}
+
+std::int64_t FlowScheduler::tickOf(float time) const
+{
+    return static_cast<std::int64_t>(std::floor(time / tickSeconds));
+}
+
+void FlowScheduler::schedule(FlowWaiter& waiter)
+{
+    // На шаг раньше расчётного: округление времени не даст проспать
+    waiter.tick = std::max(tickOf(waiter.since + waiter.seconds) - 1, processed + 1);
+    FlowWaiter*& slot = slots[static_cast<std::size_t>(waiter.tick) % FLOW_WHEEL_SLOTS];
+    waiter.next = slot;
+    slot = &waiter;
+}
+
+void FlowScheduler::wake(FlowWaiter& waiter)
+{
+    waiter.next = nullptr;
+    if (readyTail) readyTail->next = &waiter;
+    else ready = &waiter;
+    readyTail = &waiter;
+}
+
+void FlowScheduler::advance(float time)
+{
+    now = time;
+    // Шаг идёт вперёд при каждом вызове, даже если время округлилось в
+    // тот же шаг: отложенные на следующий шаг проверяются всегда
+    std::int64_t target = std::max(tickOf(now), processed + 1);
+    std::int64_t first = std::max(processed + 1, target - static_cast<std::int64_t>(FLOW_WHEEL_SLOTS) + 1);
+    processed = target;
+
+    for (std::int64_t tick = first; tick <= target; ++tick)
+    {
+        FlowWaiter** link = &slots[static_cast<std::size_t>(tick) % FLOW_WHEEL_SLOTS];
+        while (FlowWaiter* waiter = *link)
+        {
+            if (waiter->tick > target)
+            {
+                link = &waiter->next; // Следующий круг колеса
+                continue;
+            }
+            *link = waiter->next;
+            if (now - waiter->since > waiter->seconds)
+            {
+                wake(*waiter);
+            }
+            else
+            {
+                // Время ещё не пришло: проверить на следующем шаге
+                waiter->tick = processed + 1;
+                FlowWaiter*& later = slots[static_cast<std::size_t>(waiter->tick) % FLOW_WHEEL_SLOTS];
+                waiter->next = later;
+                later = waiter;
+            }
+        }
+    }
+
+    // Разбуженные могут снова заснуть или подать сигнал — они попадут в
+    // колесо на следующие шаги или в новый список готовых
+    FlowWaiter* due = ready;
+    ready = readyTail = nullptr;
+    while (due)
+    {
+        FlowWaiter* next = due->next;
+        due->handle.resume();
+        due = next;
+    }
+}
+
+FlowSignal::~FlowSignal()
+{
+    FlowWaiter* first = waiting;
+    waiting = nullptr;
+    while (first)
+    {
+        FlowWaiter* next = first->next;
+        first->handle.destroy();
+        first = next;
+    }
+}
+
+void FlowSignal::notify()
+{
+    FlowWaiter* first = waiting;
+    waiting = nullptr;
+    while (first)
+    {
+        FlowWaiter* next = first->next;
+        scheduler.wake(*first);
+        first = next;
+    }
+}
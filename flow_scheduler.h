@@ -0,0 +1,132 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+// Подвешенный сценарий: кадр корутины и условие, при котором его будить.
+// Живёт в кадре самой корутины (в ожидающем объекте), поэтому ожидание
+// ничего не выделяет.
+struct FlowWaiter
+{
+    std::coroutine_handle<> handle;
+    float since = 0.0f;   // Будить, когда время - since > seconds
+    float seconds = 0.0f;
+    std::int64_t tick = 0; // Шаг, с которого проверять условие
+    FlowWaiter* next = nullptr;
+};
+
+// Сценарий игры на корутинах: запускается сразу при вызове и идёт до
+// первого co_await. Владельца у сценария нет — подвешенный кадр держит
+// планировщик или сигнал, которого он ждёт, и они же уничтожают его при
+// своём разрушении. Кадры берутся из небольшого пула, а не из кучи.
+class FlowTask
+{
+public:
+    struct promise_type
+    {
+        FlowTask get_return_object() { return FlowTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+
+        static void* operator new(std::size_t size);
+        static void operator delete(void* pointer, std::size_t size);
+    };
+};
+
+// Планировщик сценариев потока симуляции. Ждущие по времени лежат в
+// колесе таймеров: ячейка — шаг симуляции, advance() обходит только
+// ячейки прошедших шагов, так что ожидание ничего не стоит, а цикл
+// никогда не блокируется. Условие пробуждения сравнивается тем же
+// выражением, что и прежний опрос (время - since > seconds), поэтому
+// сценарий просыпается ровно на том шаге, где сработал бы опрос.
+class FlowScheduler
+{
+public:
+    explicit FlowScheduler(float tickSeconds);
+    ~FlowScheduler();
+
+    FlowScheduler(const FlowScheduler&) = delete;
+    FlowScheduler& operator=(const FlowScheduler&) = delete;
+
+    struct TimeAwaiter
+    {
+        FlowScheduler& scheduler;
+        FlowWaiter waiter;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            waiter.handle = handle;
+            scheduler.schedule(waiter);
+        }
+        void await_resume() const {}
+    };
+
+    // Проснуться на первом шаге, где время - since > seconds. Даже если
+    // условие уже выполнено, сценарий уступает до следующего шага.
+    TimeAwaiter after(float since, float seconds) { return TimeAwaiter{ *this, { {}, since, seconds } }; }
+    TimeAwaiter delay(float seconds) { return after(now, seconds); }
+    // Следующий шаг
+    TimeAwaiter nextStep() { return after(now, -1.0f); }
+
+    // Шаг симуляции со временем now: будит всех, чьё время пришло, и
+    // тех, кого разбудили сигналы. Порядок пробуждения внутри шага не задан.
+    void advance(float now);
+
+    float getTime() const { return now; }
+
+private:
+    friend class FlowSignal;
+
+    void schedule(FlowWaiter& waiter);
+    // В список готовых к ближайшему advance()
+    void wake(FlowWaiter& waiter);
+    std::int64_t tickOf(float time) const;
+    static void destroyList(FlowWaiter* first);
+
+    float tickSeconds;
+    float now = 0.0f;
+    std::int64_t processed = -1; // Последний обойдённый шаг
+    std::vector<FlowWaiter*> slots; // Ячейка — шаг по модулю размера колеса
+    FlowWaiter* ready = nullptr;
+    FlowWaiter* readyTail = nullptr;
+};
+
+// Событие, которого ждут сценарии без опроса: notify() будит всех
+// ждущих на ближайшем шаге планировщика.
+class FlowSignal
+{
+public:
+    explicit FlowSignal(FlowScheduler& scheduler) : scheduler(scheduler) {}
+    ~FlowSignal();
+
+    FlowSignal(const FlowSignal&) = delete;
+    FlowSignal& operator=(const FlowSignal&) = delete;
+
+    struct Awaiter
+    {
+        FlowSignal& signal;
+        FlowWaiter waiter;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            waiter.handle = handle;
+            waiter.next = signal.waiting;
+            signal.waiting = &waiter;
+        }
+        void await_resume() const {}
+    };
+
+    Awaiter operator co_await() { return Awaiter{ *this, {} }; }
+    void notify();
+
+private:
+    FlowScheduler& scheduler;
+    FlowWaiter* waiting = nullptr;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// Память на один шаг: выделение — сдвиг указателя в заранее выделенном
+// блоке, освобождение — reset() в начале следующего шага. Временные
+// контейнеры шага (std::pmr::vector и т.п.) берут память отсюда, а не из
+// кучи. Если блока не хватило, остаток идёт в кучу и попадает в счётчик
+// выделений кадра — так переполнение видно, а не молча медленно.
+class FrameArena
+{
+public:
+    explicit FrameArena(std::size_t capacity) :
+        buffer(new std::byte[capacity]),
+        capacity(capacity),
+        memory(buffer.get(), capacity, &overflow)
+    {
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    std::pmr::memory_resource* get() { return &memory; }
+    // Всё выделенное за шаг разом становится свободным
+    void reset() { memory.release(); }
+
+    std::size_t getCapacity() const { return capacity; }
+    // Сколько раз блока не хватило с запуска
+    std::size_t getOverflowCount() const { return overflow.count; }
+
+private:
+    struct OverflowResource : std::pmr::memory_resource
+    {
+        std::size_t count = 0;
+
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            ++count;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::size_t capacity;
+    OverflowResource overflow;
+    std::pmr::monotonic_buffer_resource memory;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Компактный генератор PCG32. Всё состояние — два 64-битных числа,
+// они сохраняются вместе с партией, и после загрузки доска досыпается
+// теми же тайлами, что выпали бы без выхода из игры.
+class GameRandom
+{
+public:
+    explicit GameRandom(std::uint64_t seedValue = 0x853c49e6748fea9bULL)
+    {
+        seed(seedValue);
+    }
+
+    void seed(std::uint64_t seedValue, std::uint64_t stream = 0xda3e39cb94b95bdbULL)
+    {
+        state = 0;
+        increment = (stream << 1) | 1;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    std::uint32_t next()
+    {
+        std::uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        std::uint32_t xorShifted = static_cast<std::uint32_t>(((old >> 18) ^ old) >> 27);
+        std::uint32_t rotation = static_cast<std::uint32_t>(old >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+    }
+
+    // Равномерно в [low, high], без смещения по модулю (метод Лемира)
+    int nextInt(int low, int high)
+    {
+        std::uint32_t range = static_cast<std::uint32_t>(high - low) + 1;
+        std::uint64_t product = static_cast<std::uint64_t>(next()) * range;
+        std::uint32_t fraction = static_cast<std::uint32_t>(product);
+        if (fraction < range)
+        {
+            std::uint32_t threshold = (0u - range) % range;
+            while (fraction < threshold)
+            {
+                product = static_cast<std::uint64_t>(next()) * range;
+                fraction = static_cast<std::uint32_t>(product);
+            }
+        }
+        return low + static_cast<int>(product >> 32);
+    }
+
+    std::uint64_t getState() const { return state; }
+    std::uint64_t getIncrement() const { return increment; }
+    void setState(std::uint64_t newState, std::uint64_t newIncrement)
+    {
+        state = newState;
+        increment = newIncrement | 1;
+    }
+
+private:
+    std::uint64_t state;
+    std::uint64_t increment;
+};
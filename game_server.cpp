@@ -0,0 +1,521 @@
+// Авторитетный сервер партий: держит тысячи досок и проверяет каждый ход
+// клиента по тем же правилам board_logic, что в игре, включая заявленное
+// число удалённых тайлов. Протокол — в server_net.h.
+//
+// По потоку на ядро (шард). У каждого шарда свой слушающий сокет на общем
+// порту (SO_REUSEPORT, соединения раскладывает ядро ОС), свой epoll и свои
+// партии, поэтому между шардами нет ни блокировок, ни общих данных, кроме
+// счётчиков для отчёта. Команды, пришедшие за одно пробуждение epoll со всех
+// соединений шарда, проверяются одной пачкой: правила и буферы каскада
+// остаются горячими в кэше, а ответы уходят одной записью на соединение.
+//
+// Использование: bigwash_server [--port N] [--threads N] [--level файл]
+//                               [--tile-types N] [--report секунд]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+
+#include "level_layout.h"
+#include "server_net.h"
+#include "server_session.h"
+
+namespace
+{
+    const int MAX_EPOLL_EVENTS = 256;
+    const int EPOLL_TIMEOUT_MS = 100; // Как часто шард проверяет флаг остановки
+
+    std::atomic<bool> stopRequested(false);
+
+    void onSignal(int)
+    {
+        stopRequested.store(true);
+    }
+
+    struct ServerOptions
+    {
+        int port = SERVER_DEFAULT_PORT;
+        int threads = 0; // 0 — по числу ядер
+        std::string levelPath = "levels/level1.txt";
+        int tileTypes = 6;
+        int reportSeconds = 5;
+    };
+
+    // Соединение и его партия
+    struct Client
+    {
+        Client(int fd, const LevelLayout& level, const SpawnPolicy& spawn) : connection(fd), session(level, spawn) {}
+
+        LineConnection connection;
+        BoardSession session;
+        bool closing = false;
+        bool writeWatched = false; // Подписан ли epoll на EPOLLOUT
+    };
+
+    // Команда из пачки одного пробуждения
+    struct Command
+    {
+        Client* client;
+        std::string line;
+    };
+
+    // Счётчики шарда; пишет шард, читает поток отчёта
+    struct ShardStats
+    {
+        std::atomic<int> sessions{ 0 };
+        std::atomic<std::uint64_t> moves{ 0 };
+        std::atomic<std::uint64_t> rejected{ 0 };
+        std::atomic<std::uint64_t> cheats{ 0 };
+        std::atomic<std::uint64_t> batches{ 0 };
+
+        std::mutex latencyMutex;
+        std::vector<std::uint32_t> latencies; // Наносекунды проверки хода с прошлого отчёта, под latencyMutex
+    };
+
+    bool parseInts(const std::string& line, std::size_t offset, long* values, int count)
+    {
+        const char* cursor = line.c_str() + offset;
+        for (int i = 0; i < count; ++i)
+        {
+            char* end = nullptr;
+            errno = 0;
+            values[i] = std::strtol(cursor, &end, 10);
+            if (end == cursor || errno != 0) return false;
+            cursor = end;
+        }
+        while (*cursor == ' ' || *cursor == '\r') ++cursor;
+        return *cursor == '\0';
+    }
+
+    bool startsWith(const std::string& line, const char* prefix)
+    {
+        return line.compare(0, std::strlen(prefix), prefix) == 0;
+    }
+
+    class Shard
+    {
+    public:
+        Shard(const ServerOptions& options, const LevelLayout& level, ShardStats& stats) :
+            options(options),
+            level(level),
+            stats(stats),
+            workspace(level.width, level.height),
+            spawn(level.spawn, options.tileTypes)
+        {
+        }
+
+        ~Shard()
+        {
+            for (auto& entry : clients) close(entry.first);
+            if (listenFd != -1) close(listenFd);
+            if (epollFd != -1) close(epollFd);
+        }
+
+        bool open();
+        void run();
+
+    private:
+        void acceptClients();
+        void readClient(Client& client);
+        void execute(Command& command);
+        void flushClient(Client& client);
+        void closeClient(Client& client);
+
+        const ServerOptions& options;
+        const LevelLayout& level;
+        ShardStats& stats;
+
+        int listenFd = -1;
+        int epollFd = -1;
+        std::unordered_map<int, std::unique_ptr<Client>> clients;
+        RuleWorkspace workspace;
+        SpawnPolicy spawn; // Таблицы досыпания уровня, общие для партий потока
+
+        // Переиспользуются между пробуждениями
+        std::vector<Command> batch;
+        std::vector<Client*> touched;
+        std::vector<std::unique_ptr<Client>> retired; // Закрытые за это пробуждение
+        std::vector<std::uint32_t> latencies;
+        std::string reply;
+        std::string line;
+    };
+
+    bool Shard::open()
+    {
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (listenFd == -1)
+        {
+            std::cerr << "socket failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == -1)
+        {
+            std::cerr << "SO_REUSEPORT is unavailable: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<std::uint16_t>(options.port));
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+            listen(listenFd, SOMAXCONN) == -1)
+        {
+            std::cerr << "Failed to listen on port " << options.port << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        epollFd = epoll_create1(0);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        if (epollFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == -1)
+        {
+            std::cerr << "epoll setup failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void Shard::run()
+    {
+        epoll_event events[MAX_EPOLL_EVENTS];
+        while (!stopRequested.load(std::memory_order_relaxed))
+        {
+            int count = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, EPOLL_TIMEOUT_MS);
+            if (count < 0)
+            {
+                if (errno == EINTR) continue;
+                std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            // Сначала читаются все готовые соединения и собирается пачка
+            for (int i = 0; i < count; ++i)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listenFd)
+                {
+                    acceptClients();
+                    continue;
+                }
+
+                auto found = clients.find(fd);
+                if (found == clients.end()) continue;
+                Client& client = *found->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    closeClient(client);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) readClient(client);
+                if ((events[i].events & EPOLLOUT) && !client.closing) flushClient(client);
+            }
+
+            // Потом вся пачка проверяется подряд
+            for (Command& command : batch)
+            {
+                if (!command.client->closing) execute(command);
+            }
+            if (!batch.empty()) stats.batches.fetch_add(1, std::memory_order_relaxed);
+            batch.clear();
+
+            for (Client* client : touched)
+            {
+                if (!client->closing) flushClient(*client);
+            }
+            touched.clear();
+
+            retired.clear();
+
+            if (!latencies.empty())
+            {
+                std::lock_guard<std::mutex> lock(stats.latencyMutex);
+                stats.latencies.insert(stats.latencies.end(), latencies.begin(), latencies.end());
+                latencies.clear();
+            }
+        }
+    }
+
+    void Shard::acceptClients()
+    {
+        for (;;)
+        {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd == -1)
+            {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+                }
+                return;
+            }
+            setNoDelay(fd);
+
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+            {
+                close(fd);
+                continue;
+            }
+            clients[fd].reset(new Client(fd, level, spawn));
+            stats.sessions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Shard::readClient(Client& client)
+    {
+        bool alive = client.connection.receive();
+        bool queued = false;
+        while (client.connection.nextLine(line))
+        {
+            batch.push_back({ &client, line });
+            queued = true;
+        }
+        if (queued) touched.push_back(&client);
+
+        if (client.connection.isOverlong())
+        {
+            client.connection.send("error line too long\n");
+            client.connection.flush();
+            alive = false;
+        }
+        // Команды, пришедшие вместе с закрытием, уже не выполняются
+        if (!alive) closeClient(client);
+    }
+
+    void Shard::execute(Command& command)
+    {
+        Client& client = *command.client;
+        BoardSession& session = client.session;
+        long values[5];
+        reply.clear();
+
+        if (startsWith(command.line, "move ") && parseInts(command.line, 5, values, 5))
+        {
+            if (!session.isStarted())
+            {
+                client.connection.send("error no game\n");
+                return;
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            BoardMove move = { static_cast<int>(values[0]), static_cast<int>(values[1]),
+                static_cast<int>(values[2]), static_cast<int>(values[3]) };
+            MoveOutcome outcome = session.applyMove(move, workspace);
+            std::uint64_t hash = session.hashBoard();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+            latencies.push_back(static_cast<std::uint32_t>(std::min<long long>(elapsed.count(), UINT32_MAX)));
+            stats.moves.fetch_add(1, std::memory_order_relaxed);
+
+            if (!outcome.legal)
+            {
+                stats.rejected.fetch_add(1, std::memory_order_relaxed);
+                client.connection.send("reject\n");
+                return;
+            }
+
+            bool honest = values[4] == outcome.cleared;
+            if (!honest) stats.cheats.fetch_add(1, std::memory_order_relaxed);
+            reply += honest ? "ok " : "cheat ";
+            reply += std::to_string(outcome.cleared);
+            reply += ' ';
+            reply += std::to_string(session.getMovesLeft());
+            reply += ' ';
+            reply += std::to_string(hash);
+            reply += '\n';
+        }
+        else if (startsWith(command.line, "start ") && parseInts(command.line, 6, values, 1))
+        {
+            session.start(static_cast<std::uint32_t>(values[0]), workspace);
+            reply += "board ";
+            reply += std::to_string(session.getMovesLeft());
+            reply += ' ';
+            reply += std::to_string(session.hashBoard());
+            for (const std::vector<int>& row : session.getTileMap())
+            {
+                for (int value : row)
+                {
+                    reply += ' ';
+                    reply += std::to_string(value);
+                }
+            }
+            reply += '\n';
+        }
+        else
+        {
+            reply = "error unknown command\n";
+        }
+        client.connection.send(reply);
+    }
+
+    void Shard::flushClient(Client& client)
+    {
+        // Клиент, который шлёт команды, но не читает ответы, копил бы их без конца
+        if (!client.connection.flush() || client.connection.isBacklogged())
+        {
+            closeClient(client);
+            return;
+        }
+
+        // Пока сокет не принял всё, ждём EPOLLOUT
+        bool needWrite = client.connection.hasOutput();
+        if (needWrite != client.writeWatched)
+        {
+            epoll_event event{};
+            std::uint32_t mask = EPOLLIN | EPOLLRDHUP;
+            if (needWrite) mask |= EPOLLOUT;
+            event.events = mask;
+            event.data.fd = client.connection.getFd();
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, client.connection.getFd(), &event);
+            client.writeWatched = needWrite;
+        }
+    }
+
+    // Клиент живёт до конца пачки: на него ещё могут ссылаться команды,
+    // а номер сокета может тут же достаться новому соединению
+    void Shard::closeClient(Client& client)
+    {
+        if (client.closing) return;
+        client.closing = true;
+        int fd = client.connection.getFd();
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        auto found = clients.find(fd);
+        retired.push_back(std::move(found->second));
+        clients.erase(found);
+        stats.sessions.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::uint32_t percentile(std::vector<std::uint32_t>& values, double fraction)
+    {
+        std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    void printReport(std::vector<std::unique_ptr<ShardStats>>& shards, double seconds, std::vector<std::uint64_t>& lastMoves)
+    {
+        std::vector<std::uint32_t> latencies;
+        int sessions = 0;
+        std::uint64_t moves = 0;
+        std::uint64_t rejected = 0;
+        std::uint64_t cheats = 0;
+        std::cout << "Sessions per shard:";
+        for (std::size_t i = 0; i < shards.size(); ++i)
+        {
+            ShardStats& shard = *shards[i];
+            int shardSessions = shard.sessions.load(std::memory_order_relaxed);
+            std::uint64_t shardMoves = shard.moves.load(std::memory_order_relaxed);
+            std::cout << ' ' << shardSessions;
+            sessions += shardSessions;
+            moves += shardMoves - lastMoves[i];
+            lastMoves[i] = shardMoves;
+            rejected += shard.rejected.load(std::memory_order_relaxed);
+            cheats += shard.cheats.load(std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(shard.latencyMutex);
+            latencies.insert(latencies.end(), shard.latencies.begin(), shard.latencies.end());
+            shard.latencies.clear();
+        }
+        std::cout << "\n  " << sessions << " sessions, " << static_cast<std::uint64_t>(moves / seconds) << " moves/s, "
+            << rejected << " rejected, " << cheats << " wrong claims";
+        if (!latencies.empty())
+        {
+            std::cout << ", validation p50 " << percentile(latencies, 0.5) / 1000.0 << " us, p99 "
+                << percentile(latencies, 0.99) / 1000.0 << " us";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) options.port = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) options.threads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--level" && hasValue) options.levelPath = argv[++i];
+        else if (arg == "--tile-types" && hasValue) options.tileTypes = std::max(3, std::atoi(argv[++i]));
+        else if (arg == "--report" && hasValue) options.reportSeconds = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            std::cerr << "Usage: bigwash_server [--port N] [--threads N] [--level file] [--tile-types N] [--report seconds]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.threads == 0)
+    {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    LevelLayout level;
+    if (!loadLevel(options.levelPath, level))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::unique_ptr<ShardStats>> stats;
+    std::vector<std::unique_ptr<Shard>> shards;
+    for (int i = 0; i < options.threads; ++i)
+    {
+        stats.emplace_back(new ShardStats());
+        shards.emplace_back(new Shard(options, level, *stats.back()));
+        if (!shards.back()->open())
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (std::unique_ptr<Shard>& shard : shards)
+    {
+        threads.emplace_back(&Shard::run, shard.get());
+    }
+    std::cout << "Serving " << options.levelPath << " on port " << options.port << " with "
+        << options.threads << " shards" << std::endl;
+
+    std::vector<std::uint64_t> lastMoves(stats.size(), 0);
+    auto lastReport = std::chrono::steady_clock::now();
+    while (!stopRequested.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastReport).count();
+        if (seconds >= options.reportSeconds)
+        {
+            printReport(stats, seconds, lastMoves);
+            lastReport = now;
+        }
+    }
+
+    for (std::thread& thread : threads) thread.join();
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "game_stats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+    const char* const CLEAR_TILE_LABELS[] = {
+        "Tile 0: ", "Tile 1: ", "Tile 2: ", "Tile 3: ", "Tile 4: ",
+        "Tile 5: ", "Tile 6: ", "Tile 7: ", "Tile 8: "
+    };
+}
+
+void GameStats::reset(const LevelGoal* levelGoals, int count)
+{
+    *this = GameStats();
+
+    if (count > MAX_GOALS)
+    {
+        std::cerr << "Too many level goals: " << count << ", only " << MAX_GOALS << " are tracked" << std::endl;
+        count = MAX_GOALS;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        goals[i] = levelGoals[i];
+        goalsOfKind[static_cast<int>(goals[i].kind)].set(i);
+        allGoals.set(i);
+        if (goals[i].target <= 0) completed.set(i);
+    }
+    goalCount = count;
+}
+
+void GameStats::restore(const LevelGoal* levelGoals, int count, const Counters& saved)
+{
+    reset(levelGoals, count);
+    counters = saved;
+    for (int kind = 0; kind < GOAL_KIND_COUNT; ++kind)
+    {
+        updateGoals(static_cast<GoalKind>(kind));
+    }
+}
+
+void GameStats::recordClears(const std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& clearMask)
+{
+    int cleared = 0;
+    for (std::size_t y = 0; y < tileMap.size(); ++y)
+    {
+        for (std::size_t x = 0; x < tileMap[y].size(); ++x)
+        {
+            // Пустые, угловые клетки и цветные бомбы не считаются
+            if (clearMask[y][x] && isMatchable(tileMap[y][x]))
+            {
+                counters.clearedByColor[tileColor(tileMap[y][x])]++;
+                cleared++;
+            }
+        }
+    }
+
+    if (cleared == 0) return;
+
+    counters.totalCleared += cleared;
+    updateGoals(GoalKind::ClearTiles);
+    updateGoals(GoalKind::ClearAnyTiles);
+}
+
+void GameStats::recordCascadeStep(int depth)
+{
+    if (depth <= counters.maxCombo) return;
+
+    counters.maxCombo = depth;
+    updateGoals(GoalKind::ReachCombo);
+}
+
+void GameStats::recordCascade(int depth)
+{
+    if (depth <= 0) return;
+
+    counters.comboHistogram[std::min(depth, MAX_COMBO_DEPTH)]++;
+    recordCascadeStep(depth);
+}
+
+void GameStats::recordSpecialCreated(SpecialTile special)
+{
+    counters.specialsCreated[static_cast<int>(special)]++;
+    updateGoals(GoalKind::CreateSpecials);
+}
+
+int GameStats::getGoalProgress(int index) const
+{
+    return std::min(currentValue(goals[index]), goals[index].target);
+}
+
+int GameStats::currentValue(const LevelGoal& goal) const
+{
+    switch (goal.kind)
+    {
+    case GoalKind::ClearTiles:
+        return goal.param >= 0 && goal.param <= MAX_TILE_TYPES ? counters.clearedByColor[goal.param] : 0;
+    case GoalKind::ClearAnyTiles:
+        return counters.totalCleared;
+    case GoalKind::ReachCombo:
+        return counters.maxCombo;
+    case GoalKind::CreateSpecials:
+    {
+        if (goal.param > 0 && goal.param < SPECIAL_TILE_KINDS) return counters.specialsCreated[goal.param];
+
+        int total = 0;
+        for (int i = 1; i < SPECIAL_TILE_KINDS; ++i) total += counters.specialsCreated[i];
+        return total;
+    }
+    }
+    return 0;
+}
+
+void GameStats::updateGoals(GoalKind kind)
+{
+    // Только невыполненные цели изменившегося вида
+    std::bitset<MAX_GOALS> pending = goalsOfKind[static_cast<int>(kind)] & ~completed;
+    for (int i = 0; pending.any() && i < goalCount; ++i)
+    {
+        if (!pending.test(i)) continue;
+
+        pending.reset(i);
+        if (currentValue(goals[i]) >= goals[i].target) completed.set(i);
+    }
+}
+
+const char* goalLabel(const LevelGoal& goal)
+{
+    switch (goal.kind)
+    {
+    case GoalKind::ClearTiles:
+        if (goal.param >= 0 && goal.param < static_cast<int>(std::size(CLEAR_TILE_LABELS))) return CLEAR_TILE_LABELS[goal.param];
+        return "Tiles: ";
+    case GoalKind::ClearAnyTiles: return "Tiles: ";
+    case GoalKind::ReachCombo: return "Combo: ";
+    case GoalKind::CreateSpecials: return "Bonus: ";
+    }
+    return "";
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <vector>
+
+#include "tile_value.h"
+
+enum class GoalKind
+{
+    ClearTiles,     // Удалить target тайлов цвета param
+    ClearAnyTiles,  // Удалить target тайлов любого цвета
+    ReachCombo,     // Дойти до каскада глубины target
+    CreateSpecials  // Создать target бонусов вида param (0 — любых)
+};
+
+const int GOAL_KIND_COUNT = 4;
+
+struct LevelGoal
+{
+    GoalKind kind;
+    int param;
+    int target;
+};
+
+const int MAX_GOALS = 8;
+// Последняя ячейка гистограммы собирает все более глубокие каскады
+const int MAX_COMBO_DEPTH = 16;
+
+// Статистика одной партии. Счётчики — плоские массивы по цвету, глубине
+// каскада и виду бонуса. Цели проверяются не опросом, а при изменении
+// счётчиков своего вида: выполненные цели отмечаются в битсете, и
+// isLevelComplete() сводится к сравнению двух масок.
+class GameStats
+{
+public:
+    // Сырые счётчики партии; сохраняются вместе с доской
+    struct Counters
+    {
+        std::array<int, MAX_TILE_TYPES + 1> clearedByColor{};
+        int totalCleared = 0;
+        std::array<int, MAX_COMBO_DEPTH + 1> comboHistogram{};
+        int maxCombo = 0;
+        std::array<int, SPECIAL_TILE_KINDS> specialsCreated{};
+    };
+
+    void reset(const LevelGoal* levelGoals, int count);
+    // Продолжить сохранённую партию: цели пересчитываются по счётчикам
+    void restore(const LevelGoal* levelGoals, int count, const Counters& saved);
+
+    // Учесть все клетки маски удаления разом, до того как они очищены на доске
+    void recordClears(const std::vector<std::vector<int>>& tileMap, const std::vector<std::vector<bool>>& clearMask);
+    // Очередной шаг каскада: цели на комбо выполняются сразу
+    void recordCascadeStep(int depth);
+    // Каскад закончился, глубина уходит в гистограмму
+    void recordCascade(int depth);
+    void recordSpecialCreated(SpecialTile special);
+
+    bool isLevelComplete() const { return goalCount > 0 && completed == allGoals; }
+
+    int getGoalCount() const { return goalCount; }
+    const LevelGoal& getGoal(int index) const { return goals[index]; }
+    bool isGoalComplete(int index) const { return completed.test(index); }
+    // Прогресс, ограниченный сверху целью
+    int getGoalProgress(int index) const;
+    int getGoalRemaining(int index) const { return goals[index].target - getGoalProgress(index); }
+
+    const Counters& getCounters() const { return counters; }
+    int getCleared(int color) const { return counters.clearedByColor[color]; }
+    int getTotalCleared() const { return counters.totalCleared; }
+    int getCascadeCount(int depth) const { return counters.comboHistogram[depth]; }
+    int getMaxCombo() const { return counters.maxCombo; }
+    int getSpecialsCreated(SpecialTile special) const { return counters.specialsCreated[static_cast<int>(special)]; }
+
+private:
+    int currentValue(const LevelGoal& goal) const;
+    void updateGoals(GoalKind kind);
+
+    Counters counters;
+
+    std::array<LevelGoal, MAX_GOALS> goals{};
+    int goalCount = 0;
+    std::array<std::bitset<MAX_GOALS>, GOAL_KIND_COUNT> goalsOfKind;
+    std::bitset<MAX_GOALS> allGoals;
+    std::bitset<MAX_GOALS> completed;
+};
+
+// Подпись цели для HUD. Строки статические, HudText сравнивает их по указателю
+const char* goalLabel(const LevelGoal& goal);
@@ -0,0 +1,262 @@
+#include "hint_worker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    // Попыток перемешать имеющиеся тайлы, затем столько же перекрасить заново
+    const int MAX_SHUFFLE_ATTEMPTS = 64;
+
+    // Надбавки к оценке хода за бонус, который он создаст
+    int shapeBonus(MatchShape shape)
+    {
+        switch (shape)
+        {
+        case MatchShape::Line4: return 5;
+        case MatchShape::LShape:
+        case MatchShape::TShape: return 8;
+        case MatchShape::Line5: return 12;
+        default: return 0;
+        }
+    }
+}
+
+HintWorker::HintWorker(int width, int height, bool synchronous) :
+    width(width),
+    height(height),
+    synchronous(synchronous),
+    pendingBoard(height, std::vector<int>(width, 0)),
+    board(height, std::vector<int>(width, 0)),
+    classifier(width, height),
+    random(std::random_device{}())
+{
+    // Доски результатов ходят по кругу между поиском, готовым результатом
+    // и вызывающим; заранее нужного размера, перемешивание не выделяет память
+    working.board = board;
+    finished.board = board;
+    shuffleCells.reserve(width * height);
+    moves.reserve(width * height * 2);
+    if (!synchronous)
+    {
+        thread = std::thread(&HintWorker::run, this);
+    }
+}
+
+HintWorker::~HintWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        requestedGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp.notify_one();
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void HintWorker::request(const std::vector<std::vector<int>>& tileMap, int tileTypeCount)
+{
+    if (synchronous)
+    {
+        // Поиск прямо в вызывающем потоке, результат готов сразу
+        std::uint32_t generation = requestedGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+        for (int y = 0; y < height; ++y)
+        {
+            std::copy(tileMap[y].begin(), tileMap[y].end(), board[y].begin());
+        }
+        tileTypes = tileTypeCount;
+        if (runJob(generation))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(finished, working);
+            finishedGeneration = generation;
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Строки уже нужного размера, копирование без выделений
+        for (int y = 0; y < height; ++y)
+        {
+            std::copy(tileMap[y].begin(), tileMap[y].end(), pendingBoard[y].begin());
+        }
+        pendingTileTypes = tileTypeCount;
+        hasPendingJob = true;
+        requestedGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp.notify_one();
+}
+
+void HintWorker::cancel()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    hasPendingJob = false;
+    requestedGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HintWorker::seed(std::uint32_t value)
+{
+    random.seed(value);
+}
+
+bool HintWorker::tryTakeResult(HintResult& result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::uint32_t generation = requestedGeneration.load(std::memory_order_relaxed);
+    if (finishedGeneration != generation) return false;
+
+    std::swap(result, finished);
+    finishedGeneration = generation - 1; // Выдан, повторно не отдаём
+    return true;
+}
+
+void HintWorker::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeUp.wait(lock, [this] { return stopping || hasPendingJob; });
+        if (stopping) return;
+
+        std::uint32_t generation = requestedGeneration.load(std::memory_order_relaxed);
+        hasPendingJob = false;
+        for (int y = 0; y < height; ++y)
+        {
+            std::copy(pendingBoard[y].begin(), pendingBoard[y].end(), board[y].begin());
+        }
+        tileTypes = pendingTileTypes;
+        lock.unlock();
+
+        bool completed = runJob(generation);
+
+        lock.lock();
+        if (completed && !isCancelled(generation))
+        {
+            std::swap(finished, working);
+            finishedGeneration = generation;
+        }
+    }
+}
+
+// Поиск хода, а если его нет — перемешивание. false — задача отменена.
+bool HintWorker::runJob(std::uint32_t generation)
+{
+    working.hasMove = false;
+    working.shuffled = false;
+    working.score = 0;
+    working.moveCount = 0;
+    bool completed = search(generation);
+    if (completed && !working.hasMove)
+    {
+        completed = shuffle(generation);
+    }
+    return completed;
+}
+
+// Оценивает все легальные ходы по правилам доски и оставляет лучший.
+// false — задача отменена.
+bool HintWorker::search(std::uint32_t generation)
+{
+    if (isCancelled(generation)) return false;
+    findPossibleMoves(board, moves);
+    working.moveCount = static_cast<int>(moves.size());
+
+    for (const BoardMove& move : moves)
+    {
+        if (isCancelled(generation)) return false;
+
+        int score = scoreSwap(move.fromX, move.fromY, move.toX, move.toY);
+        if (score > working.score)
+        {
+            working.hasMove = true;
+            working.score = score;
+            working.from = { move.fromX, move.fromY };
+            working.to = { move.toX, move.toY };
+        }
+    }
+    return true;
+}
+
+int HintWorker::scoreSwap(int ax, int ay, int bx, int by)
+{
+    int first = board[ay][ax];
+    int second = board[by][bx];
+    if (isColorBombSwap(first, second))
+    {
+        // Цветная бомба ценится по числу тайлов цвета, который она уберёт;
+        // цель та же, что выберет resolveMove
+        int target = 0;
+        if (tileSpecial(first) == SpecialTile::ColorBomb) target = tileColor(second);
+        if (tileSpecial(second) == SpecialTile::ColorBomb) target = tileColor(first);
+        int count = 0;
+        for (const auto& row : board)
+        {
+            if (target == 0) break; // Бомба на бомбу: цвета нет
+            count += static_cast<int>(std::count_if(row.begin(), row.end(), [target](int v) { return tileColor(v) == target; }));
+        }
+        return 20 + count;
+    }
+
+    std::swap(board[ay][ax], board[by][bx]);
+    int score = 0;
+    int groupCount = classifier.classify(board, ax, ay, bx, by);
+    for (int i = 0; i < groupCount; ++i)
+    {
+        const MatchGroup& group = classifier.getGroup(i);
+        score += group.size + shapeBonus(group.shape);
+    }
+    std::swap(board[ay][ax], board[by][bx]);
+    return score;
+}
+
+// Ищет доску без готовых совпадений, но с ходом. Сначала переставляет
+// имеющиеся тайлы, потом перекрашивает. false — задача отменена.
+bool HintWorker::shuffle(std::uint32_t generation)
+{
+    std::vector<std::vector<int>>& result = working.board;
+    result = board;
+
+    std::vector<int>& cells = shuffleCells;
+    cells.clear();
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            if (isMatchable(board[y][x]) && tileSpecial(board[y][x]) == SpecialTile::None) cells.push_back(y * width + x);
+
+    std::uniform_int_distribution<> color(1, std::max(tileTypes, 1));
+    for (int attempt = 0; attempt < 2 * MAX_SHUFFLE_ATTEMPTS; ++attempt)
+    {
+        if (isCancelled(generation)) return false;
+
+        if (attempt < MAX_SHUFFLE_ATTEMPTS)
+        {
+            // Fisher–Yates по значениям обычных тайлов
+            for (int i = static_cast<int>(cells.size()) - 1; i > 0; --i)
+            {
+                int j = std::uniform_int_distribution<>(0, i)(random);
+                int a = cells[i], b = cells[j];
+                std::swap(board[a / width][a % width], board[b / width][b % width]);
+            }
+        }
+        else
+        {
+            for (int cell : cells) board[cell / width][cell % width] = color(random);
+        }
+
+        if (classifier.classify(board) > 0) continue;
+
+        working.moveCount = 0;
+        working.score = 0;
+        if (!search(generation)) return false;
+        if (working.hasMove)
+        {
+            result = board;
+            working.shuffled = true;
+            return true;
+        }
+    }
+    return true; // Не нашлось: отдаём пустой результат, решает симуляция
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "board_logic.h"
+#include "match_classifier.h"
+
+// Результат фонового поиска подсказки для одной доски
+struct HintResult
+{
+    bool hasMove = false;
+    sf::Vector2i from = { -1, -1 };
+    sf::Vector2i to = { -1, -1 };
+    int score = 0;          // Оценка лучшего хода
+    int moveCount = 0;      // Сколько всего легальных ходов на доске
+    bool shuffled = false;  // Ходов не было, board — перемешанная доска.
+                            // Если и перемешать не вышло, hasMove и shuffled ложны.
+    std::vector<std::vector<int>> board;
+};
+
+// Фоновый поиск и ранжирование подсказок. Симуляция отдаёт копию доски,
+// как только каскад закончился, и забирает готовый результат, когда
+// истекает таймер бездействия; кадр никогда не ждёт поиска. Новый запрос
+// или cancel() поднимают номер поколения, и устаревшая задача бросает
+// работу при следующей проверке. Если ходов нет, здесь же ищется
+// перемешивание с ограниченным числом попыток.
+// В синхронном режиме потока нет и request() считает всё сразу —
+// так воспроизводимые прогоны не зависят от расписания потоков.
+class HintWorker
+{
+public:
+    HintWorker(int width, int height, bool synchronous = false);
+    ~HintWorker();
+
+    HintWorker(const HintWorker&) = delete;
+    HintWorker& operator=(const HintWorker&) = delete;
+
+    // Начать поиск по доске; предыдущая задача отменяется
+    void request(const std::vector<std::vector<int>>& tileMap, int tileTypeCount);
+    // Доска изменилась, текущий результат больше не нужен
+    void cancel();
+    // Зерно генератора перемешивания; вызывать до первого запроса
+    void seed(std::uint32_t value);
+
+    // Не блокирует. true, если результат для последнего запроса готов;
+    // результат отдаётся один раз. Доска result обменивается с внутренней,
+    // поэтому постоянный result с доской нужного размера не выделяет память.
+    bool tryTakeResult(HintResult& result);
+
+private:
+    void run();
+    bool runJob(std::uint32_t generation);
+    bool search(std::uint32_t generation);
+    bool shuffle(std::uint32_t generation);
+    int scoreSwap(int ax, int ay, int bx, int by);
+    bool isCancelled(std::uint32_t generation) const { return requestedGeneration.load(std::memory_order_relaxed) != generation; }
+
+    int width;
+    int height;
+    bool synchronous;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::atomic<std::uint32_t> requestedGeneration{ 0 };
+    bool hasPendingJob = false;           // Под mutex
+    std::uint32_t finishedGeneration = 0; // Под mutex
+    bool stopping = false;                // Под mutex
+    std::vector<std::vector<int>> pendingBoard; // Под mutex
+    int pendingTileTypes = 0;                   // Под mutex
+    HintResult finished;                        // Под mutex
+
+    // Принадлежат потоку поиска
+    std::vector<std::vector<int>> board;
+    int tileTypes = 0;
+    MatchClassifier classifier;
+    HintResult working;
+    std::vector<int> shuffleCells; // Клетки обычных тайлов для перемешивания
+    std::vector<BoardMove> moves;  // Легальные ходы доски из findPossibleMoves
+    std::mt19937 random;
+
+    std::thread thread;
+};
@@ -0,0 +1,197 @@
+#include "hud_text.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+    void addGlyphQuad(sf::VertexArray& vertices, sf::Vector2f position, const sf::Color& color,
+        const sf::Glyph& glyph, float outlineThickness)
+    {
+        // Как в sf::Text: небольшой запас вокруг глифа против обрезания
+        const float padding = 1.0f;
+
+        float left = glyph.bounds.left - padding;
+        float top = glyph.bounds.top - padding;
+        float right = glyph.bounds.left + glyph.bounds.width + padding;
+        float bottom = glyph.bounds.top + glyph.bounds.height + padding;
+
+        float u1 = static_cast<float>(glyph.textureRect.left) - padding;
+        float v1 = static_cast<float>(glyph.textureRect.top) - padding;
+        float u2 = static_cast<float>(glyph.textureRect.left + glyph.textureRect.width) + padding;
+        float v2 = static_cast<float>(glyph.textureRect.top + glyph.textureRect.height) + padding;
+
+        float x = position.x - outlineThickness;
+        float y = position.y - outlineThickness;
+
+        vertices.append(sf::Vertex(sf::Vector2f(x + left, y + top), color, sf::Vector2f(u1, v1)));
+        vertices.append(sf::Vertex(sf::Vector2f(x + right, y + top), color, sf::Vector2f(u2, v1)));
+        vertices.append(sf::Vertex(sf::Vector2f(x + right, y + bottom), color, sf::Vector2f(u2, v2)));
+        vertices.append(sf::Vertex(sf::Vector2f(x + left, y + bottom), color, sf::Vector2f(u1, v2)));
+    }
+}
+
+GlyphCache::GlyphCache(const sf::Font& font, unsigned characterSize, float outlineThickness, const char* alphabet) :
+    font(font),
+    characterSize(characterSize),
+    outlineThickness(outlineThickness)
+{
+    for (const char* c = alphabet; *c; ++c)
+    {
+        int index = static_cast<unsigned char>(*c) - FIRST_CHAR;
+        if (index < 0 || index >= CHAR_COUNT || baked[index]) continue;
+
+        fillGlyphs[index] = font.getGlyph(static_cast<sf::Uint32>(*c), characterSize, false);
+        if (outlineThickness != 0)
+        {
+            outlineGlyphs[index] = font.getGlyph(static_cast<sf::Uint32>(*c), characterSize, false, outlineThickness);
+        }
+        baked[index] = true;
+    }
+}
+
+const sf::Glyph* GlyphCache::getFill(char c) const
+{
+    int index = static_cast<unsigned char>(c) - FIRST_CHAR;
+    return index >= 0 && index < CHAR_COUNT && baked[index] ? &fillGlyphs[index] : nullptr;
+}
+
+const sf::Glyph* GlyphCache::getOutline(char c) const
+{
+    int index = static_cast<unsigned char>(c) - FIRST_CHAR;
+    return index >= 0 && index < CHAR_COUNT && baked[index] && outlineThickness != 0 ? &outlineGlyphs[index] : nullptr;
+}
+
+HudText::HudText(const GlyphCache& glyphs, sf::Color fillColor, sf::Color outlineColor) :
+    glyphs(glyphs),
+    fillColor(fillColor),
+    outlineColor(outlineColor),
+    vertices(sf::Quads)
+{
+    // Сразу резервируем место под самую длинную строку: обводка + заливка
+    vertices.resize(MAX_LENGTH * 8);
+    vertices.clear();
+}
+
+void HudText::setPosition(sf::Vector2f newPosition)
+{
+    position = newPosition;
+    if (hasValue) rebuild();
+}
+
+void HudText::setNumber(int value)
+{
+    setText(nullptr, value, 0, false);
+}
+
+void HudText::setFraction(const char* label, int current, int required)
+{
+    setText(label, current, required, true);
+}
+
+void HudText::setText(const char* label, int first, int second, bool isFraction)
+{
+    if (hasValue && label == shownLabel && first == shownFirst &&
+        second == shownSecond && isFraction == shownFraction)
+    {
+        return; // Значение не изменилось, вершины остаются прежними
+    }
+
+    shownLabel = label;
+    shownFirst = first;
+    shownSecond = second;
+    shownFraction = isFraction;
+    hasValue = true;
+
+    // Форматирование в фиксированный буфер без std::string
+    char* end = text + MAX_LENGTH;
+    char* out = text;
+    if (label)
+    {
+        std::size_t labelLength = std::min<std::size_t>(std::strlen(label), MAX_LENGTH / 2);
+        std::memcpy(out, label, labelLength);
+        out += labelLength;
+    }
+    out = std::to_chars(out, end, first).ptr;
+    if (isFraction && out < end)
+    {
+        *out++ = '/';
+        out = std::to_chars(out, end, second).ptr;
+    }
+    length = static_cast<int>(out - text);
+
+    rebuild();
+}
+
+void HudText::rebuild()
+{
+    vertices.clear();
+
+    // Базовая линия, как у sf::Text, на высоте размера шрифта
+    const float baseline = position.y + static_cast<float>(glyphs.getCharacterSize());
+
+    // Сначала обводка, поверх неё заливка
+    if (glyphs.getOutlineThickness() != 0)
+    {
+        float x = position.x;
+        for (int i = 0; i < length; ++i)
+        {
+            const sf::Glyph* fill = glyphs.getFill(text[i]);
+            const sf::Glyph* outline = glyphs.getOutline(text[i]);
+            if (!fill || !outline) continue;
+            addGlyphQuad(vertices, sf::Vector2f(x, baseline), outlineColor, *outline, glyphs.getOutlineThickness());
+            x += fill->advance;
+        }
+    }
+
+    float x = position.x;
+    for (int i = 0; i < length; ++i)
+    {
+        const sf::Glyph* fill = glyphs.getFill(text[i]);
+        if (!fill) continue;
+        addGlyphQuad(vertices, sf::Vector2f(x, baseline), fillColor, *fill, 0);
+        x += fill->advance;
+    }
+}
+
+void HudText::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    states.texture = &glyphs.getTexture();
+    target.draw(vertices, states);
+}
+
+GoalListHud::GoalListHud(const GlyphCache& glyphs, sf::Color fillColor, sf::Color outlineColor,
+    sf::Vector2f position, float lineSpacing) :
+    lines{
+        HudText(glyphs, fillColor, outlineColor),
+        HudText(glyphs, fillColor, outlineColor),
+        HudText(glyphs, fillColor, outlineColor),
+        HudText(glyphs, fillColor, outlineColor)
+    }
+{
+    for (int i = 0; i < MAX_GOAL_LINES; ++i)
+    {
+        lines[i].setPosition(sf::Vector2f(position.x, position.y + i * lineSpacing));
+    }
+}
+
+void GoalListHud::setLineCount(int count)
+{
+    lineCount = std::clamp(count, 0, static_cast<int>(MAX_GOAL_LINES));
+}
+
+void GoalListHud::setLine(int index, const char* label, int current, int required)
+{
+    if (index < 0 || index >= MAX_GOAL_LINES) return;
+
+    lines[index].setFraction(label, current, required);
+}
+
+void GoalListHud::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    for (int i = 0; i < lineCount; ++i)
+    {
+        target.draw(lines[i], states);
+    }
+}
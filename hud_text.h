@@ -0,0 +1,87 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// Глифы одного шрифта, размера и обводки, запечённые заранее. После
+// создания кэша текстура шрифта этого размера больше не растёт, и строки
+// HUD собираются из готовых прямоугольников без обращений к FreeType.
+class GlyphCache
+{
+public:
+    GlyphCache(const sf::Font& font, unsigned characterSize, float outlineThickness, const char* alphabet);
+
+    const sf::Texture& getTexture() const { return font.getTexture(characterSize); }
+    unsigned getCharacterSize() const { return characterSize; }
+    float getOutlineThickness() const { return outlineThickness; }
+
+    // nullptr, если символ не запечён
+    const sf::Glyph* getFill(char c) const;
+    const sf::Glyph* getOutline(char c) const;
+
+private:
+    static const int FIRST_CHAR = 32;
+    static const int CHAR_COUNT = 95; // Печатные символы ASCII
+
+    const sf::Font& font;
+    unsigned characterSize;
+    float outlineThickness;
+    sf::Glyph fillGlyphs[CHAR_COUNT];
+    sf::Glyph outlineGlyphs[CHAR_COUNT];
+    bool baked[CHAR_COUNT] = {};
+};
+
+// Строка HUD: число или "подпись текущее/нужно". Геометрия хранится в
+// кэше вершин и перестраивается только когда меняется значение.
+class HudText : public sf::Drawable
+{
+public:
+    HudText(const GlyphCache& glyphs, sf::Color fillColor, sf::Color outlineColor);
+
+    void setPosition(sf::Vector2f newPosition);
+    void setNumber(int value);
+    void setFraction(const char* label, int current, int required);
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    void setText(const char* label, int first, int second, bool isFraction);
+    void rebuild();
+
+    static const int MAX_LENGTH = 48;
+
+    const GlyphCache& glyphs;
+    sf::Color fillColor;
+    sf::Color outlineColor;
+    sf::Vector2f position;
+
+    // Последнее показанное значение, чтобы не перестраивать одинаковое
+    const char* shownLabel = nullptr;
+    int shownFirst = 0;
+    int shownSecond = 0;
+    bool shownFraction = false;
+    bool hasValue = false;
+
+    char text[MAX_LENGTH];
+    int length = 0;
+    sf::VertexArray vertices;
+};
+
+// Несколько строк целей уровня. Строки заводятся один раз под максимум
+// целей, каждый кадр обновляются только изменившиеся счётчики.
+class GoalListHud : public sf::Drawable
+{
+public:
+    static const int MAX_GOAL_LINES = 4;
+
+    GoalListHud(const GlyphCache& glyphs, sf::Color fillColor, sf::Color outlineColor,
+        sf::Vector2f position, float lineSpacing);
+
+    // Строки, не попавшие в count, не рисуются
+    void setLineCount(int count);
+    void setLine(int index, const char* label, int current, int required);
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    HudText lines[MAX_GOAL_LINES];
+    int lineCount = 0;
+};
@@ -0,0 +1,86 @@
+#include "latency_probe.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace
+{
+    const char* const STAGE_NAMES[LATENCY_STAGE_COUNT] =
+    {
+        "injected", "poll", "queue", "simulate", "pickup", "draw", "present"
+    };
+
+    std::int64_t nanoseconds(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    void printRow(std::ostream& out, const char* name, std::vector<std::int64_t> values)
+    {
+        if (values.empty()) return;
+        std::sort(values.begin(), values.end());
+        auto at = [&values](double q)
+        {
+            std::size_t index = static_cast<std::size_t>(q * (values.size() - 1) + 0.5);
+            return values[index] / 1e6;
+        };
+        out << std::setw(10) << name << std::fixed << std::setprecision(2)
+            << "  p50 " << std::setw(7) << at(0.5) << "  p95 " << std::setw(7) << at(0.95)
+            << "  p99 " << std::setw(7) << at(0.99) << "  max " << std::setw(7) << values.back() / 1e6 << '\n';
+    }
+}
+
+LatencyProbe::LatencyProbe(int sampleCount) :
+    sampleCount(std::max(sampleCount, 1))
+{
+    for (std::atomic<std::int64_t>& stamp : stamps) stamp.store(0, std::memory_order_relaxed);
+    for (std::vector<std::int64_t>& stage : stages) stage.reserve(this->sampleCount);
+    totals.reserve(this->sampleCount);
+}
+
+std::uint32_t LatencyProbe::begin(std::chrono::steady_clock::time_point injectedAt)
+{
+    std::uint32_t tag = nextTag++;
+    for (std::atomic<std::int64_t>& stamp : stamps) stamp.store(0, std::memory_order_relaxed);
+    stamps[static_cast<int>(LatencyStage::Injected)].store(nanoseconds(injectedAt), std::memory_order_relaxed);
+    pendingTag.store(tag, std::memory_order_release);
+    return tag;
+}
+
+void LatencyProbe::mark(std::uint32_t tag, LatencyStage stage)
+{
+    if (tag == 0 || tag != pendingTag.load(std::memory_order_acquire)) return;
+
+    std::int64_t expected = 0;
+    std::int64_t now = nanoseconds(std::chrono::steady_clock::now());
+    stamps[static_cast<int>(stage)].compare_exchange_strong(expected, now, std::memory_order_acq_rel);
+    if (stage != LatencyStage::Presented) return;
+
+    std::int64_t times[LATENCY_STAGE_COUNT];
+    for (int i = 0; i < LATENCY_STAGE_COUNT; ++i) times[i] = stamps[i].load(std::memory_order_acquire);
+    // Отметка пропущенного этапа берётся от следующего: длительность 0
+    for (int i = LATENCY_STAGE_COUNT - 2; i > 0; --i)
+    {
+        if (times[i] == 0) times[i] = times[i + 1];
+    }
+    for (int i = 1; i < LATENCY_STAGE_COUNT; ++i)
+    {
+        stages[i].push_back(times[i] - times[i - 1]);
+    }
+    totals.push_back(times[LATENCY_STAGE_COUNT - 1] - times[0]);
+    pendingTag.store(0, std::memory_order_release);
+}
+
+void LatencyProbe::printReport(std::ostream& out) const
+{
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Input to display latency, " << totals.size() << " swaps, ms:\n";
+    for (int i = 1; i < LATENCY_STAGE_COUNT; ++i)
+    {
+        printRow(out, STAGE_NAMES[i], stages[i]);
+    }
+    printRow(out, "total", totals);
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Этапы пути ввода до экрана, в порядке прохождения
+enum class LatencyStage
+{
+    Injected,  // Событие «пришло» в систему
+    Queued,    // Отрисовка опросила событие и отдаёт его слою ввода
+    Handled,   // Симуляция применила намерение
+    Published, // Снимок с его результатом отдан отрисовке
+    PickedUp,  // Отрисовка взяла этот снимок
+    Drawn,     // Кадр со снимком нарисован, перед display()
+    Presented, // display() вернулся
+};
+const int LATENCY_STAGE_COUNT = 7;
+
+// Замер задержки от ввода до показанного кадра. Метка ввода идёт вместе
+// с намерением в симуляцию и обратно в снимке, и каждый поток отмечает
+// время своего этапа. В пути одна метка за раз: следующий ввод подаётся
+// после того, как предыдущий показан, поэтому отметки — атомики одной
+// текущей метки, без таблиц и блокировок. Первая отметка этапа остаётся.
+class LatencyProbe
+{
+public:
+    explicit LatencyProbe(int sampleCount);
+
+    // Новая метка, время прихода события — injectedAt
+    std::uint32_t begin(std::chrono::steady_clock::time_point injectedAt);
+    // Из любого потока; чужие и устаревшие метки пропускаются.
+    // Отметка Presented закрывает замер.
+    void mark(std::uint32_t tag, LatencyStage stage);
+    // Бросить метку в пути без замера
+    void cancel() { pendingTag.store(0, std::memory_order_release); }
+
+    // Метка в пути или 0
+    std::uint32_t getPendingTag() const { return pendingTag.load(std::memory_order_acquire); }
+    bool isBusy() const { return getPendingTag() != 0; }
+    bool isComplete() const { return static_cast<int>(totals.size()) >= sampleCount; }
+    int getSampleCount() const { return static_cast<int>(totals.size()); }
+
+    // Перцентили длительности каждого этапа и всего пути, мс
+    void printReport(std::ostream& out) const;
+
+private:
+    int sampleCount;
+    std::uint32_t nextTag = 1;
+    std::atomic<std::uint32_t> pendingTag{ 0 };
+    std::atomic<std::int64_t> stamps[LATENCY_STAGE_COUNT]; // Наносекунды steady_clock, 0 — ещё нет
+
+    // Пишет только поток, отметивший Presented
+    std::vector<std::int64_t> stages[LATENCY_STAGE_COUNT]; // [i] — от этапа i - 1 до i, [0] не используется
+    std::vector<std::int64_t> totals;
+};
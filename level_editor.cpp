@@ -0,0 +1,238 @@
+#include "level_editor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    const sf::Color BLOCKED_SHADE(20, 10, 40, 230);
+    const sf::Color RANDOM_SHADE(255, 255, 255, 60);
+    const sf::Color BOARD_SHADE(40, 20, 80, 200);
+
+    const char* const GOAL_KIND_NAMES[GOAL_KIND_COUNT] = { "clear color", "clear any", "combo", "specials" };
+
+    void addQuad(sf::VertexArray& vertices, sf::Vector2f position, sf::Vector2f size, sf::Color color)
+    {
+        vertices.append(sf::Vertex(position, color));
+        vertices.append(sf::Vertex(sf::Vector2f(position.x + size.x, position.y), color));
+        vertices.append(sf::Vertex(position + size, color));
+        vertices.append(sf::Vertex(sf::Vector2f(position.x, position.y + size.y), color));
+    }
+}
+
+LevelEditor::LevelEditor(const TextureAtlas& atlas, const sf::Font& font, sf::Vector2f origin, float cellSize, int tileTypeCount) :
+    atlas(atlas),
+    font(font),
+    origin(origin),
+    cellSize(cellSize),
+    tileTypes(tileTypeCount),
+    solver(tileTypeCount),
+    cellShades(sf::Quads),
+    presetTiles(atlas)
+{
+    panel.setFont(font);
+    panel.setCharacterSize(22);
+    panel.setFillColor(sf::Color::White);
+    panel.setOutlineColor(sf::Color(107, 70, 213));
+    panel.setOutlineThickness(2);
+    panel.setPosition(1000, 100);
+}
+
+void LevelEditor::open(const LevelLayout& newLayout)
+{
+    layout = newLayout;
+    selectedGoal = 0;
+    painting = false;
+    edited();
+}
+
+void LevelEditor::handleEvent(const sf::Event& event, const sf::RenderWindow& window)
+{
+    switch (event.type)
+    {
+    case sf::Event::MouseButtonPressed:
+    {
+        bool erase = event.mouseButton.button == sf::Mouse::Right;
+        if (!erase && event.mouseButton.button != sf::Mouse::Left) break;
+        painting = true;
+        paintValue = erase ? 0 : brushValue();
+        paint(window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y)), paintValue);
+        break;
+    }
+    case sf::Event::MouseMoved:
+        if (painting) paint(window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y)), paintValue);
+        break;
+    case sf::Event::MouseButtonReleased:
+    case sf::Event::LostFocus:
+        painting = false;
+        break;
+    case sf::Event::KeyPressed:
+    {
+        sf::Keyboard::Key key = event.key.code;
+        int step = event.key.shift ? 10 : 1;
+        LevelGoal* goal = selectedGoal < layout.goalCount ? &layout.goals[selectedGoal] : nullptr;
+
+        if (key == sf::Keyboard::B) brush = Brush::Blocked;
+        else if (key == sf::Keyboard::Num0) brush = Brush::Random;
+        else if (key >= sf::Keyboard::Num1 && key <= sf::Keyboard::Num8 && key - sf::Keyboard::Num0 <= tileTypes)
+        {
+            brush = Brush::Color;
+            brushColor = key - sf::Keyboard::Num0;
+        }
+        else if (key == sf::Keyboard::G && layout.goalCount < MAX_GOALS)
+        {
+            layout.goals[layout.goalCount] = { GoalKind::ClearTiles, 1, 10 };
+            selectedGoal = layout.goalCount++;
+            edited();
+        }
+        else if (key == sf::Keyboard::Tab && layout.goalCount > 0)
+        {
+            selectedGoal = (selectedGoal + 1) % layout.goalCount;
+        }
+        else if (key == sf::Keyboard::Delete && goal)
+        {
+            std::copy(layout.goals + selectedGoal + 1, layout.goals + layout.goalCount, layout.goals + selectedGoal);
+            layout.goalCount--;
+            selectedGoal = std::max(0, std::min(selectedGoal, layout.goalCount - 1));
+            edited();
+        }
+        else if (key == sf::Keyboard::K && goal)
+        {
+            goal->kind = static_cast<GoalKind>((static_cast<int>(goal->kind) + 1) % GOAL_KIND_COUNT);
+            goal->param = goal->kind == GoalKind::ClearTiles ? 1 : 0;
+            edited();
+        }
+        else if (key == sf::Keyboard::P && goal)
+        {
+            // Цвет для ClearTiles, вид бонуса для CreateSpecials (0 — любой)
+            if (goal->kind == GoalKind::ClearTiles) goal->param = goal->param % tileTypes + 1;
+            else if (goal->kind == GoalKind::CreateSpecials) goal->param = (goal->param + 1) % SPECIAL_TILE_KINDS;
+            edited();
+        }
+        else if ((key == sf::Keyboard::Up || key == sf::Keyboard::Down) && goal)
+        {
+            goal->target = std::max(1, goal->target + (key == sf::Keyboard::Up ? step : -step));
+            edited();
+        }
+        else if (key == sf::Keyboard::PageUp || key == sf::Keyboard::PageDown)
+        {
+            layout.moves = std::max(1, layout.moves + (key == sf::Keyboard::PageUp ? step : -step));
+            edited();
+        }
+        rebuildPanel();
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void LevelEditor::update()
+{
+    if (solver.tryTakeEstimate(estimate))
+    {
+        rebuildPanel();
+    }
+}
+
+void LevelEditor::paint(sf::Vector2f point, int value)
+{
+    int x = static_cast<int>(std::floor((point.x - origin.x) / cellSize));
+    int y = static_cast<int>(std::floor((point.y - origin.y) / cellSize));
+    if (x < 0 || x >= layout.width || y < 0 || y >= layout.height) return;
+
+    int& cell = layout.cells[y * layout.width + x];
+    if (cell == value) return; // Протяжка по той же клетке — не правка
+    cell = value;
+    edited();
+}
+
+int LevelEditor::brushValue() const
+{
+    switch (brush)
+    {
+    case Brush::Blocked: return BLOCKED_TILE;
+    case Brush::Color: return brushColor;
+    default: return 0;
+    }
+}
+
+void LevelEditor::edited()
+{
+    solver.submit(layout);
+    estimate = SolverEstimate();
+    rebuildCells();
+    rebuildPanel();
+}
+
+void LevelEditor::rebuildCells()
+{
+    cellShades.clear();
+    presetTiles.clear();
+    addQuad(cellShades, origin, sf::Vector2f(layout.width * cellSize, layout.height * cellSize), BOARD_SHADE);
+
+    for (int y = 0; y < layout.height; ++y)
+    {
+        for (int x = 0; x < layout.width; ++x)
+        {
+            sf::Vector2f position(origin.x + x * cellSize, origin.y + y * cellSize);
+            int value = layout.cell(x, y);
+            if (value == BLOCKED_TILE)
+            {
+                addQuad(cellShades, position, sf::Vector2f(cellSize, cellSize), BLOCKED_SHADE);
+            }
+            else if (value == 0)
+            {
+                addQuad(cellShades, position + sf::Vector2f(2, 2), sf::Vector2f(cellSize - 4, cellSize - 4), RANDOM_SHADE);
+            }
+            else if (const sf::IntRect* region = atlas.getTileRegion(value))
+            {
+                presetTiles.add(*region, position);
+            }
+        }
+    }
+}
+
+void LevelEditor::rebuildPanel()
+{
+    std::ostringstream text;
+    text << "LEVEL EDITOR (F3 - play, Ctrl+S - save)\n";
+    text << "Brush: ";
+    if (brush == Brush::Blocked) text << "blocked";
+    else if (brush == Brush::Random) text << "random";
+    else text << "color " << brushColor;
+    text << "\nMoves: " << layout.moves << "\n\nGoals:\n";
+    for (int i = 0; i < layout.goalCount; ++i)
+    {
+        const LevelGoal& goal = layout.goals[i];
+        text << (i == selectedGoal ? "> " : "  ") << GOAL_KIND_NAMES[static_cast<int>(goal.kind)];
+        if (goal.kind == GoalKind::ClearTiles || goal.kind == GoalKind::CreateSpecials) text << ' ' << goal.param;
+        text << ": " << goal.target << '\n';
+    }
+    if (layout.goalCount == 0) text << "  none (G - add)\n";
+
+    text << "\nSolver, random player:\n";
+    float weight = estimate.playouts + estimate.priorWeight;
+    if (weight < 1.0f)
+    {
+        text << "  estimating...\n";
+    }
+    else
+    {
+        // Полуширина 95% интервала для доли
+        float margin = 1.96f * std::sqrt(estimate.winRate * (1.0f - estimate.winRate) / weight);
+        text << "  win " << static_cast<int>(estimate.winRate * 100.0f + 0.5f) << "% +-"
+            << static_cast<int>(margin * 100.0f + 0.5f) << "%\n";
+        text << "  dead boards " << static_cast<int>(estimate.deadBoardRate * 100.0f + 0.5f) << "%\n";
+        text << "  " << estimate.playouts << " games" << (estimate.converged ? "" : "...") << '\n';
+    }
+    panel.setString(text.str());
+}
+
+void LevelEditor::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    target.draw(cellShades, states);
+    presetTiles.draw(target);
+    target.draw(panel, states);
+}
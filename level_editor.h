@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "level_layout.h"
+#include "level_solver.h"
+#include "texture_atlas.h"
+
+// Редактор уровня поверх игрового поля (F3). Мышью рисуется кисть по
+// клеткам, клавишами меняются кисть, цели и число ходов. После каждой
+// правки раскладка уходит фоновому решателю, и его оценка (доля побед
+// случайного игрока и частота досок без ходов) обновляется в панели
+// по мере игры.
+//
+// Клавиши: B — кисть «закрытая клетка», 0 — «случайный тайл», 1..8 —
+// поставленный цвет; правая кнопка мыши — стереть в случайный тайл.
+// G — добавить цель, Tab — следующая цель, K — вид цели, P — параметр,
+// Up/Down — величина цели (с Shift по 10), Delete — убрать цель,
+// PageUp/PageDown — число ходов. Ctrl+S (в main) сохраняет уровень.
+class LevelEditor : public sf::Drawable
+{
+public:
+    LevelEditor(const TextureAtlas& atlas, const sf::Font& font, sf::Vector2f origin, float cellSize, int tileTypeCount);
+
+    // Начать правку с этой раскладки
+    void open(const LevelLayout& layout);
+    const LevelLayout& getLayout() const { return layout; }
+
+    void handleEvent(const sf::Event& event, const sf::RenderWindow& window);
+    // Забирает свежую оценку решателя и обновляет панель
+    void update();
+
+private:
+    enum class Brush
+    {
+        Blocked,
+        Random,
+        Color
+    };
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    void paint(sf::Vector2f point, int value);
+    int brushValue() const;
+    void edited();
+    void rebuildCells();
+    void rebuildPanel();
+
+    const TextureAtlas& atlas;
+    const sf::Font& font;
+    sf::Vector2f origin;
+    float cellSize;
+    int tileTypes;
+
+    LevelLayout layout;
+    LevelSolver solver;
+    SolverEstimate estimate;
+
+    Brush brush = Brush::Blocked;
+    int brushColor = 1;
+    int selectedGoal = 0;
+    bool painting = false;
+    int paintValue = 0;
+
+    sf::VertexArray cellShades; // Подложка поля: закрытые и случайные клетки
+    SpriteBatch presetTiles;
+    sf::Text panel;
+};
@@ -0,0 +1,254 @@
+#include "level_layout.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const char* const LEVEL_HEADER = "bigwash-level";
+    const int LEVEL_VERSION = 1;
+    const int MAX_LEVEL_SIDE = 16;
+
+    char cellSymbol(int value)
+    {
+        if (value == BLOCKED_TILE) return '#';
+        if (value == 0) return '.';
+        return static_cast<char>('0' + tileColor(value));
+    }
+}
+
+LevelLayout makeLevelLayout(int width, int height, const char* const* rows,
+    const LevelGoal* goals, int goalCount, int moves)
+{
+    LevelLayout layout;
+    layout.width = width;
+    layout.height = height;
+    layout.cells.assign(width * height, 0);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (rows[y][x] == '#') layout.cells[y * width + x] = BLOCKED_TILE;
+        }
+    }
+    layout.goalCount = std::min(goalCount, MAX_GOALS);
+    std::copy(goals, goals + layout.goalCount, layout.goals);
+    layout.moves = moves;
+    return layout;
+}
+
+BoardShape makeBoardShape(const LevelLayout& layout)
+{
+    std::vector<std::string> rows(layout.height, std::string(layout.width, '.'));
+    std::vector<const char*> pointers;
+    for (int y = 0; y < layout.height; ++y)
+    {
+        for (int x = 0; x < layout.width; ++x)
+        {
+            if (layout.isBlocked(x, y)) rows[y][x] = '#';
+        }
+        pointers.push_back(rows[y].c_str());
+    }
+    return BoardShape(layout.width, layout.height, pointers.data());
+}
+
+std::uint64_t hashLevelLayout(const LevelLayout& layout)
+{
+    // FNV-1a по всем полям, которые влияют на партию
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](std::int64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            hash = (hash ^ static_cast<std::uint8_t>(value >> (8 * i))) * 1099511628211ULL;
+        }
+    };
+
+    mix(layout.width);
+    mix(layout.height);
+    for (int value : layout.cells) mix(value);
+    mix(layout.moves);
+    mix(layout.goalCount);
+    for (int i = 0; i < layout.goalCount; ++i)
+    {
+        mix(static_cast<int>(layout.goals[i].kind));
+        mix(layout.goals[i].param);
+        mix(layout.goals[i].target);
+    }
+    // Правила досыпания меняют оценку решателя; без них хэш прежний
+    if (!layout.spawn.isUniform())
+    {
+        mix(static_cast<int>(layout.spawn.neighbours));
+        mix(static_cast<std::int64_t>(layout.spawn.boost * 1000.0f));
+        for (const SpawnPhase& phase : layout.spawn.phases)
+        {
+            mix(phase.fromMove);
+            for (int i = 0; i < phase.weightCount; ++i) mix(static_cast<std::int64_t>(phase.weights[i] * 1000.0f));
+        }
+    }
+    return hash;
+}
+
+int countChangedCells(const LevelLayout& first, const LevelLayout& second)
+{
+    if (first.width != second.width || first.height != second.height) return -1;
+
+    int changed = 0;
+    for (std::size_t i = 0; i < first.cells.size(); ++i)
+    {
+        changed += first.cells[i] != second.cells[i] ? 1 : 0;
+    }
+    return changed;
+}
+
+bool loadLevel(const std::string& path, LevelLayout& layout)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string header, key;
+    int version = 0;
+    LevelLayout loaded;
+    if (!(file >> header >> version) || header != LEVEL_HEADER || version != LEVEL_VERSION)
+    {
+        std::cerr << "Level " << path << " has an unknown format" << std::endl;
+        return false;
+    }
+
+    while (file >> key && key != "rows")
+    {
+        bool ok = true;
+        if (key == "size")
+        {
+            ok = static_cast<bool>(file >> loaded.width >> loaded.height) &&
+                loaded.width >= 3 && loaded.width <= MAX_LEVEL_SIDE && loaded.height >= 3 && loaded.height <= MAX_LEVEL_SIDE;
+        }
+        else if (key == "moves")
+        {
+            ok = static_cast<bool>(file >> loaded.moves) && loaded.moves > 0;
+        }
+        else if (key == "goal")
+        {
+            int kind = 0;
+            LevelGoal goal = {};
+            ok = loaded.goalCount < MAX_GOALS && static_cast<bool>(file >> kind >> goal.param >> goal.target) &&
+                kind >= 0 && kind < GOAL_KIND_COUNT && goal.target > 0;
+            goal.kind = static_cast<GoalKind>(kind);
+            if (ok) loaded.goals[loaded.goalCount++] = goal;
+        }
+        else if (key == "spawn")
+        {
+            // Веса до конца строки, их число — до MAX_TILE_TYPES
+            SpawnPhase phase;
+            std::string rest;
+            std::getline(file, rest);
+            std::istringstream line(rest);
+            ok = static_cast<bool>(line >> phase.fromMove) && phase.fromMove >= 0;
+            float weight = 0.0f;
+            while (ok && line >> weight)
+            {
+                ok = phase.weightCount < MAX_TILE_TYPES && weight >= 0.0f;
+                if (ok) phase.weights[phase.weightCount++] = weight;
+            }
+            ok = ok && line.eof();
+            if (ok) loaded.spawn.phases.push_back(phase);
+        }
+        else if (key == "neighbours")
+        {
+            std::string rest, mode;
+            std::getline(file, rest);
+            std::istringstream line(rest);
+            ok = static_cast<bool>(line >> mode);
+            if (mode == "avoid") loaded.spawn.neighbours = SpawnNeighbours::Avoid;
+            else if (mode == "encourage") loaded.spawn.neighbours = SpawnNeighbours::Encourage;
+            else if (mode == "ignore") loaded.spawn.neighbours = SpawnNeighbours::Ignore;
+            else ok = false;
+            if (ok && !(line >> loaded.spawn.boost)) loaded.spawn.boost = SpawnRules().boost;
+            ok = ok && loaded.spawn.boost > 0.0f;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Level " << path << " has a bad '" << key << "' line" << std::endl;
+            return false;
+        }
+    }
+
+    if (key != "rows" || loaded.width == 0)
+    {
+        std::cerr << "Level " << path << " has no board" << std::endl;
+        return false;
+    }
+
+    loaded.cells.assign(loaded.width * loaded.height, 0);
+    for (int y = 0; y < loaded.height; ++y)
+    {
+        std::string row;
+        if (!(file >> row) || static_cast<int>(row.size()) != loaded.width)
+        {
+            std::cerr << "Level " << path << " has a bad row " << y << std::endl;
+            return false;
+        }
+        for (int x = 0; x < loaded.width; ++x)
+        {
+            char symbol = row[x];
+            int& value = loaded.cells[y * loaded.width + x];
+            if (symbol == '#') value = BLOCKED_TILE;
+            else if (symbol >= '1' && symbol <= '0' + MAX_TILE_TYPES) value = symbol - '0';
+            else if (symbol != '.')
+            {
+                std::cerr << "Level " << path << " has an unknown cell '" << symbol << "'" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    layout = loaded;
+    return true;
+}
+
+bool saveLevel(const std::string& path, const LevelLayout& layout)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to write level " << path << std::endl;
+        return false;
+    }
+
+    file << LEVEL_HEADER << ' ' << LEVEL_VERSION << '\n';
+    file << "size " << layout.width << ' ' << layout.height << '\n';
+    file << "moves " << layout.moves << '\n';
+    for (int i = 0; i < layout.goalCount; ++i)
+    {
+        const LevelGoal& goal = layout.goals[i];
+        file << "goal " << static_cast<int>(goal.kind) << ' ' << goal.param << ' ' << goal.target << '\n';
+    }
+    for (const SpawnPhase& phase : layout.spawn.phases)
+    {
+        file << "spawn " << phase.fromMove;
+        for (int i = 0; i < phase.weightCount; ++i) file << ' ' << phase.weights[i];
+        file << '\n';
+    }
+    if (layout.spawn.neighbours != SpawnNeighbours::Ignore)
+    {
+        file << "neighbours " << (layout.spawn.neighbours == SpawnNeighbours::Avoid ? "avoid" : "encourage")
+            << ' ' << layout.spawn.boost << '\n';
+    }
+    file << "rows\n";
+    for (int y = 0; y < layout.height; ++y)
+    {
+        for (int x = 0; x < layout.width; ++x)
+        {
+            file << cellSymbol(layout.cell(x, y));
+        }
+        file << '\n';
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board_shape.h"
+#include "game_stats.h"
+#include "spawn_policy.h"
+
+// Раскладка уровня: форма поля, заранее поставленные тайлы, цели и ходы.
+// Её правит редактор, по ней начинается партия и её же оценивает решатель.
+struct LevelLayout
+{
+    int width = 0;
+    int height = 0;
+    std::vector<int> cells; // BLOCKED_TILE — закрытая, 0 — случайный тайл, иначе поставленный цвет
+    LevelGoal goals[MAX_GOALS] = {};
+    int goalCount = 0;
+    int moves = 20;
+    SpawnRules spawn; // Веса новых тайлов по фазам и учёт соседей
+
+    int cell(int x, int y) const { return cells[y * width + x]; }
+    bool isBlocked(int x, int y) const { return cell(x, y) == BLOCKED_TILE; }
+};
+
+// Раскладка из строк формы ('#' — закрытая клетка), без поставленных тайлов
+LevelLayout makeLevelLayout(int width, int height, const char* const* rows,
+    const LevelGoal* goals, int goalCount, int moves);
+BoardShape makeBoardShape(const LevelLayout& layout);
+// Хэш содержимого; одинаковые раскладки дают одинаковый хэш
+std::uint64_t hashLevelLayout(const LevelLayout& layout);
+// Сколько клеток различается; -1, если размеры разные
+int countChangedCells(const LevelLayout& first, const LevelLayout& second);
+
+// Текстовый формат:
+//   bigwash-level 1
+//   size 7 7
+//   moves 20
+//   goal <вид> <параметр> <цель>     (по строке на цель)
+//   spawn <с хода> <вес 1> <вес 2> ...  (фаза весов цветов, необязательно)
+//   neighbours avoid|encourage [усиление]   (необязательно)
+//   rows
+//   ##...##                          ('#' закрытая, '.' случайный, '1'..'8' цвет)
+bool loadLevel(const std::string& path, LevelLayout& layout);
+bool saveLevel(const std::string& path, const LevelLayout& layout);
@@ -0,0 +1,231 @@
+#include "level_solver.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    const int PUBLISH_EVERY = 16;           // Партий между отправками оценки
+    const int MAX_SHUFFLE_ATTEMPTS = 64;
+}
+
+LevelSolver::LevelSolver(int tileTypeCount) :
+    tileTypes(tileTypeCount),
+    random(static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())),
+    thread(&LevelSolver::run, this)
+{
+}
+
+LevelSolver::~LevelSolver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+}
+
+void LevelSolver::submit(const LevelLayout& newLayout)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingLayout = newLayout;
+        hasPendingLayout = true;
+    }
+    wakeUp.notify_one();
+}
+
+bool LevelSolver::tryTakeEstimate(SolverEstimate& estimate)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasNewEstimate) return false;
+
+    estimate = latest;
+    hasNewEstimate = false;
+    return true;
+}
+
+void LevelSolver::run()
+{
+    Tally* tally = nullptr;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Оценка сошлась — спим до следующей правки
+            bool idle = !tally || tally->playouts >= TARGET_PLAYOUTS;
+            if (idle)
+            {
+                wakeUp.wait(lock, [this] { return stopping || hasPendingLayout; });
+            }
+            if (stopping) return;
+
+            if (hasPendingLayout)
+            {
+                previousLayout = std::move(layout);
+                layout = pendingLayout;
+                hasPendingLayout = false;
+                lock.unlock();
+
+                startLayout();
+                tally = &findOrAddTally(hashLevelLayout(layout));
+                publish(*tally);
+            }
+        }
+
+        for (int i = 0; i < PUBLISH_EVERY && tally->playouts < TARGET_PLAYOUTS; ++i)
+        {
+            bool deadBoard = false;
+            bool won = playout(deadBoard);
+            tally->playouts++;
+            tally->wins += won ? 1 : 0;
+            tally->deadBoards += deadBoard ? 1 : 0;
+        }
+        publish(*tally);
+    }
+}
+
+// Готовит буферы под раскладку и считает априорную оценку по прошлой
+void LevelSolver::startLayout()
+{
+    if (tileMap.size() != static_cast<std::size_t>(layout.height) ||
+        (layout.height > 0 && tileMap[0].size() != static_cast<std::size_t>(layout.width)))
+    {
+        tileMap.assign(layout.height, std::vector<int>(layout.width, 0));
+        classifier.reset(new MatchClassifier(layout.width, layout.height));
+    }
+    spawn = SpawnPolicy(layout.spawn, tileTypes);
+
+    // Цели и ходы меняют партию целиком, тогда переносить нечего
+    priorWeight = 0.0f;
+    int changed = countChangedCells(previousLayout, layout);
+    bool sameRules = changed >= 0 && previousLayout.moves == layout.moves && previousLayout.goalCount == layout.goalCount &&
+        sameSpawnRules(previousLayout.spawn, layout.spawn) &&
+        std::equal(layout.goals, layout.goals + layout.goalCount, previousLayout.goals,
+            [](const LevelGoal& a, const LevelGoal& b) { return a.kind == b.kind && a.param == b.param && a.target == b.target; });
+    if (!sameRules) return;
+
+    const Tally* previous = nullptr;
+    std::uint64_t previousHash = hashLevelLayout(previousLayout);
+    for (const Tally& entry : cache)
+    {
+        if (entry.playouts > 0 && entry.hash == previousHash) previous = &entry;
+    }
+    if (!previous) return;
+
+    // Вес падает квадратично с долей изменённых клеток
+    float similarity = 1.0f - static_cast<float>(changed) / std::max<std::size_t>(layout.cells.size(), 1);
+    int carried = previous->playouts < PRIOR_CAP ? previous->playouts : PRIOR_CAP;
+    priorWeight = carried * similarity * similarity;
+    priorWinRate = static_cast<float>(previous->wins) / previous->playouts;
+    priorDeadRate = static_cast<float>(previous->deadBoards) / previous->playouts;
+}
+
+LevelSolver::Tally& LevelSolver::findOrAddTally(std::uint64_t hash)
+{
+    Tally* oldest = &cache[0];
+    for (Tally& entry : cache)
+    {
+        if (entry.playouts > 0 && entry.hash == hash)
+        {
+            entry.lastUse = ++useCounter;
+            return entry;
+        }
+        if (entry.lastUse < oldest->lastUse) oldest = &entry;
+    }
+
+    *oldest = Tally();
+    oldest->hash = hash;
+    oldest->lastUse = ++useCounter;
+    return *oldest;
+}
+
+void LevelSolver::publish(const Tally& tally)
+{
+    SolverEstimate estimate;
+    estimate.layoutHash = tally.hash;
+    estimate.playouts = tally.playouts;
+    // Чем больше своих партий, тем меньше доверия прошлой раскладке
+    estimate.priorWeight = priorWeight * std::max(0.0f, 1.0f - static_cast<float>(tally.playouts) / PRIOR_CAP);
+
+    float total = estimate.priorWeight + tally.playouts;
+    if (total > 0.0f)
+    {
+        estimate.winRate = (estimate.priorWeight * priorWinRate + tally.wins) / total;
+        estimate.deadBoardRate = (estimate.priorWeight * priorDeadRate + tally.deadBoards) / total;
+    }
+    estimate.converged = tally.playouts >= TARGET_PLAYOUTS;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    latest = estimate;
+    hasNewEstimate = true;
+}
+
+// Одна партия случайного игрока. true — цели выполнены.
+bool LevelSolver::playout(bool& deadBoard)
+{
+    for (int y = 0; y < layout.height; ++y)
+    {
+        for (int x = 0; x < layout.width; ++x)
+        {
+            tileMap[y][x] = layout.cell(x, y);
+        }
+    }
+    spawn.setMovesMade(0);
+    refillEmpty(tileMap, spawn, random, scratch.filled);
+
+    // Как в игре: начальные совпадения снимаются и засчитываются в цели
+    stats.reset(layout.goals, layout.goalCount);
+    settleBoard(tileMap, *classifier, spawn, random, scratch, &stats);
+
+    deadBoard = false;
+    for (int movesLeft = layout.moves; movesLeft > 0 && !stats.isLevelComplete(); )
+    {
+        findPossibleMoves(tileMap, moves);
+        if (moves.empty())
+        {
+            // В игре доску перемешивает поиск подсказки
+            deadBoard = true;
+            if (!shuffleBoard()) break;
+            continue;
+        }
+
+        const BoardMove& move = moves[random.nextInt(0, static_cast<int>(moves.size()) - 1)];
+        // Как в игре: фаза досыпания переключается до каскада хода
+        spawn.setMovesMade(layout.moves - movesLeft + 1);
+        resolveMove(tileMap, *classifier, spawn, random, move, scratch, &stats);
+        movesLeft--;
+    }
+    return stats.isLevelComplete();
+}
+
+// Перестановка обычных тайлов до доски без совпадений, но с ходом
+bool LevelSolver::shuffleBoard()
+{
+    shuffleCells.clear();
+    for (int y = 0; y < layout.height; ++y)
+    {
+        for (int x = 0; x < layout.width; ++x)
+        {
+            int value = tileMap[y][x];
+            if (isMatchable(value) && tileSpecial(value) == SpecialTile::None) shuffleCells.push_back(y * layout.width + x);
+        }
+    }
+
+    for (int attempt = 0; attempt < MAX_SHUFFLE_ATTEMPTS; ++attempt)
+    {
+        for (int i = static_cast<int>(shuffleCells.size()) - 1; i > 0; --i)
+        {
+            int j = random.nextInt(0, i);
+            int a = shuffleCells[i];
+            int b = shuffleCells[j];
+            std::swap(tileMap[a / layout.width][a % layout.width], tileMap[b / layout.width][b % layout.width]);
+        }
+        if (hasMatches(tileMap)) continue;
+
+        findPossibleMoves(tileMap, moves);
+        if (!moves.empty()) return true;
+    }
+    return false;
+}
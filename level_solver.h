@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "board_logic.h"
+#include "level_layout.h"
+
+// Оценка раскладки по случайным партиям
+struct SolverEstimate
+{
+    std::uint64_t layoutHash = 0;
+    int playouts = 0;          // Сыграно для этой раскладки
+    float priorWeight = 0.0f;  // Сколько партий перенесено с прошлой раскладки
+    float winRate = 0.0f;      // Доля партий, где цели выполнены за отведённые ходы
+    float deadBoardRate = 0.0f; // Доля партий, где доска хоть раз осталась без ходов
+    bool converged = false;    // Сыграно TARGET_PLAYOUTS, дальше решатель ждёт правки
+};
+
+// Фоновая оценка уровня для редактора. Игрок в партии делает случайный
+// легальный ход, правила — те же board_logic, что в игре. После каждой
+// правки оценка начинается заново и приходит пачками по мере игры, первые
+// цифры — за доли секунды.
+//
+// Старая работа переиспользуется двумя способами. Раскладки, которые уже
+// встречались (например, правку отменили), берутся из кэша по хэшу вместе
+// со всеми сыгранными партиями. Для новой раскладки прошлая оценка служит
+// априорной: её вес тем меньше, чем больше клеток изменилось, и по мере
+// новых партий он перестаёт влиять на результат.
+class LevelSolver
+{
+public:
+    static const int TARGET_PLAYOUTS = 2000;
+
+    explicit LevelSolver(int tileTypeCount);
+    ~LevelSolver();
+
+    LevelSolver(const LevelSolver&) = delete;
+    LevelSolver& operator=(const LevelSolver&) = delete;
+
+    // Новая раскладка после правки; текущая оценка бросается
+    void submit(const LevelLayout& layout);
+    // Не блокирует. true, если с прошлого вызова оценка обновилась.
+    bool tryTakeEstimate(SolverEstimate& estimate);
+
+private:
+    // Сыгранные партии одной раскладки
+    struct Tally
+    {
+        std::uint64_t hash = 0;
+        int playouts = 0;
+        int wins = 0;
+        int deadBoards = 0;
+        std::uint64_t lastUse = 0; // Для вытеснения из кэша
+    };
+
+    static const int CACHE_SIZE = 32;
+    static const int PRIOR_CAP = 200; // Больше партий с прошлой раскладки не переносится
+
+    void run();
+    void startLayout();
+    bool playout(bool& deadBoard);
+    bool shuffleBoard();
+    Tally& findOrAddTally(std::uint64_t hash);
+    void publish(const Tally& tally);
+
+    int tileTypes;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    LevelLayout pendingLayout;       // Под mutex
+    bool hasPendingLayout = false;   // Под mutex
+    bool stopping = false;           // Под mutex
+    SolverEstimate latest;           // Под mutex
+    bool hasNewEstimate = false;     // Под mutex
+
+    // Принадлежат потоку решателя
+    LevelLayout layout;
+    LevelLayout previousLayout;
+    float priorWeight = 0.0f;
+    float priorWinRate = 0.0f;
+    float priorDeadRate = 0.0f;
+    Tally cache[CACHE_SIZE];
+    std::uint64_t useCounter = 0;
+    std::vector<std::vector<int>> tileMap;
+    std::unique_ptr<MatchClassifier> classifier; // Под размер текущей раскладки
+    CascadeScratch scratch;
+    std::vector<BoardMove> moves;
+    std::vector<int> shuffleCells;
+    GameStats stats;
+    SpawnPolicy spawn;               // По правилам текущей раскладки
+    GameRandom random;
+
+    std::thread thread;
+};
@@ -5,31 +5,103 @@
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
-#include <map>
-#include <future>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <cstdlib>
+#include <chrono>
+
+#include "triple_buffer.h"
+#include "spsc_queue.h"
+#include "texture_atlas.h"
+#include "hud_text.h"
+#include "particle_system.h"
+#include "match_classifier.h"
+#include "game_stats.h"
+#include "board_shape.h"
+#include "board_input.h"
+#include "hint_worker.h"
+#include "game_random.h"
+#include "save_game.h"
+#include "tile_shader.h"
+#include "replay.h"
+#include "row_stream.h"
+#include "level_layout.h"
+#include "level_editor.h"
+#include "render_scaler.h"
+#include "telemetry.h"
+#include "telemetry_exporter.h"
+#include "board_logic.h"
+#include "cascade_timeline.h"
+#include "alloc_counter.h"
+#include "frame_arena.h"
+#include "latency_probe.h"
+#include "flow_scheduler.h"
 
 const int HEIGHT_MAP = 7;
 const int WIDTH_MAP = 7;
 
-std::map<int, int> removedTilesCount;
+const int SQUARE_SIZE = 84;
+const int START_X = 397;
+const int START_Y = 99;
+
+// Форма поля по умолчанию, '#' — угловые клетки. Обычно уровень
+// читается из LEVEL_PATH, эта раскладка — на случай, если файла нет.
+const char* const BOARD_ROWS[HEIGHT_MAP] = {
+    "##...##",
+    "#.....#",
+    ".......",
+    ".......",
+    ".......",
+    "#.....#",
+    "##...##"
+};
 
-std::map<int, int> firstLevelGoals = {
-       {1, 10}, // Удалить 10 тайлов типа 1
-       //{2, 5},  // Удалить 5 тайлов типа 2
-       //{3, 8}   // Удалить 8 тайлов типа 3
+const BoardShape BOARD_SHAPE(WIDTH_MAP, HEIGHT_MAP, BOARD_ROWS);
+const char* const LEVEL_PATH = "levels/level1.txt";
+
+// В бесконечном режиме поле прямоугольное: ряды целиком уезжают вверх
+const char* const ENDLESS_ROWS[HEIGHT_MAP] = {
+    ".......",
+    ".......",
+    ".......",
+    ".......",
+    ".......",
+    ".......",
+    "......."
 };
 
-int goal = 10;
+const BoardShape ENDLESS_SHAPE(WIDTH_MAP, HEIGHT_MAP, ENDLESS_ROWS);
+const int ENDLESS_LOOKAHEAD_ROWS = 2 * HEIGHT_MAP; // Сколько рядов генерируется заранее
+
+// Размер сцены в единицах раскладки: все позиции выше и в отрисовке
+// заданы в них. Окно может быть любым, сцена вписывается в него через
+// sf::View (см. ResolutionScaler).
+const unsigned SCENE_WIDTH = 1366;
+const unsigned SCENE_HEIGHT = 770;
 
-const std::map<int, sf::IntRect> tileTextureMap = {
-    {1, sf::IntRect(0 * 64, 0, 64, 64)},
-    {2, sf::IntRect(1 * 64, 0, 64, 64)},
-    {3, sf::IntRect(2 * 64, 0, 64, 64)},
-    {4, sf::IntRect(3 * 64, 0, 64, 64)},
-    {5, sf::IntRect(4 * 64, 0, 64, 64)},
-    {6, sf::IntRect(5 * 64, 0, 64, 64)}
+const float SIMULATION_STEP = 1.0f / 120.0f; // Шаг потока симуляции
+const std::size_t FRAME_ARENA_BYTES = 16 * 1024; // Память временных данных шага
+const float END_SCREEN_SECONDS = 3.0f; // Сколько показывается Game Over / Level Complete
+const float HINT_IDLE_SECONDS = 5.0f; // Бездействие до подсказки
+
+const LevelGoal FIRST_LEVEL_GOALS[] = {
+       { GoalKind::ClearTiles, 1, 10 }, // Удалить 10 тайлов типа 1
+       //{ GoalKind::ClearTiles, 2, 5 },  // Удалить 5 тайлов типа 2
+       //{ GoalKind::ReachCombo, 0, 3 },  // Каскад из трёх шагов
 };
 
+// Сколько типов тайлов выпадает на поле. Берётся из атласа (tile1..tileN)
+// до запуска потока симуляции и дальше не меняется.
+int tileTypeCount = 6;
+
+// Печатать доску в консоль после каждого заполнения, каскада и
+// перемешивания (--print-boards). По умолчанию выключено: вывод идёт
+// из шага симуляции и не должен стоить ему времени и памяти.
+bool printBoards = false;
+
 enum class TileState
 {
     Idle,
@@ -39,6 +111,12 @@ enum class TileState
     Falling
 };
 
+const int TILE_STATE_COUNT = 5;
+
+const float TILE_MOVE_SPEED = 1000.0f; // Скорость обмена тайлов, пикселей в секунду
+const float TILE_REMOVE_SPEED = 2.0f;  // Исчезновение за 1/2 секунды
+const float TILE_FALL_SPEED = 500.0f;  // Скорость падения, пикселей в секунду
+
 class AnimationHandler
 {
 public:
@@ -48,15 +126,17 @@ public:
         scale(1.0f),
         alpha(255.0f),
         state(TileState::Idle),
-        fallSpeed(500.0f), // Скорость падения
-        moveSpeed(2.0f),    // Скорость перемещения
-        removeSpeed(2.0f),  // Скорость удаления
+        fallSpeed(TILE_FALL_SPEED),
         appearSpeed(1.0f)   // Скорость появления
     {
     }
 
-    void update(float deltaTime)
+    // Возвращает вид анимации, завершившейся на этом шаге, иначе Idle.
+    // now — время симуляции после шага, от него отсчитываются новые анимации.
+    TileState update(float deltaTime, float now)
     {
+        time = now;
+        TileState previous = state;
         if (state != TileState::Idle)
         {
             // Обновляем анимацию только для активных тайлов
@@ -68,12 +148,15 @@ public:
             default: break;
             }
         }
+        return state == TileState::Idle ? previous : TileState::Idle;
     }
 
     void startMoving(const sf::Vector2f& newTarget)
     {
         targetPos = newTarget;
         state = TileState::Moving;
+        sf::Vector2f delta = targetPos - currentPos;
+        startTrack(currentPos, targetPos, std::sqrt(delta.x * delta.x + delta.y * delta.y) / TILE_MOVE_SPEED);
     }
 
     void startRemoving()
@@ -81,6 +164,7 @@ public:
         state = TileState::Removing;
         scale = 1.0f;
         alpha = 255.0f;
+        startTrack(currentPos, currentPos, 1.0f / TILE_REMOVE_SPEED);
     }
 
     void startAppearing()
@@ -88,35 +172,42 @@ public:
         state = TileState::Appearing;
         scale = 0.0f;
         alpha = 0.0f;
+        startTrack(currentPos, currentPos, 1.0f / appearSpeed);
     }
 
     void startFalling(const sf::Vector2f& newTarget)
     {
         targetPos = newTarget;
         state = TileState::Falling;
+        // Падающий тайл всегда виден целиком, даже если ячейка только что очищена
+        scale = 1.0f;
+        alpha = 255.0f;
+        startTrack(currentPos, targetPos, std::max(0.0f, targetPos.y - currentPos.y) / fallSpeed);
     }
 
     void setPosition(float x, float y)
     {
-        currentPos = { x, y };
-        targetPos = { x, y };
+        setPosition(sf::Vector2f(x, y));
     }
 
     void setPosition(const sf::Vector2f& position)
     {
         currentPos = position;
         targetPos = position;
+        startTrack(position, position, 0.0f);
+        track.kind = static_cast<int>(TileState::Idle);
     }
 
+    // Текущая анимация в замкнутой форме, для отрисовки шейдером
+    const TileTrack& getTrack() const { return track; }
+    float getTime() const { return time; }
+    void setTime(float now) { time = now; }
+
     void setScale(float scaleX, float scaleY) {
         this->scaleX = scaleX;
         this->scaleY = scaleY;
     }
 
-    /*void setRemovalCallback(std::function<void()> callback) {
-        removalCallback = callback;
-    }*/
-
     float getScaleX() const { return scaleX; }
     float getScaleY() const { return scaleY; }
 
@@ -131,8 +222,6 @@ public:
     bool isFinished() const { return state == TileState::Idle; } // Добавлено
 
     // Методы для изменения скорости анимации
-    void setMoveSpeed(float speed) { moveSpeed = speed; }
-    void setRemoveSpeed(float speed) { removeSpeed = speed; }
     void setAppearSpeed(float speed) { appearSpeed = speed; }
     void setFallSpeed(float speed) { fallSpeed = speed; }
 
@@ -149,18 +238,15 @@ private:
         }
         else {
             // Двигаемся к цели с постоянной скоростью
-            float speed = 1000.0f; // Скорость перемещения (можно настроить)
             sf::Vector2f direction = delta / distance; // Нормализуем вектор направления
-            currentPos += direction * speed * deltaTime; // Двигаемся к цели
+            currentPos += direction * TILE_MOVE_SPEED * deltaTime; // Двигаемся к цели
         }
     }
 
-    std::function<void()> removalCallback;
-
     void updateRemoving(float deltaTime)
     {
-        scale = std::max(0.0f, scale - 2.0f * deltaTime);
-        alpha = std::max(0.0f, alpha - 255.0f * 2.0f * deltaTime);
+        scale = std::max(0.0f, scale - TILE_REMOVE_SPEED * deltaTime);
+        alpha = std::max(0.0f, alpha - 255.0f * TILE_REMOVE_SPEED * deltaTime);
 
         if (scale <= 0.0f) {
             scale = 0.0f;
@@ -204,23 +290,27 @@ private:
     float alpha;
     TileState state;
     float fallSpeed; // Скорость падения
-    float moveSpeed; // Скорость перемещения
-    float removeSpeed; // Скорость удаления
     float appearSpeed; // Скорость появления
     float scaleX = 1.0f;
     float scaleY = 1.0f;
+
+    float time = 0.0f; // Время симуляции последнего шага
+    TileTrack track;
+
+    void startTrack(const sf::Vector2f& from, const sf::Vector2f& to, float duration)
+    {
+        track.kind = static_cast<int>(state);
+        track.from = from;
+        track.to = to;
+        track.startTime = time;
+        track.duration = duration;
+    }
 };
 
 class Tile
 {
 public:
     Tile() : value(0) {
-        sprite.setOrigin(sprite.getLocalBounds().width / 2, sprite.getLocalBounds().height / 2);
-    }
-
-    void setTexture(const sf::Texture& texture)
-    {
-        sprite.setTexture(texture);
     }
 
     void setValue(int val)
@@ -230,35 +320,26 @@ public:
 
     void setPosition(float x, float y)
     {
-        // Учитываем точку привязки спрайта
-        sprite.setPosition(x + sprite.getLocalBounds().width / 2, y + sprite.getLocalBounds().height / 2);
         animator.setPosition({ x, y });
         animator.setTargetPosition({ x, y });
     }
 
-    void update(float deltaTime) {
-        animator.update(deltaTime);
+    TileState update(float deltaTime, float now) {
+        TileState finished = animator.update(deltaTime, now);
 
         if (isSelected) {
             // Анимация пульсации
-            float time = selectTimer.getElapsedTime().asSeconds();
+            float time = animator.getTime() - selectStart;
             float scale = 1.0f + 0.1f * sin(time * 10.0f); // Пульсация масштаба
             animator.setScale(scale, scale);
 
             // Случайное смещение для эффекта дрожи
             float shakeX = (rand() % 5 - 2) * 0.5f;
             float shakeY = (rand() % 5 - 2) * 0.5f;
-            sprite.setPosition(animator.getPosition() + sf::Vector2f(shakeX, shakeY));
+            shakeOffset = sf::Vector2f(shakeX, shakeY);
         }
 
-        applyVisualState();
-    }
-
-    void applyVisualState()
-    {
-        sprite.setPosition(animator.getPosition());
-        sprite.setScale(animator.getScaleX(), animator.getScaleY());
-        sprite.setColor(sf::Color(255, 255, 255, static_cast<sf::Uint8>(animator.getAlpha())));
+        return finished;
     }
 
     void startMoving(const sf::Vector2f& target)
@@ -278,27 +359,37 @@ public:
 
     void startSelectAnimation() {
         isSelected = true;
-        selectTimer.restart();
+        selectStart = animator.getTime();
     }
 
     void stopSelectAnimation() {
         isSelected = false;
         animator.setScale(1.0f, 1.0f);
-        sprite.setPosition(animator.getPosition());
+        shakeOffset = sf::Vector2f(0.0f, 0.0f);
     }
 
     void resetAnimation() {
         animator.setScale(1.0f, 1.0f);
-        sprite.setPosition(animator.getPosition());
+        shakeOffset = sf::Vector2f(0.0f, 0.0f);
     }
 
     AnimationHandler& getAnimator() { return animator; }
+    const AnimationHandler& getAnimator() const { return animator; }
     bool isRemoving() const { return animator.getState() == TileState::Removing; }
     bool isFalling() const { return animator.getState() == TileState::Falling; }
 
     int getValue() const { return value; }
     TileState getState() const { return animator.getState(); }
     sf::Vector2f getPosition() const { return animator.getPosition(); }
+    // Позиция для отрисовки с учётом дрожи выделенного тайла
+    sf::Vector2f getVisualPosition() const { return animator.getPosition() + shakeOffset; }
+    TileTrack getTrack() const
+    {
+        TileTrack track = animator.getTrack();
+        track.value = value;
+        track.selectStart = isSelected ? selectStart : -1.0f;
+        return track;
+    }
     void startFalling(const sf::Vector2f& target)
     {
         animator.startFalling(target);
@@ -308,13 +399,13 @@ public:
         animator.setPosition(target);
     }
 
-    sf::Sprite sprite;
     bool isSelected = false;
-    sf::Clock selectTimer;
+    float selectStart = 0.0f; // Время симуляции начала выделения
 
 private:
     int value;
     AnimationHandler animator;
+    sf::Vector2f shakeOffset;
 };
 
 struct LastMove
@@ -323,979 +414,2084 @@ struct LastMove
     int targetX = -1, targetY = -1;
 };
 
-void revertSwap(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles, LastMove& lastMove) {
+void revertSwap(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles, LastMove& lastMove,
+    int squareSize, int startX, int startY) {
     // Откатываем обмен
     std::swap(tiles[lastMove.selectedY][lastMove.selectedX], tiles[lastMove.targetY][lastMove.targetX]);
     std::swap(tileMap[lastMove.selectedY][lastMove.selectedX], tileMap[lastMove.targetY][lastMove.targetX]);
 
     // Возвращаем тайлы на их исходные позиции
-    tiles[lastMove.selectedY][lastMove.selectedX].startMoving(tiles[lastMove.selectedY][lastMove.selectedX].getPosition());
-    tiles[lastMove.targetY][lastMove.targetX].startMoving(tiles[lastMove.targetY][lastMove.targetX].getPosition());
+    tiles[lastMove.selectedY][lastMove.selectedX].startMoving(sf::Vector2f(startX + lastMove.selectedX * squareSize, startY + lastMove.selectedY * squareSize));
+    tiles[lastMove.targetY][lastMove.targetX].startMoving(sf::Vector2f(startX + lastMove.targetX * squareSize, startY + lastMove.targetY * squareSize));
 }
 
-bool isSquareSelected(int x, int y, int mouseX, int mouseY, int squareSize, int startX, int startY)
+sf::Color hexToColor(const std::string& hexColor)
 {
-    return mouseX >= startX + x * squareSize && mouseX < startX + (x + 1) * squareSize &&
-        mouseY >= startY + y * squareSize && mouseY < startY + (y + 1) * squareSize;
+    std::string color = hexColor;
+    if (color[0] == '#') color.erase(0, 1);
+    if (color.length() != 6) return sf::Color::Black;
+
+    unsigned int r, g, b;
+    std::stringstream ss;
+    ss << std::hex << color.substr(0, 2); ss >> r; ss.clear();
+    ss << std::hex << color.substr(2, 2); ss >> g; ss.clear();
+    ss << std::hex << color.substr(4, 2); ss >> b;
+
+    return sf::Color(r, g, b);
 }
 
-void updateTileSprite(Tile& tile, const sf::Texture& clothesTexture)
+// Цвет осколков для типа тайла
+sf::Color tileParticleColor(int tileType)
 {
-    if (tile.getValue() >= 1 && tile.getValue() <= 6)
-    {
-        if (tile.sprite.getTexture() != &clothesTexture)
-        {
-            tile.sprite.setTexture(clothesTexture);
-        }
-        auto it = tileTextureMap.find(tile.getValue());
-        if (it != tileTextureMap.end())
-        {
-            tile.sprite.setTextureRect(it->second); // Устанавливаем правильную область текстуры
-        }
-        else
-        {
-            std::cerr << "Warning: No texture info for value " << tile.getValue() << std::endl;
-        }
-    }
-    else if (tile.getValue() == 9)
-    {
-        tile.sprite.setColor(sf::Color::Transparent); // Угловые элементы не отображаются
-    }
+    static const sf::Color palette[] = {
+        sf::Color(255, 255, 255),
+        sf::Color(90, 170, 255),
+        sf::Color(255, 110, 110),
+        sf::Color(120, 220, 120),
+        sf::Color(255, 210, 80),
+        sf::Color(200, 120, 255),
+        sf::Color(255, 160, 60),
+        sf::Color(80, 220, 220),
+        sf::Color(240, 120, 200)
+    };
+    if (tileType < 0 || tileType > MAX_TILE_TYPES) tileType = 0;
+    return palette[tileType];
 }
 
-// Поиск совпадений
-std::vector<std::vector<bool>> findMatches(const std::vector<std::vector<int>>& tileMap)
+enum class GameState
 {
-    int height = tileMap.size();
-    int width = tileMap[0].size();
-    std::vector<std::vector<bool>> toRemove(height, std::vector<bool>(width, false));
+    Playing,
+    Swapping,
+    Cascading, // Каскад посчитан, идёт его расписание анимаций
+    FillingEmptyTiles,
+    RevertingSwap, // Ход без совпадений, тайлы едут обратно
+    Scrolling, // Бесконечный режим: доска сдвигается на ряд вверх
+    LevelComplete, // Новое состояние
+    GameOver
+};
 
-    // Горизонтальные совпадения
-    for (int y = 0; y < height; ++y)
-    {
-        for (int x = 0; x < width - 2; ++x)
-        {
-            int value = tileMap[y][x];
-            if (value != 0 && value != 9 &&
-                value == tileMap[y][x + 1] &&
-                value == tileMap[y][x + 2]) {
-                toRemove[y][x] = true;
-                toRemove[y][x + 1] = true;
-                toRemove[y][x + 2] = true;
-            }
-        }
-    }
+int fillInitialTiles(std::vector<std::vector<int>>& tileMap,
+    std::vector<std::vector<Tile>>& tiles,
+    int width, int height,
+    float tileSize,
+    int startX, int startY,
+    const SpawnPolicy& spawn,
+    GameRandom& random)
+{
+    int falling = 0;
 
-    // Вертикальные совпадения
     for (int x = 0; x < width; ++x)
     {
-        for (int y = 0; y < height - 2; ++y)
+        for (int y = 0; y < height; ++y)
         {
-            int value = tileMap[y][x];
-            if (value != 0 && value != 9 &&
-                value == tileMap[y + 1][x] &&
-                value == tileMap[y + 2][x])
+            if (tileMap[y][x] == 0)
             {
-                toRemove[y][x] = true;
-                toRemove[y + 1][x] = true;
-                toRemove[y + 2][x] = true;
+                int newValue = spawn.draw(tileMap, x, y, random);
+                tileMap[y][x] = newValue;
+                tiles[y][x].setValue(newValue);
+
+                // Начальная позиция сверху за экраном
+                sf::Vector2f startPosition(startX + x * tileSize, startY - (height - y) * tileSize);
+                tiles[y][x].setFallPosition(startPosition);
+
+                // Целевая позиция
+                sf::Vector2f targetPosition(startX + x * tileSize, startY + y * tileSize);
+                tiles[y][x].startFalling(targetPosition);
+                falling++;
             }
         }
     }
-
-    return toRemove;
+    return falling;
 }
 
-// Удаление совпадений
-void removeMatches(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles, const std::vector<std::vector<bool>>& toRemove, std::map<int, int>& removedTilesCount)
+// Всё, что нужно потоку отрисовки, чтобы нарисовать один тайл
+struct TileView
+{
+    int value;
+    sf::Vector2f position;
+    float scaleX;
+    float scaleY;
+    sf::Uint8 alpha;
+    TileTrack track; // То же в замкнутой форме, для шейдерной отрисовки
+};
+
+// Неизменяемый снимок игры, который симуляция публикует через тройной буфер
+struct BoardSnapshot
 {
-    int height = tileMap.size();
-    int width = tileMap[0].size();
+    TileView tiles[HEIGHT_MAP][WIDTH_MAP];
+    float animationTime; // Время симуляции снимка, по нему шейдер считает анимации
+    LevelGoal goals[MAX_GOALS];
+    int goalProgress[MAX_GOALS];
+    int goalCount;
+    int movesLeft;
+    int goal; // Сколько осталось до первой цели
+    GameState state;
+    bool closeRequested;
+    std::uint32_t inputTag; // Метка последнего применённого ввода, для замера задержки
+};
 
-    for (int y = 0; y < height; ++y)
+// Визуальный эффект, который симуляция заказывает потоку отрисовки.
+// Идёт отдельной очередью, а не в снимке: снимки могут пропускаться,
+// а вспышка на каждом удалённом тайле должна дойти.
+struct EffectEvent
+{
+    enum class Type
     {
-        for (int x = 0; x < width; ++x)
-        {
-            if (toRemove[y][x])
-            {
-                int tileType = tileMap[y][x];
-                if (tileType != 0 && tileType != 9) // Игнорируем пустые и угловые тайлы
-                {
-                    removedTilesCount[tileType]++; // Увеличиваем счетчик удаленных тайлов
-                }
+        TileCleared,
+        Combo
+    };
+
+    Type type;
+    sf::Vector2f position;
+    int tileType;
+    int comboDepth;
+};
 
-                if (tileType == 1)
-                {
-                    goal--;
-                }
+typedef SpscQueue<EffectEvent, 256> EffectQueue;
 
-                tiles[y][x].startRemoving();
-                tileMap[y][x] = 0;
-            }
-        }
-    }
+// Событие игровой машины состояний. Анимации, ввод и логика не меняют
+// состояние напрямую, а кладут события в очередь симуляции.
+struct GameEvent
+{
+    enum class Type
+    {
+        SwapRequested,      // Игрок попросил поменять два тайла (move)
+        AnimationsFinished, // Завершились count анимаций вида animation
+        BoardSettled,       // Каскад закончился, доска ждёт хода
+        Restart
+    };
+
+    Type type;
+    TileState animation;
+    int count;
+    LastMove move;
+};
+
+typedef SpscQueue<GameEvent, 128> GameEventQueue;
+
+LevelLayout defaultLevel()
+{
+    return makeLevelLayout(WIDTH_MAP, HEIGHT_MAP, BOARD_ROWS,
+        FIRST_LEVEL_GOALS, static_cast<int>(std::size(FIRST_LEVEL_GOALS)), 20);
 }
+// Раскладки из редактора для потока симуляции
+typedef SpscQueue<LevelLayout, 4> LevelQueue;
 
-// Применение гравитации (падение тайлов)
-void applyGravity(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles,
-    int width, int height, float tileSize, const sf::Texture& clothesTex,
-    int startX, int startY)
+struct GameSession;
+FlowTask runHints(GameSession& session);
+
+// Состояние игры, принадлежащее потоку симуляции
+struct GameSession
 {
-    for (int x = 0; x < width; ++x)
+    // synchronousHints — подсказки считаются в потоке симуляции, для воспроизводимых прогонов
+    explicit GameSession(bool synchronousHints = false) : hints(WIDTH_MAP, HEIGHT_MAP, synchronousHints)
     {
-        int writeY = height - 1;
-        for (int y = height - 1; y >= 0; --y)
-        {
-            if (tileMap[y][x] != 0 && tileMap[y][x] != 9)
-            {
-                if (writeY != y)
-                {
-                    int value = tileMap[y][x];
-                    tileMap[writeY][x] = value;
-                    tileMap[y][x] = 0;
-
-                    // Обновляем новый тайл
-                    tiles[writeY][x].setValue(value);
-                    updateTileSprite(tiles[writeY][x], clothesTex);
-
-                    // Запускаем анимацию падения из старой позиции
-                    sf::Vector2f startPos(startX + x * tileSize, startY + y * tileSize);
-                    sf::Vector2f targetPos(startX + x * tileSize, startY + writeY * tileSize);
-                    tiles[writeY][x].setPosition(startPos.x, startPos.y);  // Используем перегруженный метод
-                    tiles[writeY][x].startFalling(targetPos);
-                }
-                writeY--;
-            }
-            else if (tileMap[y][x] == 9)
-            {
-                writeY = y - 1;
-            }
-        }
+        scratch.reserve(WIDTH_MAP * HEIGHT_MAP);
+        hintResult.board.assign(HEIGHT_MAP, std::vector<int>(WIDTH_MAP, 0));
+        highlightedTiles.reserve(2);
+        shownHint.reserve(2);
+        runHints(*this);
     }
-}
 
-const std::vector<sf::Vector2i> corners = {
-        {0,0}, {0,1}, {0,5}, {0,6}, {1,0}, {1,6},
-        {5,0}, {5,6}, {6,0}, {6,1}, {6,5}, {6,6}
+    std::vector<std::vector<int>> tileMap;
+    std::vector<std::vector<Tile>> tiles;
+
+    LastMove lastMove;
+    sf::Vector2i selectedTile = { -1, -1 }; // Координаты выделенного тайла
+
+    GameState gameState = GameState::Playing;
+    GameEventQueue events;
+    int pendingAnimations[TILE_STATE_COUNT] = {}; // Сколько анимаций каждого вида ещё идёт
+
+    float idleSince = 0.0f; // Время симуляции последнего действия, для подсказки
+    float endSince = 0.0f; // Время симуляции конца игры
+    std::vector<sf::Vector2i> highlightedTiles; //Подсвеченыые тайлы
+    std::vector<sf::Vector2i> shownHint; // Последняя подсказка, пока доска не изменилась
+    HintWorker hints; // Фоновый поиск подсказки
+    HintResult hintResult; // Последний забранный результат, его доска переиспользуется
+    int movesLeft = 20; // Начальное количество ходов
+    bool closeRequested = false;
+
+    int cascadeDepth = 0; // Номер шага текущего каскада, для комбо-эффектов
+    float animationTime = 0.0f; // Время симуляции, от него отсчитываются анимации тайлов
+    float gameStartTime = 0.0f; // Время симуляции начала партии, для телеметрии
+    int movesMade = 0; // Засчитанные ходы партии
+    LevelLayout level = defaultLevel(); // Текущий уровень: поставленные тайлы, цели и ходы
+    BoardShape levelShape = BOARD_SHAPE;
+    const BoardShape* shape = &levelShape;
+    LevelQueue* levels = nullptr; // Новые уровни из редактора, если он есть
+    std::uint64_t stepCount = 0; // Сколько шагов симуляции сделано, для записи партии
+    MatchClassifier classifier{ WIDTH_MAP, HEIGHT_MAP };
+    CascadeScratch scratch; // Буферы шагов каскада
+    CascadeTimeline timeline{ WIDTH_MAP, HEIGHT_MAP, 1.0f / TILE_REMOVE_SPEED, SQUARE_SIZE / TILE_FALL_SPEED };
+    float moveStartTime = -1.0f; // Время засчитанного хода, пока доска не улеглась
+    FrameArena frameArena{ FRAME_ARENA_BYTES }; // Временные данные одного шага
+    LatencyProbe* latency = nullptr; // Замер задержки ввода, если идёт
+    FlowScheduler flows{ SIMULATION_STEP }; // Сценарии с ожиданием: подсказка, экран конца игры
+    FlowSignal boardSettled{ flows };       // Каскад закончился и все анимации доиграли
+    int gameNumber = 0; // Номер партии с запуска: сценарий партии проверяет, что она ещё идёт
+    std::uint32_t inputTag = 0;      // Метка последнего применённого ввода
+    GameStats stats; // Счётчики партии и прогресс целей
+    EffectQueue* effects = nullptr; // Очередь эффектов потока отрисовки, если он есть
+
+    GameRandom random; // Все новые тайлы берутся отсюда; состояние сохраняется
+    SpawnPolicy spawn{ tileTypeCount }; // Веса новых тайлов уровня, фаза — по сделанным ходам
+    SaveWriter* saver = nullptr; // Фоновая запись сохранений, если она есть
+    Replay* recording = nullptr; // Запись намерений игрока, если она включена
+
+    // Бесконечный режим: без целей и лимита ходов, каждые WIDTH_MAP
+    // удалённых тайлов доска сдвигается на ряд вверх
+    bool endless = false;
+    std::unique_ptr<RowStream> rows; // Ряды, которые придут снизу
+    int scrollProgress = 0; // Удалено тайлов с последнего сдвига
+    int rowsScrolled = 0;
+    std::vector<std::uint8_t> saveBuffer;
 };
 
-void fillEmptyTiles(std::vector<std::vector<int>>& tileMap,
-    std::vector<std::vector<Tile>>& tiles,
-    int width, int height,
-    float tileSize,
-    const sf::Texture& clothesTex,
-    int startX, int startY,
-    const std::vector<sf::Vector2i>& corners)
+void printTileMap(const char* label, const std::vector<std::vector<int>>& tileMap)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(1, 6);
+    if (!printBoards) return;
 
-    for (int x = 0; x < width; ++x)
+    std::cout << label << std::endl;
+    // Выводим результат в консоль (для проверки)
+    for (int y = 0; y < HEIGHT_MAP; ++y)
     {
-        for (int y = 0; y < height; ++y)
+        for (int x = 0; x < WIDTH_MAP; ++x)
         {
-            // Заполняем только пустые ячейки (0), которые НЕ являются угловыми (9)
-            if (tileMap[y][x] == 0) {
-                bool isCorner = false;
-                for (const auto& corner : corners)
-                {
-                    if (corner.x == x && corner.y == y)
-                    {
-                        isCorner = true;
-                        break;
-                    }
-                }
-
-                if (!isCorner)
-                {
-                    int newValue = distrib(gen);
-                    tileMap[y][x] = newValue;
-                    tiles[y][x].setValue(newValue);
-
-                    // Начальная позиция сверху за экраном
-                    sf::Vector2f startPosition(startX + x * tileSize, startY - tileSize);
-                    tiles[y][x].setFallPosition(startPosition);
-
-                    // Целевая позиция
-                    sf::Vector2f targetPosition(startX + x * tileSize, startY + y * tileSize);
-                    tiles[y][x].startFalling(targetPosition);
-
-                    updateTileSprite(tiles[y][x], clothesTex);
-                }
-                else
-                {
-                    // Убедимся, что угловые элементы остаются 9
-                    tileMap[y][x] = 9;
-                    tiles[y][x].setValue(9);
-                    updateTileSprite(tiles[y][x], clothesTex);
-                }
-            }
+            std::cout << tileMap[y][x] << " ";
         }
+        std::cout << std::endl;
     }
 }
 
-
-bool hasMatches(const std::vector<std::vector<int>>& tileMap)
+void postEvent(GameSession& session, const GameEvent& event)
 {
-    // Оптимизированная проверка без полного поиска
-    for (int y = 0; y < HEIGHT_MAP; y++)
+    if (!session.events.push(event))
     {
-        for (int x = 0; x < WIDTH_MAP - 2; x++)
-        {
-            if (tileMap[y][x] == tileMap[y][x + 1] &&
-                tileMap[y][x] == tileMap[y][x + 2] &&
-                tileMap[y][x] != 0 && tileMap[y][x] != 9) return true;
-        }
+        std::cerr << "Warning: game event queue overflow" << std::endl;
     }
+}
 
-    for (int x = 0; x < WIDTH_MAP; x++)
+// Регистрирует count запущенных анимаций. Если ничего не запущено,
+// сразу сообщает о завершении, чтобы машина состояний не зависла.
+void expectAnimations(GameSession& session, TileState animation, int count)
+{
+    session.pendingAnimations[static_cast<int>(animation)] += count;
+    if (count == 0)
     {
-        for (int y = 0; y < HEIGHT_MAP - 2; y++)
-        {
-            if (tileMap[y][x] == tileMap[y + 1][x] &&
-                tileMap[y][x] == tileMap[y + 2][x] &&
-                tileMap[y][x] != 0 && tileMap[y][x] != 9) return true;
-        }
+        postEvent(session, { GameEvent::Type::AnimationsFinished, animation, 0, {} });
     }
-    return false;
 }
 
-// Основная функция для обработки совпадений
-void findAndReplaceMatches(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles, int width, int height, float tileSize, const sf::Texture& clothesTex, int startX, int startY, const std::vector<sf::Vector2i>& corners)
+// Угловые клетки формы становятся BLOCKED_TILE, остальные пустеют
+void applyBoardShape(std::vector<std::vector<int>>& tileMap, const BoardShape& shape)
 {
-    while (true)
+    for (int y = 0; y < shape.getHeight(); ++y)
     {
-        auto toRemove = findMatches(tileMap);
-        bool hasMatches = false;
-        for (const auto& row : toRemove)
-            if (std::any_of(row.begin(), row.end(), [](bool v) {return v; }))
-                hasMatches = true;
-
-        if (!hasMatches) break;
-
-        removeMatches(tileMap, tiles, toRemove, removedTilesCount);
-        applyGravity(tileMap, tiles, width, height, tileSize, clothesTex, startX, startY);
-        fillEmptyTiles(tileMap, tiles, width, height, tileSize, clothesTex, startX, startY, corners);
-
-        std::cout << "new map:" << std::endl; // Выводим в консоль метку "old map:"
-        // Выводим результат в консоль (для проверки)
-        for (int y = 0; y < HEIGHT_MAP; ++y)
+        for (int x = 0; x < shape.getWidth(); ++x)
         {
-            for (int x = 0; x < WIDTH_MAP; ++x)
-            {
-                std::cout << tileMap[y][x] << " ";
-            }
-            std::cout << std::endl;
+            tileMap[y][x] = shape.isPlayable(x, y) ? 0 : BLOCKED_TILE;
         }
     }
 }
 
-// Поиск возможных совпадений
-// Поиск возможных совпадений (работает с копией матрицы)
-std::vector<std::vector<sf::Vector2i>> findPossibleMatches(const std::vector<std::vector<int>>& tileMap)
+// Сбрасывает доску на месте: векторы доски и тайлов создаются один раз
+// и дальше только перезаписываются
+void resetBoard(GameSession& session)
 {
-    std::vector<std::vector<sf::Vector2i>> matches;
-    int height = tileMap.size();
-    int width = tileMap[0].size();
-
-    // Создаем копию матрицы для тестирования
-    auto tempMap = tileMap;
+    if (session.tileMap.empty())
+    {
+        session.tileMap.assign(HEIGHT_MAP, std::vector<int>(WIDTH_MAP, 0));
+        session.tiles.assign(HEIGHT_MAP, std::vector<Tile>(WIDTH_MAP));
+    }
 
-    // Проверка горизонтальных свапов
-    for (int y = 0; y < height; y++)
+    // Setup initial grid
+    applyBoardShape(session.tileMap, *session.shape);
+    if (!session.endless)
     {
-        for (int x = 0; x < width - 1; x++)
+        // Поставленные в редакторе тайлы; остальные выпадут случайно
+        for (int y = 0; y < HEIGHT_MAP; ++y)
         {
-            if (tempMap[y][x] == 9 || tempMap[y][x + 1] == 9) continue; // Пропускаем угловые
-
-            std::swap(tempMap[y][x], tempMap[y][x + 1]);
-            if (hasMatches(tempMap))
+            for (int x = 0; x < WIDTH_MAP; ++x)
             {
-                matches.push_back({ {x, y}, {x + 1, y} });
+                int value = session.level.cell(x, y);
+                if (value != 0 && value != BLOCKED_TILE) session.tileMap[y][x] = value;
             }
-            std::swap(tempMap[y][x], tempMap[y][x + 1]); // Возвращаем обратно
         }
     }
 
-    // Проверка вертикальных свапов
-    for (int x = 0; x < width; x++)
+    for (int y = 0; y < HEIGHT_MAP; ++y)
     {
-        for (int y = 0; y < height - 1; y++)
+        for (int x = 0; x < WIDTH_MAP; ++x)
         {
-            if (tempMap[y][x] == 9 || tempMap[y + 1][x] == 9) continue;
-
-            std::swap(tempMap[y][x], tempMap[y + 1][x]);
-            if (hasMatches(tempMap))
-            {
-                matches.push_back({ {x, y}, {x, y + 1} });
-            }
-            std::swap(tempMap[y][x], tempMap[y + 1][x]);
+            Tile& tile = session.tiles[y][x];
+            tile = Tile();
+            tile.getAnimator().setTime(session.animationTime);
+            tile.setValue(session.tileMap[y][x]);
+            tile.setPosition(START_X + x * SQUARE_SIZE, START_Y + y * SQUARE_SIZE);
+            tile.getAnimator().setAppearSpeed(1.0f); // Увеличиваем скорость появления
+            tile.getAnimator().setFallSpeed(450.0f); // Увеличиваем скорость падения
         }
     }
 
-    return matches;
+    session.hints.cancel();
+    session.highlightedTiles.clear();
+    session.shownHint.clear();
+    session.selectedTile = { -1, -1 };
+    session.cascadeDepth = 0;
+    session.timeline.begin(session.animationTime);
+    session.moveStartTime = -1.0f;
+    for (int& pending : session.pendingAnimations) pending = 0;
 }
 
-// Перемешивание доски
-void shuffleBoard(std::vector<std::vector<int>>& tileMap, std::vector<std::vector<Tile>>& tiles,
-    const sf::Texture& clothesTex, int startX, int startY, int squareSize)
+void setupBoard(GameSession& session)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(1, 6);
-
-    do
+    session.movesLeft = session.endless ? 20 : session.level.moves; // Сброс счетчика ходов
+    session.closeRequested = false;
+    session.gameNumber++;
+    session.gameStartTime = session.animationTime;
+    session.movesMade = 0;
+    session.spawn.setMovesMade(0);
+    telemetryCount(TelemetryCounter::GamesStarted);
+    if (session.endless)
     {
-        // Перемешиваем все не угловые тайлы
-        for (int y = 0; y < HEIGHT_MAP; y++)
-        {
-            for (int x = 0; x < WIDTH_MAP; x++)
-            {
-                if (tileMap[y][x] != 9)
-                {
-                    tileMap[y][x] = distrib(gen);
-                    tiles[y][x].setValue(tileMap[y][x]);
-                    updateTileSprite(tiles[y][x], clothesTex);
-                }
-            }
-        }
-    } while (hasMatches(tileMap) || !findPossibleMatches(tileMap).empty());
-}
+        session.stats.reset(nullptr, 0);
+        session.scrollProgress = 0;
+        session.rowsScrolled = 0;
+        // Ряды снизу идут своей последовательностью, но от того же зерна
+        session.rows->reset(session.random.next(), tileTypeCount);
+    }
+    else
+    {
+        session.stats.reset(session.level.goals, session.level.goalCount); // Сброс статистики и целей
+    }
 
-sf::Color hexToColor(const std::string& hexColor)
-{
-    std::string color = hexColor;
-    if (color[0] == '#') color.erase(0, 1);
-    if (color.length() != 6) return sf::Color::Black;
+    resetBoard(session);
 
-    unsigned int r, g, b;
-    std::stringstream ss;
-    ss << std::hex << color.substr(0, 2); ss >> r; ss.clear();
-    ss << std::hex << color.substr(2, 2); ss >> g; ss.clear();
-    ss << std::hex << color.substr(4, 2); ss >> b;
+    // Начальное заполнение проходит через ту же машину состояний,
+    // что и каскад: совпадения после падения будут удалены обычным путём
+    int falling = fillInitialTiles(session.tileMap, session.tiles, WIDTH_MAP, HEIGHT_MAP, SQUARE_SIZE, START_X, START_Y, session.spawn, session.random);
+    session.gameState = GameState::FillingEmptyTiles;
+    expectAnimations(session, TileState::Falling, falling);
 
-    return sf::Color(r, g, b);
+    printTileMap("old map:", session.tileMap);
 }
 
-enum class GameState
-{
-    Playing,
-    Swapping,
-    RemovingMatches,
-    ApplyingGravity,
-    FillingEmptyTiles,
-    LevelComplete // Новое состояние
-};
-
-bool areAllAnimationsFinished(const std::vector<std::vector<Tile>>& tiles)
+// Меняет уровень партии; вызывать до setupBoard. Размер поля фиксирован.
+bool setLevel(GameSession& session, const LevelLayout& layout)
 {
-    for (const auto& row : tiles) {
-        for (const auto& tile : row) {
-            if (tile.getState() != TileState::Idle) {
-                return false;
-            }
-        }
+    if (layout.width != WIDTH_MAP || layout.height != HEIGHT_MAP)
+    {
+        std::cerr << "Level must be " << WIDTH_MAP << "x" << HEIGHT_MAP << std::endl;
+        return false;
     }
+    session.level = layout;
+    session.levelShape = makeBoardShape(layout);
+    session.spawn = SpawnPolicy(layout.spawn, tileTypeCount);
     return true;
 }
 
-void fillInitialTiles(std::vector<std::vector<int>>& tileMap,
-    std::vector<std::vector<Tile>>& tiles,
-    int width, int height,
-    float tileSize,
-    const sf::Texture& clothesTex,
-    int startX, int startY)
+// Уровень из файла или раскладка по умолчанию
+LevelLayout loadStartLevel()
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(1, 6);
-
-    for (int x = 0; x < width; ++x)
+    LevelLayout layout;
+    if (loadLevel(LEVEL_PATH, layout) && layout.width == WIDTH_MAP && layout.height == HEIGHT_MAP)
     {
-        for (int y = 0; y < height; ++y)
-        {
-            if (tileMap[y][x] == 0)
-            {
-                int newValue = distrib(gen);
-                tileMap[y][x] = newValue;
-                tiles[y][x].setValue(newValue);
+        return layout;
+    }
+    return defaultLevel();
+}
 
-                // Начальная позиция сверху за экраном
-                sf::Vector2f startPosition(startX + x * tileSize, startY - (height - y) * tileSize);
-                tiles[y][x].setFallPosition(startPosition);
+// Переключает партию в бесконечный режим; вызывать до setupBoard
+void enableEndless(GameSession& session)
+{
+    session.endless = true;
+    session.shape = &ENDLESS_SHAPE;
+    session.spawn = SpawnPolicy(tileTypeCount); // Правила уровня к бесконечной доске не относятся
+    session.rows.reset(new RowStream(WIDTH_MAP, ENDLESS_LOOKAHEAD_ROWS));
+}
 
-                // Целевая позиция
-                sf::Vector2f targetPosition(startX + x * tileSize, startY + y * tileSize);
-                tiles[y][x].startFalling(targetPosition);
+void restartGame(GameSession& session)
+{
+    // Перезапуск игры
+    setupBoard(session);
 
-                updateTileSprite(tiles[y][x], clothesTex);
-            }
-        }
-    }
+    std::cout << "Game restarted!" << std::endl;
 }
 
-bool isFallingAnimationFinished(const std::vector<std::vector<Tile>>& tiles)
+// Снимок устоявшейся доски уходит в фоновую запись
+void saveSession(GameSession& session)
 {
-    for (const auto& row : tiles)
+    // Бесконечная партия не сохраняется: её продолжение зависит от потока рядов
+    if (!session.saver || session.endless) return;
+
+    SavedGame game(session.frameArena.get());
+    game.width = WIDTH_MAP;
+    game.height = HEIGHT_MAP;
+    game.cells.resize(WIDTH_MAP * HEIGHT_MAP);
+    game.playable.resize(WIDTH_MAP * HEIGHT_MAP);
+    for (int y = 0; y < HEIGHT_MAP; ++y)
     {
-        for (const auto& tile : row)
+        for (int x = 0; x < WIDTH_MAP; ++x)
         {
-            if (tile.getState() == TileState::Falling)
-            {
-                return false;
-            }
+            game.cells[y * WIDTH_MAP + x] = session.tileMap[y][x];
+            game.playable[y * WIDTH_MAP + x] = session.shape->isPlayable(x, y);
         }
     }
-    return true;
+    game.randomState = session.random.getState();
+    game.randomIncrement = session.random.getIncrement();
+    game.tileTypeCount = tileTypeCount;
+    game.movesLeft = session.movesLeft;
+    game.goalCount = session.stats.getGoalCount();
+    for (int i = 0; i < game.goalCount; ++i) game.goals[i] = session.stats.getGoal(i);
+    game.counters = session.stats.getCounters();
+
+    if (encodeSavedGame(game, session.saveBuffer))
+    {
+        session.saver->submit(session.saveBuffer);
+    }
 }
 
-void drawLevelGoals(sf::RenderWindow& window, const std::map<int, int>& levelGoals, const std::map<int, int>& removedTilesCount, const sf::Font& font, int startX, int startY)
+// Продолжает сохранённую партию с устоявшейся доски. false, если
+// сохранение не подходит к этой доске или атласу.
+bool restoreSession(GameSession& session, const SavedGame& game)
 {
+    if (game.width != WIDTH_MAP || game.height != HEIGHT_MAP || game.tileTypeCount != tileTypeCount) return false;
 
-    int yOffset = 0; // Смещение по вертикали для каждой цели
-
-    for (const auto& goal : levelGoals)
+    for (int y = 0; y < HEIGHT_MAP; ++y)
     {
-        int tileType = goal.first;
-        int requiredCount = goal.second;
-        int removedCount = removedTilesCount.count(tileType) ? removedTilesCount.at(tileType) : 0;
-
-        // Формируем строку цели
-        std::stringstream ss;
-        ss << "Tile " << tileType << ": " << removedCount << "/" << requiredCount;
-        //goalText.setString(ss.str());
-
-        // Позиция текста
-        //goalText.setPosition(startX, startY + yOffset);
-        yOffset += 40; // Увеличиваем смещение для следующей цели
+        for (int x = 0; x < WIDTH_MAP; ++x)
+        {
+            int value = game.cells[y * WIDTH_MAP + x];
+            bool playable = game.playable[y * WIDTH_MAP + x] != 0;
+            if (playable != session.shape->isPlayable(x, y)) return false;
+            if (playable && tileColor(value) > tileTypeCount) return false;
+        }
+    }
 
-        // Отрисовываем текст
-        //window.draw(goalText);
+    resetBoard(session);
+    for (int y = 0; y < HEIGHT_MAP; ++y)
+    {
+        for (int x = 0; x < WIDTH_MAP; ++x)
+        {
+            session.tileMap[y][x] = game.cells[y * WIDTH_MAP + x];
+            session.tiles[y][x].setValue(session.tileMap[y][x]);
+        }
     }
+
+    session.random.setState(game.randomState, game.randomIncrement);
+    session.movesLeft = game.movesLeft;
+    // Время партии для телеметрии считается с момента продолжения
+    session.gameStartTime = session.animationTime;
+    session.movesMade = std::max(0, session.level.moves - game.movesLeft);
+    session.spawn.setMovesMade(session.movesMade);
+    session.stats.restore(game.goals, game.goalCount, game.counters);
+    session.closeRequested = false;
+    session.gameState = GameState::Playing;
+    session.idleSince = session.animationTime;
+    session.hints.request(session.tileMap, tileTypeCount);
+    return true;
 }
 
-bool isLevelComplete(const std::map<int, int>& levelGoals, const std::map<int, int>& removedTilesCount)
+void clearSelection(GameSession& session)
 {
-    for (const auto& goal : levelGoals)
+    if (session.selectedTile.x != -1)
     {
-        int tileType = goal.first;
-        int requiredCount = goal.second;
-        int removedCount = removedTilesCount.count(tileType) ? removedTilesCount.at(tileType) : 0;
-
-        if (removedCount < requiredCount)
-        {
-            return false; // Если хотя бы одна цель не выполнена
-        }
+        session.tiles[session.selectedTile.y][session.selectedTile.x].stopSelectAnimation();
+        session.selectedTile = { -1, -1 };
     }
-    return true; // Все цели выполнены
 }
 
-int main()
+// Перевод намерений игрока в события машины состояний. Слой ввода уже
+// перевёл точки в клетки; здесь только проверка по текущей доске.
+void handleInput(GameSession& session, const InputEvent& input)
 {
-    setlocale(LC_ALL, "RUSSIAN");
-    const int squareSize = 84;
-    sf::RenderWindow window(sf::VideoMode(1366, 770), "Big wash");
+    auto& tiles = session.tiles;
 
-    // Load textures
-    sf::Texture background, leftPanelTex, mainPanelTex, clothesTex, levelGoal;
-    if (!background.loadFromFile("pictures/background.png") ||
-        !leftPanelTex.loadFromFile("pictures/panel_L_arrows.png") ||
-        !mainPanelTex.loadFromFile("pictures/main_panel.png") ||
-        !clothesTex.loadFromFile("pictures/clothes.png") ||
-        !levelGoal.loadFromFile("pictures/cap.png"))
+    if (session.recording)
     {
-        std::cerr << "Failed to load textures" << std::endl;
-        return EXIT_FAILURE;
+        session.recording->events.push_back({ session.stepCount, input });
+    }
+    if (session.latency && input.tag != 0)
+    {
+        session.latency->mark(input.tag, LatencyStage::Handled);
+        session.inputTag = input.tag;
     }
 
-    // Setup sprites
-    sf::Sprite backgroundSprite(background);
-    sf::Sprite leftPanel(leftPanelTex);
-    sf::Sprite mainPanel(mainPanelTex);
-    sf::Sprite levelGoalSprite(levelGoal);
-    leftPanel.setPosition(10, 100);
-    mainPanel.setPosition(365, 67);
-    levelGoalSprite.setPosition(65, 340);
+    switch (input.type)
+    {
+    case InputEvent::Type::Restart:
+        postEvent(session, { GameEvent::Type::Restart, TileState::Idle, 0, {} });
+        break;
 
-    sf::Vector2i selectedTile = { -1, -1 }; // Координаты выделенного тайла
-    bool isDragging = false; // Флаг перетаскивания
-    sf::Vector2f dragOffset; // Смещение курсора относительно центра тайла
+    case InputEvent::Type::Select:
+        if (session.gameState != GameState::Playing || !session.shape->isPlayable(input.x, input.y)) break;
 
-    // Initialize game grid
-    std::vector<std::vector<int>> tileMap(HEIGHT_MAP, std::vector<int>(WIDTH_MAP, 0));
-    std::vector<std::vector<Tile>> tiles(HEIGHT_MAP, std::vector<Tile>(WIDTH_MAP));
+        // Игрок действует сам, подсказка больше не нужна
+        for (auto& pos : session.highlightedTiles)
+        {
+            tiles[pos.y][pos.x].stopSelectAnimation();
+        }
+        session.highlightedTiles.clear();
+        session.idleSince = session.animationTime;
 
-    // Setup initial grid
-    for (const auto& pos : corners) tileMap[pos.y][pos.x] = 9;
+        // Сбрасываем предыдущее выделение
+        clearSelection(session);
+        session.selectedTile = { input.x, input.y };
+        tiles[input.y][input.x].startSelectAnimation();
+        break;
+
+    case InputEvent::Type::Deselect:
+        clearSelection(session);
+        break;
+
+    case InputEvent::Type::Swap:
+    {
+        clearSelection(session);
+        if (session.gameState != GameState::Playing) break;
+
+        // Ни исходная, ни целевая клетка не должны быть угловыми
+        if (session.shape->isPlayable(input.x, input.y) && session.shape->isPlayable(input.targetX, input.targetY) &&
+            abs(input.targetX - input.x) + abs(input.targetY - input.y) == 1)
+        {
+            session.idleSince = session.animationTime;
+            LastMove move = { input.x, input.y, input.targetX, input.targetY };
+            postEvent(session, { GameEvent::Type::SwapRequested, TileState::Idle, 0, move });
+        }
+        break;
+    }
+    }
+}
+
+void startSwap(GameSession& session, const LastMove& move)
+{
+    auto& tileMap = session.tileMap;
+    auto& tiles = session.tiles;
+    session.lastMove = move;
+    session.cascadeDepth = 0;
+    session.hints.cancel(); // Доска меняется, подсказка для неё устарела
+
+    // Swap tiles
+    std::swap(tiles[move.selectedY][move.selectedX], tiles[move.targetY][move.targetX]);
+    std::swap(tileMap[move.selectedY][move.selectedX], tileMap[move.targetY][move.targetX]);
+
+    // Set animation positions
+    tiles[move.selectedY][move.selectedX].startMoving(tiles[move.targetY][move.targetX].getPosition());
+    tiles[move.targetY][move.targetX].startMoving(tiles[move.selectedY][move.selectedX].getPosition());
+    session.gameState = GameState::Swapping; // Set game state to swapping
+    expectAnimations(session, TileState::Moving, 2);
+}
+
+// Обмен дал совпадение или задействовал цветную бомбу: ход засчитан
+void countMove(GameSession& session)
+{
+    if (!session.endless) session.movesLeft--;
+    session.movesMade++;
+    session.moveStartTime = session.animationTime;
+    session.spawn.setMovesMade(session.movesMade);
+    telemetryCount(TelemetryCounter::MovesMade);
+
+    const LastMove& move = session.lastMove;
+    if (session.shownHint.size() == 2)
+    {
+        sf::Vector2i from(move.selectedX, move.selectedY);
+        sf::Vector2i to(move.targetX, move.targetY);
+        const std::vector<sf::Vector2i>& hint = session.shownHint;
+        if ((hint[0] == from && hint[1] == to) || (hint[0] == to && hint[1] == from))
+        {
+            telemetryCount(TelemetryCounter::HintsFollowed);
+        }
+    }
+    session.shownHint.clear();
+}
+
+// Экран конца игры показывает поток отрисовки; сценарий только отмеряет
+// его время, если за это время партию не перезапустили
+FlowTask runEndScreen(GameSession& session)
+{
+    int game = session.gameNumber;
+    co_await session.flows.after(session.endSince, END_SCREEN_SECONDS);
+    if (session.gameNumber == game)
+    {
+        session.closeRequested = true;
+    }
+}
+
+// Партия закончилась победой или поражением
+void finishGame(GameSession& session, GameState state)
+{
+    session.gameState = state;
+    session.endSince = session.animationTime;
+    runEndScreen(session);
+    telemetryCount(state == GameState::LevelComplete ? TelemetryCounter::GamesWon : TelemetryCounter::GamesLost);
+    telemetryRecord(TelemetryHistogram::GameSeconds, static_cast<std::uint64_t>(session.animationTime - session.gameStartTime));
+    telemetryRecord(TelemetryHistogram::GameMoves, static_cast<std::uint64_t>(session.movesMade));
+}
+
+void postEffect(GameSession& session, const EffectEvent& effect)
+{
+    // Если отрисовка не успевает разбирать очередь, эффект просто теряется
+    if (session.effects)
+    {
+        session.effects->push(effect);
+    }
+}
+
+// Каскад от размеченной в классификаторе маски считается целиком сразу:
+// бонусы под ударом срабатывают цепочкой, группы особой формы оставляют
+// бонус в опорной клетке, доска падает и досыпается, пока есть совпадения.
+// Тайлы на экране догоняют доску по расписанию, см. advanceTimeline.
+void resolveCascade(GameSession& session, int colorBombTarget)
+{
+    auto& tileMap = session.tileMap;
+    MatchClassifier& classifier = session.classifier;
+    CascadeScratch& scratch = session.scratch;
+
+    session.timeline.begin(session.animationTime);
+    while (true)
+    {
+        placeSpecials(tileMap, classifier, colorBombTarget, scratch.placed);
+        for (const PlacedSpecial& placed : scratch.placed)
+        {
+            session.stats.recordSpecialCreated(placed.special);
+        }
+
+        const auto& toRemove = classifier.getClearMask();
+
+        // Статистика считается по маске целиком, пока цвета ещё на доске
+        session.stats.recordClears(tileMap, toRemove);
+        session.cascadeDepth++;
+        session.stats.recordCascadeStep(session.cascadeDepth);
+        session.timeline.addClears(tileMap, toRemove, scratch.placed, session.cascadeDepth);
+        session.scrollProgress += clearMarked(tileMap, toRemove);
+
+        collapseColumns(tileMap, scratch.drops);
+        refillEmpty(tileMap, session.spawn, session.random, scratch.filled);
+        session.timeline.addFalls(tileMap, scratch.drops, scratch.filled);
+
+        if (!hasMatches(tileMap)) break;
+        classifier.classify(tileMap);
+        colorBombTarget = 0;
+    }
+    session.gameState = GameState::Cascading;
+}
+
+void startRemovingMatches(GameSession& session)
+{
+    // Совпадения ищутся по текущей доске, а не по устаревшей маске.
+    // На первом шаге каскада бонус появляется в клетке обмена.
+    const LastMove& move = session.lastMove;
+    if (session.cascadeDepth == 0)
+    {
+        session.classifier.classify(session.tileMap, move.selectedX, move.selectedY, move.targetX, move.targetY);
+    }
+    else
+    {
+        session.classifier.classify(session.tileMap);
+    }
+    resolveCascade(session, 0);
+}
+
+// Цветная бомба, переставленная на любой тайл, убирает все тайлы его цвета
+void startColorBombSwap(GameSession& session)
+{
+    const LastMove& move = session.lastMove;
+    int first = session.tileMap[move.selectedY][move.selectedX];
+    int second = session.tileMap[move.targetY][move.targetX];
+
+    session.classifier.clearAll();
+    int target = 0;
+    if (tileSpecial(first) == SpecialTile::ColorBomb)
+    {
+        session.classifier.markCell(move.selectedX, move.selectedY);
+        target = tileColor(second);
+    }
+    if (tileSpecial(second) == SpecialTile::ColorBomb)
+    {
+        session.classifier.markCell(move.targetX, move.targetY);
+        target = tileColor(first);
+    }
+    resolveCascade(session, target);
+}
+
+// Все анимации вида animation завершились: переход в следующее состояние
+void onAnimationsSettled(GameSession& session, TileState animation)
+{
+    switch (session.gameState)
+    {
+    case GameState::Swapping:
+        if (animation != TileState::Moving) break;
+        // Check matches
+        if (isColorBombSwap(session.tileMap[session.lastMove.selectedY][session.lastMove.selectedX],
+            session.tileMap[session.lastMove.targetY][session.lastMove.targetX]))
+        {
+            countMove(session);
+            startColorBombSwap(session);
+        }
+        else if (hasMatches(session.tileMap))
+        {
+            countMove(session);
+            startRemovingMatches(session);
+        }
+        else
+        {
+            // Если совпадений нет, откатываем обмен
+            revertSwap(session.tileMap, session.tiles, session.lastMove, SQUARE_SIZE, START_X, START_Y);
+            session.gameState = GameState::RevertingSwap;
+            expectAnimations(session, TileState::Moving, 2);
+        }
+        break;
+    case GameState::RevertingSwap:
+        if (animation != TileState::Moving) break;
+        session.gameState = GameState::Playing;
+        // Доска та же, что до обмена, но поиск для неё отменён в startSwap
+        session.hints.request(session.tileMap, tileTypeCount);
+        break;
+    case GameState::Scrolling:
+        if (animation != TileState::Moving) break;
+        // Пришедший ряд мог сложиться с рядом над ним
+        if (hasMatches(session.tileMap))
+        {
+            startRemovingMatches(session);
+        }
+        else
+        {
+            session.gameState = GameState::Playing;
+            postEvent(session, { GameEvent::Type::BoardSettled, TileState::Idle, 0, {} });
+        }
+        break;
+    case GameState::FillingEmptyTiles:
+        if (animation != TileState::Falling) break;
+        // Проверяем совпадения после заполнения
+        if (hasMatches(session.tileMap))
+        {
+            startRemovingMatches(session);
+        }
+        else
+        {
+            printTileMap("new map:", session.tileMap);
+            session.gameState = GameState::Playing;
+            postEvent(session, { GameEvent::Type::BoardSettled, TileState::Idle, 0, {} });
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Записи расписания каскада, время которых пришло. Если тайл в клетке
+// записи ещё едет (оценка времени на шаг разошлась с анимацией), всё
+// расписание ждёт его, чтобы записи одной клетки не обгоняли друг друга.
+void advanceTimeline(GameSession& session)
+{
+    if (session.gameState != GameState::Cascading) return;
 
-    const int startX = 397;
-    const int startY = 99;
+    CascadeTimeline& timeline = session.timeline;
+    while (const TimelineEntry* entry = timeline.peek(session.animationTime))
+    {
+        Tile& tile = session.tiles[entry->y][entry->x];
+        if (entry->action != TimelineAction::Combo && tile.getState() != TileState::Idle) break;
+
+        sf::Vector2f cell(START_X + entry->x * SQUARE_SIZE, START_Y + entry->y * SQUARE_SIZE);
+        switch (entry->action)
+        {
+        case TimelineAction::SetValue:
+            tile.setValue(entry->value);
+            break;
+        case TimelineAction::Remove:
+        {
+            sf::Vector2f center = cell + sf::Vector2f(SQUARE_SIZE / 2.0f, SQUARE_SIZE / 2.0f);
+            postEffect(session, { EffectEvent::Type::TileCleared, center, tileColor(entry->value), 0 });
+            tile.startRemoving();
+            expectAnimations(session, TileState::Removing, 1);
+            break;
+        }
+        case TimelineAction::Fall:
+            tile.setValue(entry->value);
+            tile.setFallPosition(sf::Vector2f(cell.x, START_Y + entry->fromY * SQUARE_SIZE));
+            tile.startFalling(cell);
+            expectAnimations(session, TileState::Falling, 1);
+            break;
+        case TimelineAction::Combo:
+        {
+            sf::Vector2f boardCenter(START_X + WIDTH_MAP * SQUARE_SIZE / 2.0f, START_Y + HEIGHT_MAP * SQUARE_SIZE / 2.0f);
+            postEffect(session, { EffectEvent::Type::Combo, boardCenter, 0, entry->value });
+            break;
+        }
+        }
+        timeline.pop();
+    }
+
+    if (timeline.isFinished() && session.pendingAnimations[static_cast<int>(TileState::Removing)] == 0 &&
+        session.pendingAnimations[static_cast<int>(TileState::Falling)] == 0)
+    {
+        printTileMap("new map:", session.tileMap);
+        session.gameState = GameState::Playing;
+        postEvent(session, { GameEvent::Type::BoardSettled, TileState::Idle, 0, {} });
+    }
+}
+
+// Бесконечный режим: верхний ряд уходит из вида, снизу приходит готовый
+// ряд из потока. Векторы рядов переставляются по кругу, и ушедший ряд
+// заполняется пришедшим, так что доска не растёт и ничего не выделяется.
+void scrollBoard(GameSession& session)
+{
+    auto& tileMap = session.tileMap;
+    auto& tiles = session.tiles;
+
+    session.hints.cancel();
+    for (auto& pos : session.highlightedTiles)
+    {
+        tiles[pos.y][pos.x].stopSelectAnimation();
+    }
+    session.highlightedTiles.clear();
+    clearSelection(session);
+
+    std::rotate(tileMap.begin(), tileMap.begin() + 1, tileMap.end());
+    std::rotate(tiles.begin(), tiles.begin() + 1, tiles.end());
+
+    const int bottom = HEIGHT_MAP - 1;
+    session.rows->takeRow(tileMap[bottom].data());
+    for (int x = 0; x < WIDTH_MAP; ++x)
+    {
+        // Ряд выезжает из-под поля
+        tiles[bottom][x].setValue(tileMap[bottom][x]);
+        tiles[bottom][x].setPosition(START_X + x * SQUARE_SIZE, START_Y + HEIGHT_MAP * SQUARE_SIZE);
+    }
+
+    for (int y = 0; y < HEIGHT_MAP; ++y)
+    {
+        for (int x = 0; x < WIDTH_MAP; ++x)
+        {
+            tiles[y][x].startMoving(sf::Vector2f(START_X + x * SQUARE_SIZE, START_Y + y * SQUARE_SIZE));
+        }
+    }
+
+    session.scrollProgress -= WIDTH_MAP;
+    session.rowsScrolled++;
+    session.cascadeDepth = 0;
+    session.lastMove = LastMove();
+    session.gameState = GameState::Scrolling;
+    expectAnimations(session, TileState::Moving, WIDTH_MAP * HEIGHT_MAP);
+}
+
+void handleGameEvent(GameSession& session, const GameEvent& event)
+{
+    switch (event.type)
+    {
+    case GameEvent::Type::Restart:
+        restartGame(session);
+        break;
+    case GameEvent::Type::SwapRequested:
+        if (session.gameState == GameState::Playing)
+        {
+            startSwap(session, event.move);
+        }
+        break;
+    case GameEvent::Type::AnimationsFinished:
+    {
+        int& pending = session.pendingAnimations[static_cast<int>(event.animation)];
+        pending -= event.count;
+        if (pending <= 0)
+        {
+            pending = 0;
+            onAnimationsSettled(session, event.animation);
+        }
+        break;
+    }
+    case GameEvent::Type::BoardSettled:
+        session.idleSince = session.animationTime;
+        session.boardSettled.notify();
+        session.stats.recordCascade(session.cascadeDepth);
+        telemetryRecord(TelemetryHistogram::CascadeDepth, static_cast<std::uint64_t>(session.cascadeDepth));
+        if (session.moveStartTime >= 0.0f)
+        {
+            float settle = session.animationTime - session.moveStartTime;
+            telemetryRecord(TelemetryHistogram::MoveSettleMilliseconds, static_cast<std::uint64_t>(settle * 1000.0f));
+            session.moveStartTime = -1.0f;
+        }
+        if (session.endless && session.scrollProgress >= WIDTH_MAP)
+        {
+            scrollBoard(session);
+        }
+        // Цели отмечаются при изменении счётчиков, здесь только чтение маски
+        else if (session.stats.isLevelComplete())
+        {
+            finishGame(session, GameState::LevelComplete);
+            if (session.saver) session.saver->discard();
+        }
+        else if (session.movesLeft <= 0)
+        {
+            finishGame(session, GameState::GameOver);
+            if (session.saver) session.saver->discard();
+        }
+        else
+        {
+            // Подсказка считается в фоне, пока игрок думает
+            session.hints.request(session.tileMap, tileTypeCount);
+            saveSession(session);
+        }
+        break;
+    }
+}
+
+void dispatchEvents(GameSession& session)
+{
+    // События, порождённые обработкой, попадают в конец очереди
+    // и разбираются в этом же цикле
+    GameEvent event;
+    while (session.events.pop(event))
+    {
+        handleGameEvent(session, event);
+    }
+}
+
+// Подсказка после HINT_IDLE_SECONDS бездействия. Сценарий спит в колесе
+// таймеров до срока и проверяет, не сдвинулся ли срок, пока он спал:
+// любое действие игрока только переставляет idleSince.
+FlowTask runHints(GameSession& session)
+{
+    auto& tileMap = session.tileMap;
+    auto& tiles = session.tiles;
+    HintResult& hint = session.hintResult;
+
+    while (true)
+    {
+        co_await session.flows.after(session.idleSince, HINT_IDLE_SECONDS);
+        if (session.animationTime - session.idleSince <= HINT_IDLE_SECONDS) continue;
+        if (session.gameState != GameState::Playing)
+        {
+            // Ход, каскад или конец партии: срок пойдёт заново, когда доска уляжется
+            co_await session.boardSettled;
+            continue;
+        }
+        if (!session.highlightedTiles.empty())
+        {
+            // Подсказка уже горит; гасит её только действие игрока, а оно сдвигает idleSince
+            co_await session.flows.delay(HINT_IDLE_SECONDS);
+            continue;
+        }
+        // Подсказка к этому моменту уже посчитана в фоне; если нет — ждём
+        // следующего шага, а не ищем в кадре
+        if (!session.hints.tryTakeResult(hint))
+        {
+            co_await session.flows.nextStep();
+            continue;
+        }
+
+        if (hint.hasMove && !hint.shuffled)
+        {
+            // Лучший по оценке ход
+            session.highlightedTiles = { hint.from, hint.to };
+            session.shownHint = session.highlightedTiles;
+            telemetryCount(TelemetryCounter::HintsShown);
+
+            // Подсвечиваем тайлы
+            for (auto& pos : session.highlightedTiles)
+            {
+                tiles[pos.y][pos.x].startSelectAnimation();
+            }
+        }
+        else if (hint.shuffled)
+        {
+            // Ходов не было, поиск уже подобрал перемешанную доску
+            for (int y = 0; y < HEIGHT_MAP; ++y)
+            {
+                for (int x = 0; x < WIDTH_MAP; ++x)
+                {
+                    tileMap[y][x] = hint.board[y][x];
+                    tiles[y][x].setValue(tileMap[y][x]);
+                }
+            }
+            session.shownHint.clear();
+            telemetryCount(TelemetryCounter::Shuffles);
+            session.hints.request(tileMap, tileTypeCount);
+            saveSession(session);
+
+            printTileMap("reverse map:", tileMap);
+        }
+        else
+        {
+            std::cerr << "No moves left and no playable shuffle found" << std::endl;
+            finishGame(session, GameState::GameOver);
+        }
+        session.idleSince = session.animationTime;
+    }
+}
+
+// Один шаг игровой логики. Вызывается только из потока симуляции.
+void updateSimulation(GameSession& session, float deltaTime)
+{
+    auto& tiles = session.tiles;
+
+    session.animationTime += deltaTime;
+    session.stepCount++;
+    session.frameArena.reset();
+
+    // Обновляем элементы одежды на игровом поле; завершившиеся
+    // анимации сообщают о себе событиями вместо опроса всей доски
+    int finished[TILE_STATE_COUNT] = {};
+    for (auto& row : tiles)
+    {
+        for (auto& tile : row)
+        {
+            TileState done = tile.update(deltaTime, session.animationTime);
+            if (done != TileState::Idle)
+            {
+                finished[static_cast<int>(done)]++;
+            }
+        }
+    }
+
+    for (int kind = 0; kind < TILE_STATE_COUNT; ++kind)
+    {
+        if (finished[kind] > 0)
+        {
+            postEvent(session, { GameEvent::Type::AnimationsFinished, static_cast<TileState>(kind), finished[kind], {} });
+        }
+    }
+
+    dispatchEvents(session);
+    // Расписание смотрит на уже учтённые завершения; BoardSettled от него
+    // разбирается в том же шаге
+    advanceTimeline(session);
+    dispatchEvents(session);
+
+    // Сценарии, чьё время пришло: подсказка, экран конца игры
+    session.flows.advance(session.animationTime);
+}
+
+void publishSnapshot(const GameSession& session, BoardSnapshot& snapshot)
+{
+    for (int y = 0; y < HEIGHT_MAP; ++y)
+    {
+        for (int x = 0; x < WIDTH_MAP; ++x)
+        {
+            const Tile& tile = session.tiles[y][x];
+            TileView& view = snapshot.tiles[y][x];
+            view.value = tile.getValue();
+            view.position = tile.getVisualPosition();
+            // Масштаб удаления и появления вместе с пульсацией выделения
+            view.scaleX = tile.getAnimator().getScaleX() * tile.getAnimator().getScale();
+            view.scaleY = tile.getAnimator().getScaleY() * tile.getAnimator().getScale();
+            view.alpha = static_cast<sf::Uint8>(tile.getAnimator().getAlpha());
+            view.track = tile.getTrack();
+        }
+    }
+    snapshot.animationTime = session.animationTime;
+
+    const GameStats& stats = session.stats;
+    snapshot.goalCount = stats.getGoalCount();
+    for (int i = 0; i < snapshot.goalCount; ++i)
+    {
+        snapshot.goals[i] = stats.getGoal(i);
+        snapshot.goalProgress[i] = stats.getGoalProgress(i);
+    }
+
+    snapshot.movesLeft = session.movesLeft;
+    snapshot.goal = session.endless ? session.rowsScrolled : (snapshot.goalCount > 0 ? stats.getGoalRemaining(0) : 0);
+    snapshot.state = session.gameState;
+    snapshot.closeRequested = session.closeRequested;
+    snapshot.inputTag = session.inputTag;
+}
+
+// Одна итерация симуляции: ввод, уровни из редактора и столько шагов,
+// сколько накопилось за elapsed секунд. true, если отдан новый снимок.
+bool tickSimulation(GameSession& session, InputQueue& inputQueue, TripleBuffer<BoardSnapshot>& snapshots,
+    float elapsed, float& accumulator)
+{
+    InputEvent input;
+    while (inputQueue.pop(input))
+    {
+        handleInput(session, input);
+    }
+
+    // Уровень из редактора начинает партию заново
+    LevelLayout layout;
+    while (session.levels && session.levels->pop(layout))
+    {
+        if (!session.endless && setLevel(session, layout))
+        {
+            setupBoard(session);
+        }
+    }
+
+    // Не даём симуляции уйти в бесконечное догоняние после долгого каскада
+    accumulator = std::min(accumulator + elapsed, 0.25f);
+
+    bool stepped = false;
+    while (accumulator >= SIMULATION_STEP)
+    {
+        auto stepStart = std::chrono::steady_clock::now();
+        std::uint64_t allocationsBefore = threadAllocationCount();
+        updateSimulation(session, SIMULATION_STEP);
+        telemetryRecord(TelemetryHistogram::SimulationStepNanoseconds, static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stepStart).count()));
+        if (allocationCountingEnabled())
+        {
+            telemetryRecord(TelemetryHistogram::SimulationStepAllocations, threadAllocationCount() - allocationsBefore);
+        }
+        accumulator -= SIMULATION_STEP;
+        stepped = true;
+    }
+
+    if (stepped)
+    {
+        publishSnapshot(session, snapshots.writeBuffer());
+        snapshots.publish();
+        if (session.latency)
+        {
+            session.latency->mark(session.inputTag, LatencyStage::Published);
+        }
+    }
+    return stepped;
+}
+
+// Поток симуляции: ввод, логика и каскады с фиксированным шагом.
+// Наружу отдаются только снимки через тройной буфер.
+void runSimulation(GameSession& session, InputQueue& inputQueue, TripleBuffer<BoardSnapshot>& snapshots, std::atomic<bool>& running)
+{
+    sf::Clock clock;
+    float accumulator = 0.0f;
+
+    while (running.load(std::memory_order_acquire))
+    {
+        if (!tickSimulation(session, inputQueue, snapshots, clock.restart().asSeconds(), accumulator))
+        {
+            sf::sleep(sf::seconds(SIMULATION_STEP - accumulator));
+        }
+    }
+}
+
+// Вся отрисовка кадра по снимку: фон, панели, тайлы, частицы, HUD и экраны
+// конца игры. Рисует в любую цель — в окно или во внеэкранную текстуру
+// безголового режима, поэтому оба пути рисуют один и тот же кадр.
+class GameRenderer
+{
+public:
+    GameRenderer() : batch(atlas), tileRenderer(atlas, WIDTH_MAP * HEIGHT_MAP), particles(PARTICLE_CAPACITY) {}
+
+    bool load(sf::Vector2u targetSize);
+    // false, если шейдер недоступен и тайлы остались на пакете
+    bool setGpuTiles(bool enabled);
+    bool hasGpuTiles() const { return gpuTiles; }
+
+    // Эффекты симуляции превращаются в частицы
+    void consumeEffects(EffectQueue& effects);
+    void update(float frameSeconds);
+    void draw(sf::RenderTarget& target, const BoardSnapshot& snapshot, float effectTime);
+
+    const TextureAtlas& getAtlas() const { return atlas; }
+    const sf::Font& getFont() const { return font; }
+
+private:
+    static const int PARTICLE_CAPACITY = 65536; // Пул частиц выделяется один раз
+
+    void addCpuTiles(const BoardSnapshot& snapshot, float effectTime);
+
+    TextureAtlas atlas;
+    // Фон, панели, тайлы и иконка цели собираются каждый кадр по последнему
+    // снимку в один пакет и рисуются одной привязкой текстуры. В шейдерном
+    // режиме тайлы рисуются между фоном и иконкой отдельным вызовом.
+    SpriteBatch batch;
+    TileShaderRenderer tileRenderer;
+    bool tileShaderLoaded = false;
+    bool gpuTiles = false;
+    ParticleSystem particles;
+
+    sf::IntRect backgroundRegion;
+    sf::IntRect leftPanelRegion;
+    sf::IntRect mainPanelRegion;
+    sf::IntRect levelGoalRegion;
+    sf::IntRect bonusArrowsRegion;
+
+    sf::Font font;
+    // Счётчики HUD собираются из заранее запечённых глифов и
+    // перестраиваются только когда меняется число
+    std::unique_ptr<GlyphCache> movesGlyphs;
+    std::unique_ptr<GlyphCache> goalGlyphs;
+    std::unique_ptr<HudText> movesText;
+    std::unique_ptr<HudText> goalText;
+    std::unique_ptr<GoalListHud> levelGoalsText;
+
+    sf::RectangleShape darkenOverlay;
+    sf::Text gameOverText;
+    sf::Text levelCompleteText;
+};
+
+bool GameRenderer::load(sf::Vector2u targetSize)
+{
+    // Load textures: вся графика лежит в одном атласе, собранном atlas_packer
+    if (!atlas.loadFromFile("pictures/atlas.png", "pictures/atlas_uv.txt") ||
+        !atlas.hasRegion("background") ||
+        !atlas.hasRegion("panel_L_arrows") ||
+        !atlas.hasRegion("main_panel") ||
+        !atlas.hasRegion("level_goal") ||
+        !atlas.hasRegion("arrows"))
+    {
+        std::cerr << "Failed to load textures" << std::endl;
+        return false;
+    }
+    tileTypeCount = atlas.getTileTypeCount();
+
+    backgroundRegion = atlas.getRegion("background");
+    leftPanelRegion = atlas.getRegion("panel_L_arrows");
+    mainPanelRegion = atlas.getRegion("main_panel");
+    levelGoalRegion = atlas.getRegion("level_goal");
+    bonusArrowsRegion = atlas.getRegion("arrows");
+
+    if (!font.loadFromFile("fonts/fredfredburgerheadline.otf"))
+    {
+        std::cerr << "Failed to load font" << std::endl;
+        return false;
+    }
+
+    const sf::Color hudOutline = hexToColor("#6b46d5");
+    movesGlyphs.reset(new GlyphCache(font, 50, 2, "0123456789-"));
+    goalGlyphs.reset(new GlyphCache(font, 30, 2, "0123456789-/: TileCombBnus"));
+
+    movesText.reset(new HudText(*movesGlyphs, sf::Color::White, hudOutline));
+    movesText->setPosition(sf::Vector2f(90, 530)); // Позиция счетчика ходов
+
+    goalText.reset(new HudText(*goalGlyphs, sf::Color::White, hudOutline));
+    goalText->setPosition(sf::Vector2f(95, 375)); // Позиция счетчика цели
+
+    // Строки целей уровня: по одной на цель, со смещением 40 по вертикали
+    levelGoalsText.reset(new GoalListHud(*goalGlyphs, sf::Color::White, hudOutline, sf::Vector2f(20, 200), 40));
+
+    // Создаем прямоугольник для затемнения экрана
+    darkenOverlay.setSize(sf::Vector2f(targetSize.x, targetSize.y));
+    darkenOverlay.setFillColor(sf::Color(0, 0, 0, 150)); // Черный цвет с полупрозрачностью
+
+    levelCompleteText.setFont(font);
+    levelCompleteText.setString("Level Complete!");
+    levelCompleteText.setCharacterSize(60);
+    levelCompleteText.setFillColor(sf::Color::White);
+    levelCompleteText.setOutlineColor(sf::Color::Green);
+    levelCompleteText.setPosition(targetSize.x / 2 - levelCompleteText.getLocalBounds().width / 2,
+        targetSize.y / 2 - levelCompleteText.getLocalBounds().height / 2);
+
+    // Устанавливаем текст "Game Over!"
+    gameOverText.setFont(font);
+    gameOverText.setString("Game Over!");
+    gameOverText.setCharacterSize(60);
+    gameOverText.setFillColor(sf::Color::White);
+    gameOverText.setOutlineThickness(3);
+    gameOverText.setOutlineColor(hudOutline);
+    gameOverText.setPosition(
+        targetSize.x / 2 - gameOverText.getLocalBounds().width / 2, // Центрируем текст по горизонтали
+        targetSize.y / 2 - gameOverText.getLocalBounds().height / 2 // Центрируем текст по вертикали
+    );
+    return true;
+}
+
+bool GameRenderer::setGpuTiles(bool enabled)
+{
+    if (enabled && !tileShaderLoaded)
+    {
+        tileShaderLoaded = tileRenderer.load(tileTypeCount);
+    }
+    gpuTiles = enabled && tileShaderLoaded;
+    return gpuTiles == enabled;
+}
+
+void GameRenderer::consumeEffects(EffectQueue& effects)
+{
+    EffectEvent effect;
+    while (effects.pop(effect))
+    {
+        if (effect.type == EffectEvent::Type::TileCleared)
+        {
+            sf::Color color = tileParticleColor(effect.tileType);
+            particles.spawnBurst(effect.position, color, 24);
+            particles.spawnSparkles(effect.position, sf::Color::White, 8);
+        }
+        else
+        {
+            particles.spawnCombo(effect.position, effect.comboDepth);
+        }
+    }
+}
+
+void GameRenderer::update(float frameSeconds)
+{
+    particles.update(frameSeconds);
+}
+
+void GameRenderer::draw(sf::RenderTarget& target, const BoardSnapshot& snapshot, float effectTime)
+{
+    movesText->setNumber(snapshot.movesLeft);
+    goalText->setNumber(snapshot.goal);
+    levelGoalsText->setLineCount(snapshot.goalCount);
+    for (int i = 0; i < snapshot.goalCount && i < GoalListHud::MAX_GOAL_LINES; ++i)
+    {
+        const LevelGoal& levelGoal = snapshot.goals[i];
+        levelGoalsText->setLine(i, goalLabel(levelGoal), snapshot.goalProgress[i], levelGoal.target);
+    }
+
+    const sf::Vector2f leftPanelPosition(10, 100);
+    const sf::Vector2f mainPanelPosition(365, 67);
+    const sf::Vector2f levelGoalPosition(65, 340);
+
+    batch.clear();
+    batch.add(backgroundRegion, sf::Vector2f(0, 0));
+    batch.add(mainPanelRegion, mainPanelPosition);
+    batch.add(leftPanelRegion, leftPanelPosition);
+
+    if (gpuTiles)
+    {
+        // Шейдеру уходят только треки, изменившиеся с прошлого кадра
+        TileTrack tracks[HEIGHT_MAP * WIDTH_MAP];
+        for (int i = 0; i < HEIGHT_MAP; ++i)
+        {
+            for (int j = 0; j < WIDTH_MAP; ++j)
+            {
+                tracks[i * WIDTH_MAP + j] = snapshot.tiles[i][j].track;
+            }
+        }
+        tileRenderer.setTracks(tracks, HEIGHT_MAP * WIDTH_MAP);
+        tileRenderer.setTime(snapshot.animationTime, effectTime);
+
+        batch.draw(target);
+        target.draw(tileRenderer);
+        batch.clear();
+    }
+    else
+    {
+        addCpuTiles(snapshot, effectTime);
+    }
+
+    batch.add(levelGoalRegion, levelGoalPosition);
+    batch.draw(target);
+    target.draw(particles);
+
+    target.draw(*levelGoalsText);
+    target.draw(*movesText);
+    target.draw(*goalText);
+
+    if (snapshot.state == GameState::GameOver)
+    {
+        target.draw(darkenOverlay); // Отрисовываем затемнение
+        target.draw(gameOverText); // Отрисовываем текст "Game Over!"
+    }
+    else if (snapshot.state == GameState::LevelComplete)
+    {
+        target.draw(darkenOverlay);
+        target.draw(levelCompleteText);
+    }
+}
 
-    for (int y = 0; y < HEIGHT_MAP; ++y)
+void GameRenderer::addCpuTiles(const BoardSnapshot& snapshot, float effectTime)
+{
+    for (int i = 0; i < HEIGHT_MAP; ++i)
     {
-        for (int x = 0; x < WIDTH_MAP; ++x)
+        for (int j = 0; j < WIDTH_MAP; ++j)
         {
-            if ((y == 0 && (x < 2 || x > 4)) ||
-                (y == 1 && (x == 0 || x == 6)) ||
-                (y == 5 && (x == 0 || x == 6)) ||
-                (y == 6 && (x < 2 || x > 4)))
+            const TileView& view = snapshot.tiles[i][j];
+            SpecialTile special = tileSpecial(view.value);
+            int color = tileColor(view.value);
+            if (special == SpecialTile::ColorBomb)
             {
-                tileMap[y][x] = 9; // Угловые элементы
+                // Цветная бомба перебирает все цвета
+                color = 1 + static_cast<int>(effectTime * 6.0f) % tileTypeCount;
             }
-            else
+
+            const sf::IntRect* region = atlas.getTileRegion(color);
+            if (!region)
+            {
+                continue; // Угловые и пустые ячейки не отображаются
+            }
+
+            sf::Vector2f scale(view.scaleX, view.scaleY);
+            sf::Color tint(255, 255, 255, view.alpha);
+            if (special == SpecialTile::Bomb)
+            {
+                // Бомба пульсирует красным
+                sf::Uint8 pulse = static_cast<sf::Uint8>(170 + 85 * std::sin(effectTime * 6.0f));
+                tint = sf::Color(255, pulse, pulse, view.alpha);
+            }
+
+            batch.add(*region, view.position, scale, tint); // Рисуем спрайт тайла
+
+            if (special == SpecialTile::LineHorizontal || special == SpecialTile::LineVertical)
             {
-                tileMap[y][x] = 0; // Пустые ячейки
+                // Линейный бонус: стрелки поверх тайла, для столбца повёрнуты
+                sf::Vector2f arrowsScale(scale.x * region->width / bonusArrowsRegion.width,
+                    scale.y * region->height / bonusArrowsRegion.height);
+                batch.add(bonusArrowsRegion, view.position, arrowsScale, sf::Color(255, 255, 255, view.alpha / 2),
+                    special == SpecialTile::LineVertical);
             }
         }
     }
+}
 
-    fillInitialTiles(tileMap, tiles, WIDTH_MAP, HEIGHT_MAP, squareSize, clothesTex, startX, startY);
+// Зерно задаёт всю партию: новые тайлы, перемешивания и дрожание подсказки
+void seedSession(GameSession& session, std::uint32_t seed)
+{
+    session.random.seed(seed);
+    session.hints.seed(seed);
+    std::srand(seed);
+}
 
-    std::cout << "old map:" << std::endl; // Выводим в консоль метку "old map:"
-    // Выводим результат в консоль (для проверки)
-    for (int y = 0; y < HEIGHT_MAP; ++y)
+// Параметры безголового прогона
+struct HeadlessOptions
+{
+    std::uint32_t seed = 1;
+    bool endless = false;
+    std::string replayPath;  // Пусто — ходит автоигрок
+    std::string recordPath;  // Куда записать сыгранные намерения
+    int frames = 600;
+    std::string dumpDir;     // Куда складывать кадры
+    int dumpEvery = 1;
+    std::string goldenDir;   // С чем сравнивать кадры
+    bool gpuTiles = false;
+    int allocationBudget = -1; // Выделений кучи на кадр после разгона, -1 — не проверять
+};
+
+const float HEADLESS_FRAME = 1.0f / 60.0f;
+const int AUTOPLAY_IDLE_FRAMES = 60; // Автоигрок ждёт секунду между ходами
+const int ALLOCATION_WARMUP_FRAMES = 120; // Кадры разгона: буферы дорастают до рабочих размеров
+const int GOLDEN_CHANNEL_TOLERANCE = 8; // Допустимое отличие канала, из-за сглаживания драйверов
+const double GOLDEN_PIXEL_FRACTION = 0.001; // Доля отличающихся пикселей, после которой кадр не совпал
+
+std::string frameFileName(const std::string& dir, int frame)
+{
+    std::ostringstream name;
+    name << dir << "/frame_" << std::setw(5) << std::setfill('0') << frame << ".png";
+    return name.str();
+}
+
+// Сравнение с эталоном с допуском; кадры разных драйверов редко совпадают побитно
+bool matchesGolden(const sf::Image& frame, const std::string& path)
+{
+    sf::Image golden;
+    if (!golden.loadFromFile(path))
     {
-        for (int x = 0; x < WIDTH_MAP; ++x)
-        {
-            std::cout << tileMap[y][x] << " ";
-        }
-        std::cout << std::endl;
+        std::cerr << "Golden image " << path << " is missing" << std::endl;
+        return false;
+    }
+    if (golden.getSize() != frame.getSize())
+    {
+        std::cerr << "Golden image " << path << " has a different size" << std::endl;
+        return false;
     }
 
-    for (int y = 0; y < HEIGHT_MAP; ++y)
+    const sf::Uint8* a = frame.getPixelsPtr();
+    const sf::Uint8* b = golden.getPixelsPtr();
+    std::size_t pixelCount = static_cast<std::size_t>(frame.getSize().x) * frame.getSize().y;
+    std::size_t differing = 0;
+    for (std::size_t i = 0; i < pixelCount; ++i)
     {
-        for (int x = 0; x < WIDTH_MAP; ++x)
+        for (int c = 0; c < 4; ++c)
         {
-            tiles[y][x].getAnimator().setMoveSpeed(1.0f); // Увеличиваем скорость перемещения
-            tiles[y][x].getAnimator().setRemoveSpeed(1.0f); // Увеличиваем скорость удаления
-            tiles[y][x].getAnimator().setAppearSpeed(1.0f); // Увеличиваем скорость появления
-            tiles[y][x].getAnimator().setFallSpeed(450.0f); // Увеличиваем скорость падения
+            if (std::abs(a[i * 4 + c] - b[i * 4 + c]) > GOLDEN_CHANNEL_TOLERANCE)
+            {
+                differing++;
+                break;
+            }
         }
     }
 
-    auto future = std::async(std::launch::async, findMatches, std::ref(tileMap));
-    auto toRemove = future.get();
+    if (differing > pixelCount * GOLDEN_PIXEL_FRACTION)
+    {
+        std::cerr << "Frame differs from " << path << " in " << differing << " pixels" << std::endl;
+        return false;
+    }
+    return true;
+}
 
-    // Game state
-    LastMove lastMove;
-    bool dragging = false;
-    int selectedX = -1, selectedY = -1;
-    sf::Clock clock;
-    GameState gameState = GameState::Playing; // Initial game state
-    sf::Clock idleTimer; //таймер бездействия
-    std::vector<sf::Vector2i> highlightedTiles; //Подсвеченыые тайлы
-    bool isBoardValid = true; //Флаг валидности доски
-    idleTimer.restart(); // Запускаем таймер при старте
+// Автоигрок для прогонов без записи: раз в секунду делает первый найденный ход
+// moves — буфер прогона, чтобы ход автоигрока не выделял память
+void autoplay(GameSession& session, int& idleFrames, std::vector<BoardMove>& moves)
+{
+    if (session.gameState != GameState::Playing)
+    {
+        idleFrames = 0;
+        return;
+    }
+    if (++idleFrames < AUTOPLAY_IDLE_FRAMES) return;
+    idleFrames = 0;
 
+    findPossibleMoves(session.tileMap, moves);
+    if (!moves.empty())
+    {
+        const BoardMove& move = moves.front();
+        InputEvent swap = { InputEvent::Type::Swap, move.fromX, move.fromY, move.toX, move.toY };
+        handleInput(session, swap);
+    }
+}
 
-    sf::Font font;
-    sf::Text text;
+void printFrameTimes(const char* label, std::vector<double> times)
+{
+    if (times.empty()) return;
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (double time : times) total += time;
+    std::cout << std::fixed << std::setprecision(3) << label
+        << " mean " << total / times.size()
+        << " ms, p50 " << times[times.size() / 2]
+        << " ms, p95 " << times[times.size() * 95 / 100]
+        << " ms, max " << times.back() << " ms" << std::endl;
+}
 
-    if (!font.loadFromFile("fonts/fredfredburgerheadline.otf"))
+// Безголовый прогон: симуляция и отрисовка в одном потоке шагами по 1/60 с,
+// кадр рисуется во внеэкранную текстуру. Прогон определяется зерном или
+// записью, поэтому кадры можно сравнивать с эталонами, а время кадра —
+// между сборками.
+int runHeadless(const HeadlessOptions& options)
+{
+    Replay replay;
+    replay.seed = options.seed;
+    replay.endless = options.endless;
+    if (!options.replayPath.empty() && !loadReplay(options.replayPath, replay))
     {
-        std::cerr << "Failed to load font" << std::endl;
         return EXIT_FAILURE;
     }
-    text.setFont(font);
-    text.setCharacterSize(60);
-    text.setFillColor(sf::Color::White);
-    text.setPosition(500, 300);
-    text.setOutlineThickness(3);
-    text.setOutlineColor(hexToColor("#6b46d5"));
 
-    int movesLeft = 20; // Начальное количество ходов
-    sf::Text movesText;
-    movesText.setFont(font);
-    movesText.setCharacterSize(50);
-    movesText.setFillColor(sf::Color::White);
-    movesText.setPosition(90, 530); // Позиция счетчика ходов
-    movesText.setOutlineThickness(2);
-    movesText.setOutlineColor(hexToColor("#6b46d5"));
-
-    //int goal = 10;
-    sf::Text goalText;
-    goalText.setFont(font);
-    goalText.setCharacterSize(30);
-    goalText.setFillColor(sf::Color::White);
-    goalText.setPosition(95, 375); // Позиция счетчика цели
-    goalText.setOutlineThickness(2);
-    goalText.setOutlineColor(hexToColor("#6b46d5"));
+    sf::RenderTexture target;
+    if (!target.create(SCENE_WIDTH, SCENE_HEIGHT))
+    {
+        std::cerr << "Failed to create offscreen render target" << std::endl;
+        return EXIT_FAILURE;
+    }
 
-    while (window.isOpen())
+    GameRenderer renderer;
+    if (!renderer.load(target.getSize()))
     {
-        sf::Event event;
-        sf::Time deltaTime = clock.restart();
+        return EXIT_FAILURE;
+    }
+    if (options.gpuTiles && !renderer.setGpuTiles(true))
+    {
+        std::cerr << "Tile shader is unavailable, drawing tiles with the CPU batch" << std::endl;
+    }
 
-        if (!isFallingAnimationFinished(tiles))
-        {
-            for (auto& row : tiles)
-                for (auto& tile : row)
-                    tile.update(deltaTime.asSeconds());
+    // Подсказки считаются синхронно, сохранения не пишутся
+    GameSession session(true);
+    seedSession(session, replay.seed);
+    setLevel(session, loadStartLevel());
+    if (replay.endless)
+    {
+        enableEndless(session);
+    }
+    EffectQueue effectQueue;
+    session.effects = &effectQueue;
 
-            for (int i = 0; i < HEIGHT_MAP; ++i)
+    Replay recording;
+    recording.seed = replay.seed;
+    recording.endless = replay.endless;
+    if (!options.recordPath.empty())
+    {
+        session.recording = &recording;
+    }
+    setupBoard(session);
+
+    BoardSnapshot snapshot;
+    std::vector<double> simulationTimes;
+    std::vector<double> renderTimes;
+    simulationTimes.reserve(options.frames);
+    renderTimes.reserve(options.frames);
+    const int stepsPerFrame = static_cast<int>(HEADLESS_FRAME / SIMULATION_STEP + 0.5f);
+
+    std::size_t nextEvent = 0;
+    int idleFrames = 0;
+    std::vector<BoardMove> autoplayMoves;
+    autoplayMoves.reserve(WIDTH_MAP * HEIGHT_MAP * 2); // Каждая клетка меняется вправо и вниз
+    int mismatchedFrames = 0;
+    std::uint64_t steadyAllocations = 0;
+    std::uint64_t maxFrameAllocations = 0;
+    int framesOverBudget = 0;
+    int frame = 0;
+    sf::Clock clock;
+    for (; frame < options.frames; ++frame)
+    {
+        std::uint64_t allocationsBefore = threadAllocationCount();
+        clock.restart();
+        for (int step = 0; step < stepsPerFrame; ++step)
+        {
+            // Намерение применяется перед тем шагом, перед которым его записали
+            while (nextEvent < replay.events.size() && replay.events[nextEvent].step <= session.stepCount)
             {
-                for (int j = 0; j < WIDTH_MAP; ++j)
-                {
-                    window.draw(tiles[i][j].sprite);
-                }
+                handleInput(session, replay.events[nextEvent++].input);
             }
+            updateSimulation(session, SIMULATION_STEP);
         }
-
-        // Проверка на совпадения
-        if (hasMatches(tileMap))
+        if (options.replayPath.empty())
         {
-            findAndReplaceMatches(tileMap, tiles, WIDTH_MAP, HEIGHT_MAP, squareSize, clothesTex, startX, startY, corners);
+            autoplay(session, idleFrames, autoplayMoves);
         }
-
-        if (idleTimer.getElapsedTime().asSeconds() > 5.0f && isBoardValid)
+        publishSnapshot(session, snapshot);
+        simulationTimes.push_back(clock.restart().asMicroseconds() / 1000.0);
+
+        // Время кадра — только работа CPU над отрисовкой, без чтения кадра обратно
+        renderer.consumeEffects(effectQueue);
+        renderer.update(HEADLESS_FRAME);
+        target.clear();
+        renderer.draw(target, snapshot, snapshot.animationTime);
+        target.display();
+        renderTimes.push_back(clock.restart().asMicroseconds() / 1000.0);
+
+        // Бюджет считается по симуляции и отрисовке, без сохранения кадров
+        if (frame >= ALLOCATION_WARMUP_FRAMES)
         {
-            auto possibleMatches = findPossibleMatches(tileMap);
-
-            if (!possibleMatches.empty())
+            std::uint64_t allocations = threadAllocationCount() - allocationsBefore;
+            steadyAllocations += allocations;
+            maxFrameAllocations = std::max(maxFrameAllocations, allocations);
+            if (options.allocationBudget >= 0 && allocations > static_cast<std::uint64_t>(options.allocationBudget))
             {
-                // Берем первый найденный возможный ход
-                highlightedTiles = possibleMatches[0];
-
-                // Подсвечиваем тайлы
-                for (auto& pos : highlightedTiles)
+                if (framesOverBudget == 0)
                 {
-                    tiles[pos.y][pos.x].startSelectAnimation();
+                    std::cerr << "Frame " << frame << " made " << allocations << " heap allocations, budget "
+                        << options.allocationBudget << std::endl;
                 }
+                framesOverBudget++;
             }
-            else
-            {
-                // Перемешиваем доску если нет возможных ходов
-                shuffleBoard(tileMap, tiles, clothesTex, startX, startY, squareSize);
-                isBoardValid = false;
+        }
 
-                std::cout << "reverse map:" << std::endl;
-                // Выводим результат в консоль (для проверки)
-                for (int y = 0; y < HEIGHT_MAP; ++y)
-                {
-                    for (int x = 0; x < WIDTH_MAP; ++x)
-                    {
-                        std::cout << tileMap[y][x] << " ";
-                    }
-                    std::cout << std::endl;
-                }
+        bool dumpFrame = frame % options.dumpEvery == 0;
+        if (dumpFrame && (!options.dumpDir.empty() || !options.goldenDir.empty()))
+        {
+            sf::Image image = target.getTexture().copyToImage();
+            if (!options.dumpDir.empty() && !image.saveToFile(frameFileName(options.dumpDir, frame)))
+            {
+                std::cerr << "Failed to write frame " << frame << std::endl;
+            }
+            if (!options.goldenDir.empty() && !matchesGolden(image, frameFileName(options.goldenDir, frame)))
+            {
+                mismatchedFrames++;
             }
-            idleTimer.restart();
         }
 
-        if (hasMatches(tileMap))
+        if (snapshot.closeRequested)
         {
-            //removeMatches(tileMap, tiles, toRemove, removedTilesCount); // Обновляем счетчики
-            findAndReplaceMatches(tileMap, tiles, WIDTH_MAP, HEIGHT_MAP, squareSize, clothesTex, startX, startY, corners);
+            ++frame;
+            break;
         }
+    }
+
+    if (!options.recordPath.empty())
+    {
+        saveReplay(options.recordPath, recording);
+    }
+
+    std::cout << "Headless run: " << frame << " frames, seed " << replay.seed
+        << (replay.endless ? ", endless, " + std::to_string(session.rowsScrolled) + " rows scrolled" : "")
+        << ", tiles " << (renderer.hasGpuTiles() ? "GPU shader" : "CPU batch") << std::endl;
+    printFrameTimes("Render CPU time:", renderTimes);
+    printFrameTimes("Simulation time:", simulationTimes);
+    if (allocationCountingEnabled() && frame > ALLOCATION_WARMUP_FRAMES)
+    {
+        std::cout << "Heap allocations per frame: mean "
+            << static_cast<double>(steadyAllocations) / (frame - ALLOCATION_WARMUP_FRAMES)
+            << ", max " << maxFrameAllocations << std::endl;
+    }
+
+    if (framesOverBudget > 0)
+    {
+        std::cerr << framesOverBudget << " frames exceed the allocation budget" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (mismatchedFrames > 0)
+    {
+        std::cerr << mismatchedFrames << " frames differ from the golden images" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+// Синтетические обмены для замера задержки (--latency-test). Событие
+// «приходит» в случайный момент между кадрами, как настоящее от ОС, и ждёт
+// опроса; подаётся только на спокойную доску и тем же путём, что мышь:
+// через пиксели окна и слой ввода.
+struct LatencyDriver
+{
+    explicit LatencyDriver(int sampleCount) :
+        probe(sampleCount),
+        board(HEIGHT_MAP, std::vector<int>(WIDTH_MAP, 0))
+    {
+        moves.reserve(WIDTH_MAP * HEIGHT_MAP * 2);
+    }
+
+    LatencyProbe probe;
+    std::mt19937 random{ 1 };
+    std::chrono::steady_clock::time_point due;
+    bool scheduled = false;
+    bool restarting = false;
+    std::vector<std::vector<int>> board;
+    std::vector<BoardMove> moves;
+};
+
+const int LATENCY_MIN_DELAY_MS = 20;  // Пауза перед обменом на спокойной доске
+const int LATENCY_MAX_DELAY_MS = 250;
+const int LATENCY_LOST_SECONDS = 2;
+
+void driveLatencyTest(LatencyDriver& driver, const BoardSnapshot& snapshot, BoardInput& boardInput,
+    InputQueue& inputQueue, const sf::RenderWindow& window)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (driver.probe.isBusy())
+    {
+        // Намерение потерялось (переполнение очереди) — замер не в счёт
+        if (now - driver.due > std::chrono::seconds(LATENCY_LOST_SECONDS)) driver.probe.cancel();
+        return;
+    }
+
+    // Партия кончилась — сразу новая, иначе окно закроется по таймеру
+    if (snapshot.state == GameState::GameOver || snapshot.state == GameState::LevelComplete)
+    {
+        if (!driver.restarting) driver.restarting = inputQueue.push({ InputEvent::Type::Restart });
+        driver.scheduled = false;
+        return;
+    }
+    driver.restarting = false;
+    if (snapshot.state != GameState::Playing)
+    {
+        driver.scheduled = false;
+        return;
+    }
+
+    if (!driver.scheduled)
+    {
+        std::uniform_int_distribution<int> delay(LATENCY_MIN_DELAY_MS, LATENCY_MAX_DELAY_MS);
+        driver.due = now + std::chrono::milliseconds(delay(driver.random));
+        driver.scheduled = true;
+        return;
+    }
+    if (now < driver.due) return;
+    driver.scheduled = false;
+
+    for (int y = 0; y < HEIGHT_MAP; ++y)
+    {
+        for (int x = 0; x < WIDTH_MAP; ++x) driver.board[y][x] = snapshot.tiles[y][x].value;
+    }
+    findPossibleMoves(driver.board, driver.moves);
+    if (driver.moves.empty()) return;
+    const BoardMove& move = driver.moves[std::uniform_int_distribution<std::size_t>(0, driver.moves.size() - 1)(driver.random)];
+
+    auto pixelOf = [&window](int x, int y)
+    {
+        return window.mapCoordsToPixel(sf::Vector2f(START_X + (x + 0.5f) * SQUARE_SIZE, START_Y + (y + 0.5f) * SQUARE_SIZE));
+    };
+    sf::Vector2i from = pixelOf(move.fromX, move.fromY);
+    sf::Vector2i to = pixelOf(move.toX, move.toY);
+    sf::Event press;
+    press.type = sf::Event::MouseButtonPressed;
+    press.mouseButton = { sf::Mouse::Left, from.x, from.y };
+    sf::Event release;
+    release.type = sf::Event::MouseButtonReleased;
+    release.mouseButton = { sf::Mouse::Left, to.x, to.y };
+
+    // Queued до подачи: симуляция может взять намерение раньше, чем мы вернёмся
+    std::uint32_t tag = driver.probe.begin(driver.due);
+    driver.probe.mark(tag, LatencyStage::Queued);
+    boardInput.setTag(tag);
+    boardInput.handleEvent(press, window);
+    boardInput.handleEvent(release, window);
+    boardInput.setTag(0);
+}
 
-        if (!highlightedTiles.empty() && gameState == GameState::Playing)
+// Окно в целое или дробное число сцен, сколько влезает в 90% рабочего
+// стола: на 4K оно не выходит крошечным, на маленьком экране не вылезает
+sf::VideoMode chooseWindowMode()
+{
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    float fit = 0.9f * std::min(desktop.width / static_cast<float>(SCENE_WIDTH), desktop.height / static_cast<float>(SCENE_HEIGHT));
+    // Дробный масштаб — шагами по четверти, чтобы пиксели сцены ложились ровнее
+    float factor = fit >= 1.0f ? std::floor(fit * 4.0f) / 4.0f : fit;
+    if (desktop.width == 0 || desktop.height == 0) factor = 1.0f;
+    return sf::VideoMode(static_cast<unsigned>(SCENE_WIDTH * factor), static_cast<unsigned>(SCENE_HEIGHT * factor));
+}
+
+int main(int argc, char* argv[])
+{
+    setlocale(LC_ALL, "RUSSIAN");
+
+    // --gpu-tiles: анимации тайлов считает вершинный шейдер (F2 — переключить)
+    // --seed N: партия с заданным зерном, без продолжения сохранения
+    // --record FILE: записать намерения игрока для повтора
+    // --endless: бесконечный режим, доска сдвигается вверх по мере удаления
+    // --headless: прогон без окна, см. runHeadless и README
+    // --fullscreen: на весь экран в его разрешении (киоски)
+    // --render-scale S: постоянная доля внутреннего разрешения 0.5..1 вместо подстройки
+    // --telemetry-port N: порт метрик Prometheus на localhost, 0 — без него
+    // --telemetry-log FILE: журнал метрик, строка JSON каждые 10 секунд
+    // --no-telemetry: ни порта, ни журнала
+    // --single-thread: симуляция в потоке отрисовки, перед каждым кадром
+    // --vsync: кадр ждёт вертикальной развёртки
+    // --latency-test N: N синтетических обменов, задержка ввода по этапам, выход
+    // --print-boards: доски в консоль после каждого каскада, для отладки
+    bool headless = false;
+    bool singleThread = false;
+    bool vsync = false;
+    int latencySamples = 0;
+    bool seedGiven = false;
+    bool fullscreen = false;
+    float renderScale = 0.0f;
+    int telemetryPort = TELEMETRY_DEFAULT_PORT;
+    std::string telemetryLog = "telemetry.log";
+    HeadlessOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--gpu-tiles") options.gpuTiles = true;
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--fullscreen") fullscreen = true;
+        else if (arg == "--render-scale" && hasValue) renderScale = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--endless") options.endless = true;
+        else if (arg == "--telemetry-port" && hasValue) telemetryPort = std::min(std::max(0, std::atoi(argv[++i])), 65535);
+        else if (arg == "--telemetry-log" && hasValue) telemetryLog = argv[++i];
+        else if (arg == "--no-telemetry") { telemetryPort = 0; telemetryLog.clear(); }
+        else if (arg == "--single-thread") singleThread = true;
+        else if (arg == "--vsync") vsync = true;
+        else if (arg == "--print-boards") printBoards = true;
+        else if (arg == "--latency-test" && hasValue) latencySamples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) { options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10)); seedGiven = true; }
+        else if (arg == "--record" && hasValue) options.recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue) options.replayPath = argv[++i];
+        else if (arg == "--frames" && hasValue) options.frames = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--dump" && hasValue) options.dumpDir = argv[++i];
+        else if (arg == "--dump-every" && hasValue) options.dumpEvery = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--golden" && hasValue) options.goldenDir = argv[++i];
+        else if (arg == "--alloc-budget" && hasValue) options.allocationBudget = std::max(0, std::atoi(argv[++i]));
+        else
         {
-            // Сбрасываем подсветку
-            for (auto& pos : highlightedTiles)
-            {
-                tiles[pos.y][pos.x].stopSelectAnimation();
-            }
-            highlightedTiles.clear();
-            isBoardValid = true;
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return EXIT_FAILURE;
         }
+    }
+
+    if (options.allocationBudget >= 0 && !allocationCountingEnabled())
+    {
+        std::cerr << "--alloc-budget needs a build with BIGWASH_COUNT_ALLOCATIONS" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (headless)
+    {
+        return runHeadless(options);
+    }
+
+    // Метрики пишутся всегда; наружу их отдаёт свой поток
+    TelemetryExporter telemetry(static_cast<unsigned short>(telemetryPort), telemetryLog);
+
+    sf::RenderWindow window;
+    if (fullscreen)
+    {
+        window.create(sf::VideoMode::getDesktopMode(), "Big wash", sf::Style::Fullscreen);
+    }
+    else
+    {
+        window.create(chooseWindowMode(), "Big wash");
+    }
+    window.setVerticalSyncEnabled(vsync);
+
+    GameRenderer renderer;
+    if (!renderer.load(sf::Vector2u(SCENE_WIDTH, SCENE_HEIGHT)))
+    {
+        return EXIT_FAILURE;
+    }
+    ResolutionScaler scaler(sf::Vector2f(SCENE_WIDTH, SCENE_HEIGHT));
+    scaler.setFixedScale(renderScale);
+    if (!scaler.resize(window.getSize()))
+    {
+        return EXIT_FAILURE;
+    }
+    window.setView(scaler.getWindowView());
+    // Если шейдер не собрался, остаёмся на пакете
+    renderer.setGpuTiles(options.gpuTiles);
+
+    // Сохранение пишется после каждого устоявшегося каскада; пишущий поток
+    // живёт дольше потока симуляции и дописывает последний снимок
+    const std::string SAVE_PATH = "savegame.bin";
+    SaveWriter saver(SAVE_PATH);
+
+    std::uint32_t seed = seedGiven ? options.seed : std::random_device{}();
+    GameSession session;
+    seedSession(session, seed);
+    setLevel(session, loadStartLevel());
+    session.saver = &saver;
+    if (options.endless)
+    {
+        enableEndless(session);
+    }
+
+    Replay recording;
+    recording.seed = seed;
+    recording.endless = options.endless;
+    if (!options.recordPath.empty())
+    {
+        session.recording = &recording;
+    }
+
+    // Записанная партия должна начинаться с доски по зерну
+    SavedGame savedGame;
+    if (!seedGiven && !options.endless && options.recordPath.empty() &&
+        loadSavedGame(SAVE_PATH, savedGame) && restoreSession(session, savedGame))
+    {
+        std::cout << "Game resumed from " << SAVE_PATH << std::endl;
+    }
+    else
+    {
+        setupBoard(session);
+    }
 
+    EffectQueue effectQueue;
+    sf::Clock frameClock;
+    sf::Clock effectClock; // Время для пульсации бонусных тайлов
+    session.effects = &effectQueue;
+
+    InputQueue inputQueue;
+    BoardInput boardInput(*session.shape, sf::Vector2f(START_X, START_Y), SQUARE_SIZE, inputQueue);
+
+    // Редактор живёт в потоке отрисовки; готовый уровень уходит в симуляцию
+    LevelQueue levelQueue;
+    session.levels = &levelQueue;
+    LevelEditor editor(renderer.getAtlas(), renderer.getFont(), sf::Vector2f(START_X, START_Y), SQUARE_SIZE, tileTypeCount);
+    LevelLayout editedLevel = session.level; // Копия потока отрисовки
+    bool editing = false;
+    TripleBuffer<BoardSnapshot> snapshots;
+    publishSnapshot(session, snapshots.writeBuffer());
+    snapshots.publish();
+
+    std::unique_ptr<LatencyDriver> latencyTest;
+    if (latencySamples > 0)
+    {
+        latencyTest.reset(new LatencyDriver(latencySamples));
+        session.latency = &latencyTest->probe;
+    }
+
+    // С этого момента session принадлежит потоку симуляции; в однопоточном
+    // режиме симуляция идёт здесь же перед каждым кадром
+    std::atomic<bool> simulationRunning(true);
+    std::thread simulationThread;
+    if (!singleThread)
+    {
+        simulationThread = std::thread(runSimulation, std::ref(session), std::ref(inputQueue), std::ref(snapshots), std::ref(simulationRunning));
+    }
+    sf::Clock simulationClock;
+    float simulationAccumulator = 0.0f;
+    std::uint64_t frameAllocations = threadAllocationCount();
+
+    while (window.isOpen())
+    {
         // Обработка событий
+        sf::Event event;
         while (window.pollEvent(event))
         {
             if (event.type == sf::Event::Closed)
             {
                 window.close();
             }
-
-            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R)
+            else if (event.type == sf::Event::Resized)
             {
-                // Перезапуск игры
-                gameState = GameState::Playing; // Сброс состояния игры
-                movesLeft = 20; // Сброс счетчика ходов
-                removedTilesCount.clear(); // Очистка счетчиков удаленных тайлов
-                goal = 10; // Сброс цели
-
-                // Переинициализация игрового поля
-                tileMap = std::vector<std::vector<int>>(HEIGHT_MAP, std::vector<int>(WIDTH_MAP, 0));
-                tiles = std::vector<std::vector<Tile>>(HEIGHT_MAP, std::vector<Tile>(WIDTH_MAP));
-
-                // Установка угловых элементов
-                for (const auto& pos : corners) tileMap[pos.y][pos.x] = 9;
-
-                // Заполнение начальных тайлов
-                fillInitialTiles(tileMap, tiles, WIDTH_MAP, HEIGHT_MAP, squareSize, clothesTex, startX, startY);
-
-                // Сброс выделения и состояния перетаскивания
-                selectedTile = { -1, -1 };
-                isDragging = false;
-                dragging = false;
-
-                std::cout << "Game restarted!" << std::endl;
+                // Ввод сразу переводит пиксели в координаты сцены по новому виду
+                scaler.resize(sf::Vector2u(event.size.width, event.size.height));
+                window.setView(scaler.getWindowView());
             }
-
-            else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left && gameState == GameState::Playing)
+            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3 && !options.endless)
             {
-                sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-                for (int y = 0; y < HEIGHT_MAP; ++y)
+                // F3 — редактор уровня; при выходе партия начинается с правленой раскладки
+                if (!editing)
                 {
-                    for (int x = 0; x < WIDTH_MAP; ++x)
-                    {
-                        if (isSquareSelected(x, y, mousePos.x, mousePos.y, squareSize, startX, startY))
-                        {
-                            // Сбрасываем предыдущее выделение
-                            if (selectedTile.x != -1) {
-                                tiles[selectedTile.y][selectedTile.x].stopSelectAnimation();
-                            }
-
-                            selectedTile = { x, y };
-                            tiles[y][x].startSelectAnimation();
-                            selectedX = x;
-                            selectedY = y;
-                            dragging = true;
-
-                            // Вычисляем смещение курсора относительно центра тайла
-                            dragOffset = tiles[y][x].getPosition() - sf::Vector2f(mousePos.x, mousePos.y);
-                        }
-                    }
+                    editor.open(editedLevel);
                 }
+                else if (levelQueue.push(editor.getLayout()))
+                {
+                    editedLevel = editor.getLayout();
+                    boardInput.setShape(makeBoardShape(editedLevel));
+                }
+                editing = !editing;
             }
-
-            else if (event.type == sf::Event::MouseMoved && isDragging)
-            {
-                // Перемещаем тайл за курсором
-                sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-                tiles[selectedY][selectedX].setPosition(mousePos.x + dragOffset.x, mousePos.y + dragOffset.y);
-            }
-
-            else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left && dragging && gameState == GameState::Playing)
+            else if (editing)
             {
-                if (selectedTile.x != -1)
+                if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::S && event.key.control)
                 {
-                    tiles[selectedTile.y][selectedTile.x].stopSelectAnimation();
-                    selectedTile = { -1, -1 };
+                    if (saveLevel(LEVEL_PATH, editor.getLayout())) std::cout << "Level saved to " << LEVEL_PATH << std::endl;
                 }
-
-                dragging = false;
-                sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-                int targetX = (mousePos.x - startX) / squareSize;
-                int targetY = (mousePos.y - startY) / squareSize;
-
-                if (targetX >= 0 && targetX < WIDTH_MAP && targetY >= 0 && targetY < HEIGHT_MAP &&
-                    (abs(targetX - selectedX) + abs(targetY - selectedY) == 1))
+                else
                 {
-                    // Проверяем, что ни исходный, ни целевой тайл не являются угловыми
-                    bool isSelectedCorner = false;
-                    bool isTargetCorner = false;
-
-                    for (const auto& corner : corners)
-                    {
-                        if (corner.x == selectedX && corner.y == selectedY) isSelectedCorner = true;
-                        if (corner.x == targetX && corner.y == targetY) isTargetCorner = true;
-                    }
-
-                    if (!isSelectedCorner && !isTargetCorner)
-                    {
-                        lastMove = { selectedX, selectedY, targetX, targetY };
-
-                        // Swap tiles
-                        std::swap(tiles[selectedY][selectedX], tiles[targetY][targetX]);
-                        std::swap(tileMap[selectedY][selectedX], tileMap[targetY][targetX]);
-
-                        // Set animation positions
-                        tiles[selectedY][selectedX].startMoving(tiles[targetY][targetX].getPosition());
-                        tiles[targetY][targetX].startMoving(tiles[selectedY][selectedX].getPosition());
-                        gameState = GameState::Swapping; // Set game state to swapping
-
-                        // Check matches
-                        if (!hasMatches(tileMap))
-                        {
-                            // Если совпадений нет, откатываем обмен
-                            revertSwap(tileMap, tiles, lastMove);
-                        }
-                        else
-                        {
-                            // Если есть совпадения, продолжаем обработку
-                            removeMatches(tileMap, tiles, toRemove, removedTilesCount); // Обновляем счетчики
-                            findAndReplaceMatches(tileMap, tiles, WIDTH_MAP, HEIGHT_MAP, squareSize, clothesTex, startX, startY, corners);
-                            movesLeft--;
-                        }
-                    }
+                    editor.handleEvent(event, window);
                 }
             }
-        }
-
-        // Game state machine
-        switch (gameState)
-        {
-        case GameState::Playing:
-            // Nothing to do here
-            break;
-        case GameState::Swapping:
-            // Check if swapping animation is complete
-            if (tiles[lastMove.selectedY][lastMove.selectedX].getAnimator().isFinished() &&
-                tiles[lastMove.targetY][lastMove.targetX].getAnimator().isFinished())
+            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::R)
             {
-                gameState = GameState::RemovingMatches; // Move to removing state
+                inputQueue.push({ InputEvent::Type::Restart });
             }
-            break;
-        case GameState::RemovingMatches:
-        {
-            // Find matches and start removing animations
-            toRemove = findMatches(tileMap);
-            removeMatches(tileMap, tiles, toRemove, removedTilesCount);
-            gameState = GameState::ApplyingGravity;
-            break;
-        }
-        case GameState::ApplyingGravity:
-        {
-            bool allFinished = true;
-            for (auto& row : tiles)
-                for (auto& tile : row)
-                    if (tile.getState() == TileState::Falling)
-                        allFinished = false;
-
-            if (allFinished)
-                gameState = GameState::FillingEmptyTiles;
-            break;
-        }
-        case GameState::FillingEmptyTiles:
-        {
-            bool fallingFinished = true;
-            for (int y = 0; y < HEIGHT_MAP; ++y)
+            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F2)
             {
-                for (int x = 0; x < WIDTH_MAP; ++x)
-                {
-                    if (tiles[y][x].isFalling() && !tiles[y][x].getAnimator().isFinished())
-                    {
-                        fallingFinished = false;
-                        break;
-                    }
-                }
-                if (!fallingFinished) break;
+                renderer.setGpuTiles(!renderer.hasGpuTiles());
+                std::cout << (renderer.hasGpuTiles() ? "Tiles: GPU shader" : "Tiles: CPU batch") << std::endl;
             }
-
-            if (fallingFinished)
+            else
             {
-                // Проверяем совпадения после заполнения
-                if (hasMatches(tileMap))
-                {
-                    gameState = GameState::RemovingMatches;
-                }
-                else {
-                    gameState = GameState::Playing;
-                }
+                boardInput.handleEvent(event, window);
             }
-            break;
         }
-        case GameState::LevelComplete:
+
+        if (latencyTest)
         {
-            static bool shown = false;
-            if (!shown)
-            {
-                // Показать Level Complete только один раз
-                shown = true;
-
-                sf::RectangleShape darkenOverlay;
-                darkenOverlay.setSize(sf::Vector2f(window.getSize().x, window.getSize().y));
-                darkenOverlay.setFillColor(sf::Color(0, 0, 0, 150));
-
-                sf::Text levelCompleteText;
-                levelCompleteText.setFont(font);
-                levelCompleteText.setString("Level Complete!");
-                levelCompleteText.setCharacterSize(60);
-                levelCompleteText.setFillColor(sf::Color::White);
-                levelCompleteText.setOutlineColor(sf::Color::Green);
-                levelCompleteText.setPosition(window.getSize().x / 2 - levelCompleteText.getLocalBounds().width / 2,
-                    window.getSize().y / 2 - levelCompleteText.getLocalBounds().height / 2);
-
-                window.draw(darkenOverlay);
-                window.draw(levelCompleteText);
-                window.display();
-
-                sf::sleep(sf::seconds(3));
-                window.close();
-            }
-            break;
+            driveLatencyTest(*latencyTest, snapshots.readBuffer(), boardInput, inputQueue, window);
         }
+        if (singleThread)
+        {
+            tickSimulation(session, inputQueue, snapshots, simulationClock.restart().asSeconds(), simulationAccumulator);
         }
-        
 
-        drawLevelGoals(window, firstLevelGoals, removedTilesCount, font, 20, 200);
+        snapshots.update();
+        const BoardSnapshot& snapshot = snapshots.readBuffer();
+        std::uint32_t shownTag = latencyTest ? snapshot.inputTag : 0;
+        if (latencyTest) latencyTest->probe.mark(shownTag, LatencyStage::PickedUp);
 
-        // Проверка завершения уровня
-        if (isLevelComplete(firstLevelGoals, removedTilesCount))
+        // Выделения прошлого кадра: от начала до конца его тела
+        if (allocationCountingEnabled())
         {
-            if (areAllAnimationsFinished(tiles))
-            {
-                gameState = GameState::LevelComplete;
-            }
+            std::uint64_t allocations = threadAllocationCount();
+            telemetryRecord(TelemetryHistogram::FrameAllocations, allocations - frameAllocations);
+            frameAllocations = allocations;
         }
+        float frameSeconds = frameClock.restart().asSeconds();
+        telemetryRecord(TelemetryHistogram::FrameNanoseconds, static_cast<std::uint64_t>(frameSeconds * 1e9f));
+        renderer.consumeEffects(effectQueue);
+        renderer.update(frameSeconds);
 
-        if (movesLeft <= 0)
+        if (snapshot.closeRequested)
         {
-            // Создаем прямоугольник для затемнения экрана
-            sf::RectangleShape darkenOverlay;
-            darkenOverlay.setSize(sf::Vector2f(window.getSize().x, window.getSize().y)); // Размеры окна
-            darkenOverlay.setFillColor(sf::Color(0, 0, 0, 150)); // Черный цвет с полупрозрачностью
-
-            // Устанавливаем текст "Game Over!"
-            text.setString("Game Over!");
-            text.setPosition(
-                window.getSize().x / 2 - text.getLocalBounds().width / 2, // Центрируем текст по горизонтали
-                window.getSize().y / 2 - text.getLocalBounds().height / 2 // Центрируем текст по вертикали
-            );
-
-            // Отрисовываем затемнение и текст
-            window.draw(backgroundSprite); // Отрисовываем фон
-            window.draw(mainPanel);
-            window.draw(leftPanel);
-            for (int i = 0; i < HEIGHT_MAP; ++i)
-            {
-                for (int j = 0; j < WIDTH_MAP; ++j)
-                {
-                    window.draw(tiles[i][j].sprite); // Рисуем спрайт тайла
-                }
-            }
-            window.draw(movesText);
-            window.draw(darkenOverlay); // Отрисовываем затемнение
-            window.draw(text); // Отрисовываем текст "Game Over!"
-            window.display();
-
-            sf::sleep(sf::seconds(3)); // Пауза перед закрытием окна
             window.close();
+            break;
         }
 
-        movesText.setString(std::to_string(movesLeft));
-        goalText.setString(std::to_string(goal));
-
-        // Обновляем и рисуем элементы одежды на игровом поле
-        for (int i = 0; i < HEIGHT_MAP; ++i)
+        sf::RenderTarget& scene = scaler.beginFrame();
+        renderer.draw(scene, snapshot, effectClock.getElapsedTime().asSeconds());
+        if (editing)
         {
-            for (int j = 0; j < WIDTH_MAP; ++j)
-            {
-                tiles[i][j].update(deltaTime.asSeconds()); // Обновляем состояние тайла
-                updateTileSprite(tiles[i][j], clothesTex);
-            }
+            editor.update();
+            scene.draw(editor);
         }
-
         window.clear();
-        window.draw(backgroundSprite);
-        window.draw(mainPanel);
-        window.draw(leftPanel);
+        scaler.present(window, frameSeconds);
+        if (latencyTest) latencyTest->probe.mark(shownTag, LatencyStage::Drawn);
+        window.display();
 
-        for (int i = 0; i < HEIGHT_MAP; ++i)
+        if (latencyTest)
         {
-            for (int j = 0; j < WIDTH_MAP; ++j)
+            latencyTest->probe.mark(shownTag, LatencyStage::Presented);
+            if (latencyTest->probe.isComplete())
             {
-                window.draw(tiles[i][j].sprite); // Рисуем спрайт тайла
+                std::cout << (singleThread ? "single-threaded" : "threaded") << (vsync ? ", vsync" : ", no vsync") << std::endl;
+                latencyTest->probe.printReport(std::cout);
+                window.close();
             }
         }
+    }
 
-        window.draw(levelGoalSprite);
-        window.draw(movesText);
-        window.draw(goalText);
-        window.display();
+    simulationRunning.store(false, std::memory_order_release);
+    if (simulationThread.joinable())
+    {
+        simulationThread.join();
+    }
+
+    if (!options.recordPath.empty())
+    {
+        saveReplay(options.recordPath, recording);
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,302 @@
+#include "match_classifier.h"
+
+#include <algorithm>
+
+SpecialTile specialForShape(MatchShape shape, bool horizontal)
+{
+    switch (shape)
+    {
+    case MatchShape::Line4: return horizontal ? SpecialTile::LineHorizontal : SpecialTile::LineVertical;
+    case MatchShape::Line5: return SpecialTile::ColorBomb;
+    case MatchShape::LShape:
+    case MatchShape::TShape: return SpecialTile::Bomb;
+    default: return SpecialTile::None;
+    }
+}
+
+MatchClassifier::MatchClassifier(int width, int height) :
+    width(width),
+    height(height),
+    parent(width * height),
+    horizontalRun(width * height),
+    verticalRun(width * height),
+    horizontalEnd(width * height),
+    verticalEnd(width * height),
+    groupOfRoot(width * height),
+    groups(width * height / 3 + 1),
+    accumulators(width * height / 3 + 1),
+    clearMask(height, std::vector<bool>(width, false)),
+    detonated(width * height),
+    queue(width * height)
+{
+}
+
+int MatchClassifier::find(int cell)
+{
+    // Сжатие пути делением пополам
+    while (parent[cell] != cell)
+    {
+        parent[cell] = parent[parent[cell]];
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+void MatchClassifier::unite(int a, int b)
+{
+    a = find(a);
+    b = find(b);
+    if (a != b)
+    {
+        parent[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+void MatchClassifier::clearAll()
+{
+    for (auto& row : clearMask)
+    {
+        std::fill(row.begin(), row.end(), false);
+    }
+    groupCount = 0;
+}
+
+int MatchClassifier::classify(const std::vector<std::vector<int>>& tileMap,
+    int swapAX, int swapAY, int swapBX, int swapBY)
+{
+    const int cells = width * height;
+    for (int cell = 0; cell < cells; ++cell)
+    {
+        parent[cell] = cell;
+        horizontalRun[cell] = 0;
+        verticalRun[cell] = 0;
+        horizontalEnd[cell] = 0;
+        verticalEnd[cell] = 0;
+        groupOfRoot[cell] = -1;
+    }
+    clearAll();
+
+    // Серии по строкам
+    for (int y = 0; y < height; ++y)
+    {
+        int x = 0;
+        while (x < width)
+        {
+            int color = tileColor(tileMap[y][x]);
+            int end = x + 1;
+            if (isMatchable(tileMap[y][x]))
+            {
+                while (end < width && tileColor(tileMap[y][end]) == color) ++end;
+            }
+            int length = end - x;
+            if (length >= 3)
+            {
+                for (int i = x; i < end; ++i)
+                {
+                    int cell = y * width + i;
+                    horizontalRun[cell] = static_cast<std::uint8_t>(std::min(length, 255));
+                    horizontalEnd[cell] = (i == x || i == end - 1);
+                    if (i > x) unite(cell - 1, cell);
+                }
+            }
+            x = end;
+        }
+    }
+
+    // Серии по столбцам
+    for (int x = 0; x < width; ++x)
+    {
+        int y = 0;
+        while (y < height)
+        {
+            int color = tileColor(tileMap[y][x]);
+            int end = y + 1;
+            if (isMatchable(tileMap[y][x]))
+            {
+                while (end < height && tileColor(tileMap[end][x]) == color) ++end;
+            }
+            int length = end - y;
+            if (length >= 3)
+            {
+                for (int i = y; i < end; ++i)
+                {
+                    int cell = i * width + x;
+                    verticalRun[cell] = static_cast<std::uint8_t>(std::min(length, 255));
+                    verticalEnd[cell] = (i == y || i == end - 1);
+                    if (i > y) unite(cell - width, cell);
+                }
+            }
+            y = end;
+        }
+    }
+
+    // Сборка групп по корням union-find: один проход по размеченным клеткам
+    for (int cell = 0; cell < cells; ++cell)
+    {
+        int hRun = horizontalRun[cell];
+        int vRun = verticalRun[cell];
+        if (hRun == 0 && vRun == 0) continue;
+
+        int x = cell % width;
+        int y = cell / width;
+        clearMask[y][x] = true;
+
+        int root = find(cell);
+        if (groupOfRoot[root] < 0)
+        {
+            groupOfRoot[root] = groupCount;
+            groups[groupCount] = { MatchShape::Line3, tileColor(tileMap[y][x]), 0, x, y, hRun >= vRun };
+            accumulators[groupCount] = GroupAccumulator();
+            groupCount++;
+        }
+        int index = groupOfRoot[root];
+        MatchGroup& group = groups[index];
+        GroupAccumulator& acc = accumulators[index];
+        group.size++;
+
+        if ((x == swapAX && y == swapAY) || (x == swapBX && y == swapBY))
+        {
+            acc.swapCell = cell;
+        }
+
+        if (hRun > 0 && vRun > 0)
+        {
+            // Пересечение серий: угол буквы L или перекладина T
+            bool isCorner = horizontalEnd[cell] && verticalEnd[cell];
+            if (acc.crossCell < 0 || (!isCorner && acc.crossIsCorner))
+            {
+                acc.crossCell = cell;
+                acc.crossIsCorner = isCorner;
+            }
+        }
+
+        // Середина самой длинной серии — опорная клетка по умолчанию
+        int longest = std::max(hRun, vRun);
+        bool middle = hRun >= vRun ? !horizontalEnd[cell] : !verticalEnd[cell];
+        if (longest > acc.longestRun || (longest == acc.longestRun && middle && acc.middleCell < 0))
+        {
+            acc.longestRun = longest;
+            acc.middleCell = middle ? cell : -1;
+            acc.anyCell = cell;
+            group.horizontal = hRun >= vRun;
+        }
+    }
+
+    // Форма и опорная клетка каждой группы: Line5 > T > L > Line4 > Line3
+    for (int index = 0; index < groupCount; ++index)
+    {
+        MatchGroup& group = groups[index];
+        const GroupAccumulator& acc = accumulators[index];
+
+        int pivot = acc.middleCell >= 0 ? acc.middleCell : acc.anyCell;
+        if (acc.longestRun >= 5)
+        {
+            group.shape = MatchShape::Line5;
+        }
+        else if (acc.crossCell >= 0)
+        {
+            group.shape = acc.crossIsCorner ? MatchShape::LShape : MatchShape::TShape;
+            pivot = acc.crossCell;
+        }
+        else
+        {
+            group.shape = acc.longestRun == 4 ? MatchShape::Line4 : MatchShape::Line3;
+        }
+
+        // Бонус от линии появляется там, куда игрок передвинул тайл
+        if (acc.swapCell >= 0 && acc.crossCell < 0)
+        {
+            pivot = acc.swapCell;
+        }
+        else if (acc.swapCell >= 0 && group.shape == MatchShape::Line5)
+        {
+            pivot = acc.swapCell;
+        }
+
+        group.pivotX = pivot % width;
+        group.pivotY = pivot / width;
+    }
+
+    return groupCount;
+}
+
+void MatchClassifier::markAndQueue(const std::vector<std::vector<int>>& tileMap, int x, int y, int& tail)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    int value = tileMap[y][x];
+    if (value == 0 || value == BLOCKED_TILE) return;
+
+    clearMask[y][x] = true;
+    int cell = y * width + x;
+    if (tileSpecial(value) != SpecialTile::None && !detonated[cell])
+    {
+        detonated[cell] = 1;
+        queue[tail++] = cell;
+    }
+}
+
+int MatchClassifier::mostCommonColor(const std::vector<std::vector<int>>& tileMap) const
+{
+    int counts[TILE_COLOR_MASK + 1] = {};
+    for (const auto& row : tileMap)
+        for (int value : row)
+            if (isMatchable(value)) counts[tileColor(value)]++;
+    return static_cast<int>(std::max_element(counts, counts + TILE_COLOR_MASK + 1) - counts);
+}
+
+int MatchClassifier::detonate(const std::vector<std::vector<int>>& tileMap, int colorBombTarget)
+{
+    const int cells = width * height;
+    std::fill(detonated.begin(), detonated.begin() + cells, 0);
+
+    // Очередь начинается с бонусов, уже попавших в маску
+    int head = 0, tail = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (clearMask[y][x] && tileSpecial(tileMap[y][x]) != SpecialTile::None)
+            {
+                detonated[y * width + x] = 1;
+                queue[tail++] = y * width + x;
+            }
+        }
+    }
+
+    // Каждая клетка встаёт в очередь не больше одного раза, поэтому
+    // даже длинные цепочки стоят O(клеток + площадь взрывов)
+    while (head < tail)
+    {
+        int cell = queue[head++];
+        int x = cell % width;
+        int y = cell / width;
+
+        switch (tileSpecial(tileMap[y][x]))
+        {
+        case SpecialTile::LineHorizontal:
+            for (int i = 0; i < width; ++i) markAndQueue(tileMap, i, y, tail);
+            break;
+        case SpecialTile::LineVertical:
+            for (int i = 0; i < height; ++i) markAndQueue(tileMap, x, i, tail);
+            break;
+        case SpecialTile::Bomb:
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    markAndQueue(tileMap, x + dx, y + dy, tail);
+            break;
+        case SpecialTile::ColorBomb:
+        {
+            int target = colorBombTarget != 0 ? colorBombTarget : mostCommonColor(tileMap);
+            for (int ty = 0; ty < height; ++ty)
+                for (int tx = 0; tx < width; ++tx)
+                    if (isMatchable(tileMap[ty][tx]) && tileColor(tileMap[ty][tx]) == target)
+                        markAndQueue(tileMap, tx, ty, tail);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    return tail;
+}
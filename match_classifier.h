@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "tile_value.h"
+
+enum class MatchShape
+{
+    Line3,
+    Line4,  // Даёт линейный бонус
+    Line5,  // Даёт цветную бомбу
+    LShape, // Даёт бомбу
+    TShape  // Даёт бомбу
+};
+
+struct MatchGroup
+{
+    MatchShape shape;
+    int color;
+    int size;   // Число клеток группы
+    int pivotX; // Клетка, где появится бонус
+    int pivotY;
+    bool horizontal; // Для Line4/Line5: вдоль строки
+};
+
+// Бонус, который даёт группа такой формы
+SpecialTile specialForShape(MatchShape shape, bool horizontal);
+
+// Классификатор совпадений: за один проход размечает серии длиной от трёх
+// по строкам и столбцам (run-length), склеивает пересекающиеся серии
+// через union-find и выдаёт для каждой связной группы форму, размер и
+// опорную клетку. Все буферы выделяются в конструкторе под размер доски,
+// classify() и detonate() памяти не выделяют.
+class MatchClassifier
+{
+public:
+    MatchClassifier(int width, int height);
+
+    // Размечает совпадения на доске. swapA/swapB — клетки последнего обмена
+    // (или -1), опорная клетка линии предпочитает их. Возвращает число групп.
+    int classify(const std::vector<std::vector<int>>& tileMap,
+        int swapAX = -1, int swapAY = -1, int swapBX = -1, int swapBY = -1);
+
+    int getGroupCount() const { return groupCount; }
+    const MatchGroup& getGroup(int index) const { return groups[index]; }
+
+    // Маска удаления после classify() и detonate()
+    const std::vector<std::vector<bool>>& getClearMask() const { return clearMask; }
+    void keepCell(int x, int y) { clearMask[y][x] = false; }
+
+    // Цепная детонация: каждый бонус в маске удаления срабатывает ровно
+    // один раз и добавляет свою область в маску, задетые бонусы встают в
+    // очередь. colorBombTarget — цвет для цветной бомбы, 0 — самый частый.
+    // Возвращает число сработавших бонусов.
+    int detonate(const std::vector<std::vector<int>>& tileMap, int colorBombTarget = 0);
+
+    // Отметить клетку для удаления вручную (например, цветная бомба при обмене)
+    void markCell(int x, int y) { clearMask[y][x] = true; }
+    void clearAll();
+
+private:
+    // Промежуточные данные группы во время прохода
+    struct GroupAccumulator
+    {
+        int longestRun = 0;
+        int middleCell = -1;  // Середина самой длинной серии
+        int anyCell = -1;     // Любая клетка самой длинной серии
+        int crossCell = -1;   // Пересечение строки и столбца
+        bool crossIsCorner = false;
+        int swapCell = -1;    // Клетка обмена внутри группы
+    };
+
+    int find(int cell);
+    void unite(int a, int b);
+    void markAndQueue(const std::vector<std::vector<int>>& tileMap, int x, int y, int& tail);
+    int mostCommonColor(const std::vector<std::vector<int>>& tileMap) const;
+
+    int width;
+    int height;
+
+    std::vector<int> parent;
+    std::vector<std::uint8_t> horizontalRun; // Длина серии по строке через клетку (0 — нет)
+    std::vector<std::uint8_t> verticalRun;
+    std::vector<std::uint8_t> horizontalEnd; // Клетка — край своей серии по строке
+    std::vector<std::uint8_t> verticalEnd;
+    std::vector<int> groupOfRoot;
+    std::vector<MatchGroup> groups;
+    std::vector<GroupAccumulator> accumulators;
+    int groupCount = 0;
+
+    std::vector<std::vector<bool>> clearMask;
+    std::vector<std::uint8_t> detonated;
+    std::vector<int> queue;
+};
@@ -0,0 +1,207 @@
+#include "particle_system.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const float GRAVITY = 900.0f;  // Пикселей в секунду за секунду
+    const float DRAG = 1.5f;       // Затухание скорости, 1/с
+    const unsigned SPOT_SIZE = 32; // Размер текстуры пятна
+    const float PI = 3.14159265f;
+}
+
+ParticleSystem::ParticleSystem(std::size_t capacity) :
+    capacity(capacity),
+    positionX(capacity, 0.0f),
+    positionY(capacity, 0.0f),
+    velocityX(capacity, 0.0f),
+    velocityY(capacity, 0.0f),
+    life(capacity, 0.0f),
+    invLifetime(capacity, 0.0f),
+    size(capacity, 0.0f),
+    color(capacity),
+    alive(capacity, 0),
+    freeSlots(capacity),
+    freeCount(capacity),
+    vertices(capacity * 4)
+{
+    // Младшие индексы на вершине стека, чтобы живые частицы держались плотно
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        freeSlots[i] = static_cast<std::uint32_t>(capacity - 1 - i);
+    }
+
+    // Круглое пятно с мягким краем
+    sf::Image spot;
+    spot.create(SPOT_SIZE, SPOT_SIZE, sf::Color::Transparent);
+    const float radius = SPOT_SIZE / 2.0f;
+    for (unsigned y = 0; y < SPOT_SIZE; ++y)
+    {
+        for (unsigned x = 0; x < SPOT_SIZE; ++x)
+        {
+            float dx = (x + 0.5f - radius) / radius;
+            float dy = (y + 0.5f - radius) / radius;
+            float falloff = std::max(0.0f, 1.0f - std::sqrt(dx * dx + dy * dy));
+            spot.setPixel(x, y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(255.0f * falloff * falloff)));
+        }
+    }
+    spriteTexture.loadFromImage(spot);
+    spriteTexture.setSmooth(true);
+
+    // Текстурные координаты одинаковы для всех частиц и не меняются
+    for (std::size_t i = 0; i < capacity; ++i)
+    {
+        vertices[i * 4 + 0].texCoords = sf::Vector2f(0, 0);
+        vertices[i * 4 + 1].texCoords = sf::Vector2f(SPOT_SIZE, 0);
+        vertices[i * 4 + 2].texCoords = sf::Vector2f(SPOT_SIZE, SPOT_SIZE);
+        vertices[i * 4 + 3].texCoords = sf::Vector2f(0, SPOT_SIZE);
+    }
+}
+
+float ParticleSystem::random(float from, float to)
+{
+    // xorshift32: быстрый и без состояния в куче
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return from + (to - from) * (rngState >> 8) * (1.0f / 16777216.0f);
+}
+
+int ParticleSystem::spawn(float x, float y, float vx, float vy, float lifetime, float particleSize, sf::Color particleColor)
+{
+    if (freeCount == 0)
+    {
+        return -1;
+    }
+
+    std::uint32_t slot = freeSlots[--freeCount];
+    positionX[slot] = x;
+    positionY[slot] = y;
+    velocityX[slot] = vx;
+    velocityY[slot] = vy;
+    life[slot] = lifetime;
+    invLifetime[slot] = 1.0f / lifetime;
+    size[slot] = particleSize;
+    color[slot] = particleColor;
+    alive[slot] = 1;
+
+    ++aliveCount;
+    if (slot + 1 > highWater)
+    {
+        highWater = slot + 1;
+    }
+    return static_cast<int>(slot);
+}
+
+void ParticleSystem::spawnBurst(sf::Vector2f center, sf::Color burstColor, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float angle = random(0.0f, 2.0f * PI);
+        float speed = random(120.0f, 380.0f);
+        spawn(center.x, center.y, std::cos(angle) * speed, std::sin(angle) * speed - 200.0f,
+            random(0.4f, 0.8f), random(6.0f, 12.0f), burstColor);
+    }
+}
+
+void ParticleSystem::spawnSparkles(sf::Vector2f center, sf::Color sparkleColor, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        spawn(center.x + random(-30.0f, 30.0f), center.y + random(-30.0f, 30.0f),
+            random(-20.0f, 20.0f), random(-120.0f, -40.0f),
+            random(0.6f, 1.2f), random(3.0f, 6.0f), sparkleColor);
+    }
+}
+
+void ParticleSystem::spawnCombo(sf::Vector2f center, int comboDepth)
+{
+    int count = 24 * comboDepth;
+    float speed = 250.0f + 60.0f * comboDepth;
+    sf::Color ringColor(255, 220, 90);
+    for (int i = 0; i < count; ++i)
+    {
+        float angle = 2.0f * PI * i / count;
+        spawn(center.x, center.y, std::cos(angle) * speed, std::sin(angle) * speed,
+            random(0.7f, 1.0f), random(8.0f, 14.0f), ringColor);
+    }
+}
+
+void ParticleSystem::update(float deltaTime)
+{
+    const int count = static_cast<int>(highWater);
+    const float damping = std::max(0.0f, 1.0f - DRAG * deltaTime);
+
+    // Интеграция без ветвлений по плотным массивам: мёртвые слоты тоже
+    // обсчитываются, зато цикл векторизуется целиком
+    float* __restrict px = positionX.data();
+    float* __restrict py = positionY.data();
+    float* __restrict vx = velocityX.data();
+    float* __restrict vy = velocityY.data();
+    float* __restrict lf = life.data();
+    for (int i = 0; i < count; ++i)
+    {
+        vx[i] *= damping;
+        vy[i] = vy[i] * damping + GRAVITY * deltaTime;
+        px[i] += vx[i] * deltaTime;
+        py[i] += vy[i] * deltaTime;
+        lf[i] -= deltaTime;
+    }
+
+    // Отдельный проход возвращает умершие слоты в стек
+    for (int i = 0; i < count; ++i)
+    {
+        if (alive[i] && lf[i] <= 0.0f)
+        {
+            alive[i] = 0;
+            freeSlots[freeCount++] = static_cast<std::uint32_t>(i);
+            --aliveCount;
+        }
+    }
+
+    if (aliveCount == 0)
+    {
+        // Пул пуст: сбрасываем стек в исходный порядок, чтобы следующие
+        // частицы снова легли в начало массивов
+        highWater = 0;
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            freeSlots[i] = static_cast<std::uint32_t>(capacity - 1 - i);
+        }
+        freeCount = capacity;
+    }
+
+    // Геометрия: мёртвые слоты становятся вырожденными прозрачными квадратами
+    sf::Vertex* out = vertices.data();
+    const float* sz = size.data();
+    const float* inv = invLifetime.data();
+    for (int i = 0; i < count; ++i)
+    {
+        float t = std::max(0.0f, lf[i] * inv[i]);
+        float half = sz[i] * 0.5f * (0.5f + 0.5f * t) * (alive[i] ? 1.0f : 0.0f);
+        sf::Color c = color[i];
+        c.a = static_cast<sf::Uint8>(c.a * t);
+
+        out[i * 4 + 0].position = sf::Vector2f(px[i] - half, py[i] - half);
+        out[i * 4 + 1].position = sf::Vector2f(px[i] + half, py[i] - half);
+        out[i * 4 + 2].position = sf::Vector2f(px[i] + half, py[i] + half);
+        out[i * 4 + 3].position = sf::Vector2f(px[i] - half, py[i] + half);
+        out[i * 4 + 0].color = c;
+        out[i * 4 + 1].color = c;
+        out[i * 4 + 2].color = c;
+        out[i * 4 + 3].color = c;
+    }
+}
+
+void ParticleSystem::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (highWater == 0)
+    {
+        return;
+    }
+
+    states.texture = &spriteTexture;
+    states.blendMode = sf::BlendAdd;
+    target.draw(vertices.data(), highWater * 4, sf::Quads, states);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+// Система частиц с фиксированным пулом. Данные лежат структурой массивов,
+// чтобы шаг обновления был простым циклом по float-массивам, который
+// компилятор векторизует. Свободные слоты хранятся стеком индексов:
+// рождение и смерть частицы — push/pop без обращений к куче. Все живые
+// частицы рисуются одним вызовом draw.
+class ParticleSystem : public sf::Drawable
+{
+public:
+    explicit ParticleSystem(std::size_t capacity);
+
+    // Разлёт осколков при удалении тайла
+    void spawnBurst(sf::Vector2f center, sf::Color color, int count);
+    // Медленные искры, которые гаснут на месте
+    void spawnSparkles(sf::Vector2f center, sf::Color color, int count);
+    // Кольцо искр для каскада: чем глубже комбо, тем больше и ярче
+    void spawnCombo(sf::Vector2f center, int comboDepth);
+
+    void update(float deltaTime);
+
+    std::size_t getAliveCount() const { return aliveCount; }
+    std::size_t getCapacity() const { return capacity; }
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    // -1, если пул исчерпан: новая частица просто не рождается
+    int spawn(float x, float y, float vx, float vy, float lifetime, float size, sf::Color color);
+    float random(float from, float to);
+
+    std::size_t capacity;
+    std::size_t aliveCount = 0;
+    std::size_t highWater = 0; // Все живые частицы лежат в [0, highWater)
+
+    // Структура массивов, по одному элементу на слот
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> life;        // Оставшееся время жизни, <= 0 — мёртвая
+    std::vector<float> invLifetime; // 1 / полное время жизни для альфы
+    std::vector<float> size;
+    std::vector<sf::Color> color;
+    std::vector<std::uint8_t> alive;
+
+    std::vector<std::uint32_t> freeSlots; // Стек свободных индексов
+    std::size_t freeCount = 0;
+
+    std::vector<sf::Vertex> vertices; // 4 вершины на слот, выделены заранее
+    sf::Texture spriteTexture;        // Мягкое пятно для всех частиц
+
+    std::uint32_t rngState = 0x9E3779B9u;
+};
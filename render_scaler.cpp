@@ -0,0 +1,284 @@
+#include "render_scaler.h"
+
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace
+{
+    const float FRAME_BUDGET = 1.0f / 60.0f;
+    const float SCENE_SHARE = 0.7f;        // Доля кадра на проход сцены; остальное — увеличение и запас
+    const float FRAME_TOLERANCE = 1.15f;   // Дрожание кадра при вертикальной синхронизации — не перегрузка
+    const float RAISE_BELOW = 0.6f;        // Поднимать долю, если уложились в эту часть бюджета
+    const float ADJUST_SECONDS = 0.5f;     // Как часто меняется доля
+    const float RAISE_STEP = 0.05f;
+    const float SMOOTHING = 0.1f;          // Вес нового замера в сглаженном времени
+    const float SHARPNESS = 0.6f;          // Резкость при увеличении вдвое
+
+    const char* const UPSCALE_SHADER = R"(
+#version 120
+uniform sampler2D u_scene;
+uniform vec2 u_texel;
+uniform float u_sharpness;
+
+void main()
+{
+    vec2 uv = gl_TexCoord[0].xy;
+    vec3 center = texture2D(u_scene, uv).rgb;
+    vec3 left = texture2D(u_scene, uv - vec2(u_texel.x, 0.0)).rgb;
+    vec3 right = texture2D(u_scene, uv + vec2(u_texel.x, 0.0)).rgb;
+    vec3 up = texture2D(u_scene, uv - vec2(0.0, u_texel.y)).rgb;
+    vec3 down = texture2D(u_scene, uv + vec2(0.0, u_texel.y)).rgb;
+
+    // Нерезкая маска, зажатая в пределы соседей: края становятся чётче,
+    // но без светлых и тёмных ореолов
+    vec3 sharpened = center + (4.0 * center - left - right - up - down) * u_sharpness * 0.25;
+    vec3 low = min(center, min(min(left, right), min(up, down)));
+    vec3 high = max(center, max(max(left, right), max(up, down)));
+    gl_FragColor = vec4(clamp(sharpened, low, high), 1.0) * gl_Color;
+}
+)";
+
+    // GL_ARB_timer_query; функции берутся у контекста SFML, отдельный загрузчик не нужен
+    const GLenum TIME_ELAPSED = 0x88BF;
+    const GLenum QUERY_RESULT = 0x8866;
+    const GLenum QUERY_RESULT_AVAILABLE = 0x8867;
+
+    typedef void (APIENTRY* GenQueriesFunction)(GLsizei, GLuint*);
+    typedef void (APIENTRY* DeleteQueriesFunction)(GLsizei, const GLuint*);
+    typedef void (APIENTRY* BeginQueryFunction)(GLenum, GLuint);
+    typedef void (APIENTRY* EndQueryFunction)(GLenum);
+    typedef void (APIENTRY* GetQueryObjectivFunction)(GLuint, GLenum, GLint*);
+    typedef void (APIENTRY* GetQueryObjectui64vFunction)(GLuint, GLenum, std::uint64_t*);
+}
+
+// Время GPU на проход сцены. Результат запроса читается через несколько
+// кадров, когда он уже готов, поэтому замер не останавливает конвейер.
+class ResolutionScaler::GpuTimer
+{
+public:
+    static const int QUERY_COUNT = 4;
+
+    ~GpuTimer()
+    {
+        if (loaded) deleteQueries(QUERY_COUNT, queries);
+    }
+
+    // Вызывать с активным контекстом внутренней текстуры
+    bool load()
+    {
+        if (!sf::Context::isExtensionAvailable("GL_ARB_timer_query")) return false;
+        genQueries = reinterpret_cast<GenQueriesFunction>(sf::Context::getFunction("glGenQueries"));
+        deleteQueries = reinterpret_cast<DeleteQueriesFunction>(sf::Context::getFunction("glDeleteQueries"));
+        beginQuery = reinterpret_cast<BeginQueryFunction>(sf::Context::getFunction("glBeginQuery"));
+        endQuery = reinterpret_cast<EndQueryFunction>(sf::Context::getFunction("glEndQuery"));
+        getQueryObjectiv = reinterpret_cast<GetQueryObjectivFunction>(sf::Context::getFunction("glGetQueryObjectiv"));
+        getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vFunction>(sf::Context::getFunction("glGetQueryObjectui64v"));
+        if (!genQueries || !deleteQueries || !beginQuery || !endQuery || !getQueryObjectiv || !getQueryObjectui64v)
+        {
+            return false;
+        }
+        genQueries(QUERY_COUNT, queries);
+        loaded = true;
+        return true;
+    }
+
+    bool isLoaded() const { return loaded; }
+
+    void begin()
+    {
+        // Все запросы ещё в полёте — этот кадр не замеряется
+        active = loaded && !pending[next];
+        if (active) beginQuery(TIME_ELAPSED, queries[next]);
+    }
+
+    void end()
+    {
+        if (!active) return;
+        endQuery(TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % QUERY_COUNT;
+        active = false;
+    }
+
+    // Самый свежий из готовых замеров. false — готовых нет.
+    bool poll(float& seconds)
+    {
+        bool found = false;
+        while (pending[oldest])
+        {
+            GLint available = 0;
+            getQueryObjectiv(queries[oldest], QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+
+            std::uint64_t nanoseconds = 0;
+            getQueryObjectui64v(queries[oldest], QUERY_RESULT, &nanoseconds);
+            seconds = static_cast<float>(nanoseconds * 1e-9);
+            found = true;
+            pending[oldest] = false;
+            oldest = (oldest + 1) % QUERY_COUNT;
+        }
+        return found;
+    }
+
+private:
+    GenQueriesFunction genQueries = nullptr;
+    DeleteQueriesFunction deleteQueries = nullptr;
+    BeginQueryFunction beginQuery = nullptr;
+    EndQueryFunction endQuery = nullptr;
+    GetQueryObjectivFunction getQueryObjectiv = nullptr;
+    GetQueryObjectui64vFunction getQueryObjectui64v = nullptr;
+
+    GLuint queries[QUERY_COUNT] = {};
+    bool pending[QUERY_COUNT] = {};
+    int next = 0;
+    int oldest = 0;
+    bool active = false;
+    bool loaded = false;
+};
+
+ResolutionScaler::ResolutionScaler(sf::Vector2f sceneSize) :
+    sceneSize(sceneSize),
+    sceneView(sf::FloatRect(0.0f, 0.0f, sceneSize.x, sceneSize.y)),
+    windowView(sceneView),
+    gpuTimer(new GpuTimer())
+{
+    if (sf::Shader::isAvailable())
+    {
+        upscaleShaderLoaded = upscaleShader.loadFromMemory(UPSCALE_SHADER, sf::Shader::Fragment);
+        if (!upscaleShaderLoaded)
+        {
+            std::cerr << "Failed to compile upscale shader, upscaling bilinearly" << std::endl;
+        }
+    }
+}
+
+ResolutionScaler::~ResolutionScaler()
+{
+    // Запросы удаляются в том же контексте, где созданы
+    if (gpuTimer->isLoaded()) sceneTexture.setActive(true);
+    gpuTimer.reset();
+}
+
+bool ResolutionScaler::resize(sf::Vector2u windowSize)
+{
+    // Вписываем сцену с сохранением пропорций, поля — по короткой стороне
+    float fit = std::min(windowSize.x / sceneSize.x, windowSize.y / sceneSize.y);
+    sf::Vector2f fitted(sceneSize.x * fit, sceneSize.y * fit);
+    windowView.setViewport(sf::FloatRect(
+        (1.0f - fitted.x / windowSize.x) * 0.5f, (1.0f - fitted.y / windowSize.y) * 0.5f,
+        fitted.x / windowSize.x, fitted.y / windowSize.y));
+
+    sf::Vector2u size(std::max(1u, static_cast<unsigned>(fitted.x)), std::max(1u, static_cast<unsigned>(fitted.y)));
+    if (size != textureSize)
+    {
+        bool firstTexture = textureSize == sf::Vector2u();
+        if (!sceneTexture.create(size.x, size.y))
+        {
+            std::cerr << "Failed to create a " << size.x << "x" << size.y << " scene texture" << std::endl;
+            return false;
+        }
+        sceneTexture.setSmooth(true);
+        textureSize = size;
+
+        if (firstTexture && sceneTexture.setActive(true) && !gpuTimer->load())
+        {
+            std::cerr << "GPU timer queries are unavailable, scaling resolution by frame time" << std::endl;
+        }
+    }
+    updateSceneView();
+    return true;
+}
+
+void ResolutionScaler::setFixedScale(float newScale)
+{
+    fixedScale = newScale > 0.0f ? std::min(std::max(newScale, MIN_SCALE), MAX_SCALE) : 0.0f;
+    if (fixedScale > 0.0f) scale = fixedScale;
+    updateSceneView();
+}
+
+bool ResolutionScaler::hasGpuTimer() const
+{
+    return gpuTimer->isLoaded();
+}
+
+sf::RenderTarget& ResolutionScaler::beginFrame()
+{
+    sceneTexture.setActive(true);
+    gpuTimer->begin();
+    sceneTexture.setView(sceneView);
+    sceneTexture.clear();
+    return sceneTexture;
+}
+
+void ResolutionScaler::present(sf::RenderWindow& window, float frameSeconds)
+{
+    sceneTexture.setActive(true);
+    gpuTimer->end();
+    sceneTexture.display();
+
+    // Кадр занимает левый верхний угол текстуры; растягиваем его на всю сцену
+    sf::Sprite frame(sceneTexture.getTexture(), sf::IntRect(0, 0, renderSize.x, renderSize.y));
+    frame.setScale(sceneSize.x / renderSize.x, sceneSize.y / renderSize.y);
+
+    window.setView(windowView);
+    if (upscaleShaderLoaded && scale < MAX_SCALE)
+    {
+        upscaleShader.setUniform("u_scene", sf::Shader::CurrentTexture);
+        upscaleShader.setUniform("u_texel", sf::Glsl::Vec2(1.0f / textureSize.x, 1.0f / textureSize.y));
+        upscaleShader.setUniform("u_sharpness", std::min(1.0f, SHARPNESS * (1.0f / scale - 1.0f)));
+        window.draw(frame, &upscaleShader);
+    }
+    else
+    {
+        window.draw(frame);
+    }
+
+    adjustScale(frameSeconds);
+}
+
+void ResolutionScaler::updateSceneView()
+{
+    renderSize.x = std::max(1u, static_cast<unsigned>(std::lround(textureSize.x * scale)));
+    renderSize.y = std::max(1u, static_cast<unsigned>(std::lround(textureSize.y * scale)));
+    if (textureSize.x == 0 || textureSize.y == 0) return;
+    sceneView.setViewport(sf::FloatRect(0.0f, 0.0f,
+        static_cast<float>(renderSize.x) / textureSize.x, static_cast<float>(renderSize.y) / textureSize.y));
+}
+
+void ResolutionScaler::adjustScale(float frameSeconds)
+{
+    // Без таймеров GPU меряем весь кадр: он упирается в GPU, если тот не успевает
+    float measured = frameSeconds;
+    float budget = FRAME_BUDGET * FRAME_TOLERANCE;
+    if (gpuTimer->isLoaded())
+    {
+        budget = FRAME_BUDGET * SCENE_SHARE;
+        if (!gpuTimer->poll(measured)) measured = smoothedSeconds;
+    }
+    smoothedSeconds = smoothedSeconds > 0.0f ? smoothedSeconds + (measured - smoothedSeconds) * SMOOTHING : measured;
+
+    sinceAdjust += frameSeconds;
+    if (fixedScale > 0.0f || sinceAdjust < ADJUST_SECONDS) return;
+    sinceAdjust = 0.0f;
+
+    float previous = scale;
+    if (smoothedSeconds > budget)
+    {
+        // Время прохода растёт с числом пикселей, то есть с квадратом доли
+        float step = std::min(std::max(std::sqrt(budget / smoothedSeconds), 0.75f), 0.95f);
+        scale = std::max(MIN_SCALE, scale * step);
+    }
+    else if (smoothedSeconds < budget * RAISE_BELOW)
+    {
+        scale = std::min(MAX_SCALE, scale + RAISE_STEP);
+    }
+
+    if (scale != previous) updateSceneView();
+}
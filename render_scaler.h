@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+// Отрисовка с независимой от окна раскладкой и динамическим разрешением.
+// Сцена всегда раскладывается в своих единицах (sceneSize), окно может
+// быть любого размера: сцена вписывается в него с полями по краям через
+// sf::View, поэтому mapPixelToCoords у окна отдаёт координаты сцены.
+//
+// Кадр рисуется во внутреннюю текстуру размером с вписанную область окна,
+// но только в её часть: доля scale по каждой стороне. Доля подстраивается
+// под измеренное время GPU на проход сцены (таймеры GL_ARB_timer_query,
+// без них — по времени кадра), поэтому слабая встроенная графика на 4K
+// держит частоту кадров ценой чёткости. Увеличение до окна идёт через
+// шейдер с ограниченной резкостью, без шейдера — билинейно.
+class ResolutionScaler
+{
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+
+    explicit ResolutionScaler(sf::Vector2f sceneSize);
+    ~ResolutionScaler();
+
+    ResolutionScaler(const ResolutionScaler&) = delete;
+    ResolutionScaler& operator=(const ResolutionScaler&) = delete;
+
+    // Под новый размер окна в пикселях. false — не создалась внутренняя текстура.
+    bool resize(sf::Vector2u windowSize);
+
+    // scale > 0 — постоянная доля разрешения, 0 — подстройка по времени кадра
+    void setFixedScale(float scale);
+
+    // Цель для кадра сцены, уже очищенная и с видом сцены
+    sf::RenderTarget& beginFrame();
+    // Завершает кадр, переносит его в окно и подстраивает долю.
+    // frameSeconds — полное время прошлого кадра, запасной замер без таймеров GPU.
+    void present(sf::RenderWindow& window, float frameSeconds);
+
+    // Вид окна: сцена с полями. Нужен обработке ввода до первого present.
+    const sf::View& getWindowView() const { return windowView; }
+    float getScale() const { return scale; }
+    bool hasGpuTimer() const;
+
+private:
+    class GpuTimer;
+
+    void updateSceneView();
+    void adjustScale(float frameSeconds);
+
+    sf::Vector2f sceneSize;
+    sf::RenderTexture sceneTexture;
+    sf::Vector2u textureSize;
+    sf::View sceneView;
+    sf::View windowView;
+    sf::Vector2u renderSize; // Занятая часть текстуры, пиксели
+
+    sf::Shader upscaleShader;
+    bool upscaleShaderLoaded = false;
+
+    std::unique_ptr<GpuTimer> gpuTimer;
+    float fixedScale = 0.0f;
+    float scale = MAX_SCALE;
+    float smoothedSeconds = 0.0f; // Сглаженное время прохода сцены (или кадра)
+    float sinceAdjust = 0.0f;
+};
@@ -0,0 +1,87 @@
+#include "replay.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    const char* const REPLAY_HEADER = "bigwash-replay";
+    const int REPLAY_VERSION = 2; // 2: каскад по расписанию, другое время анимаций
+}
+
+bool loadReplay(const std::string& path, Replay& replay)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open replay " << path << std::endl;
+        return false;
+    }
+
+    std::string header, seedKey;
+    int version = 0;
+    if (!(file >> header >> version >> seedKey >> replay.seed) ||
+        header != REPLAY_HEADER || version != REPLAY_VERSION || seedKey != "seed")
+    {
+        std::cerr << "Replay " << path << " has an unknown format" << std::endl;
+        return false;
+    }
+
+    replay.endless = false;
+    if ((file >> std::ws).peek() == 'm')
+    {
+        std::string modeKey, mode;
+        if (!(file >> modeKey >> mode) || modeKey != "mode" || (mode != "endless" && mode != "classic"))
+        {
+            std::cerr << "Replay " << path << " has an unknown mode" << std::endl;
+            return false;
+        }
+        replay.endless = mode == "endless";
+    }
+
+    replay.events.clear();
+    ReplayEvent event;
+    int type = 0;
+    while (file >> event.step >> type >> event.input.x >> event.input.y >> event.input.targetX >> event.input.targetY)
+    {
+        if (type < 0 || type > static_cast<int>(InputEvent::Type::Restart) ||
+            (!replay.events.empty() && event.step < replay.events.back().step))
+        {
+            std::cerr << "Replay " << path << " is corrupted near step " << event.step << std::endl;
+            return false;
+        }
+        event.input.type = static_cast<InputEvent::Type>(type);
+        replay.events.push_back(event);
+    }
+
+    if (!file.eof())
+    {
+        std::cerr << "Replay " << path << " is corrupted after " << replay.events.size() << " events" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool saveReplay(const std::string& path, const Replay& replay)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to write replay " << path << std::endl;
+        return false;
+    }
+
+    file << REPLAY_HEADER << ' ' << REPLAY_VERSION << '\n';
+    file << "seed " << replay.seed << '\n';
+    if (replay.endless)
+    {
+        file << "mode endless\n";
+    }
+    for (const ReplayEvent& event : replay.events)
+    {
+        const InputEvent& input = event.input;
+        file << event.step << ' ' << static_cast<int>(input.type) << ' '
+            << input.x << ' ' << input.y << ' ' << input.targetX << ' ' << input.targetY << '\n';
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board_input.h"
+
+// Намерение игрока, привязанное к шагу симуляции, на котором оно применено
+struct ReplayEvent
+{
+    std::uint64_t step;
+    InputEvent input;
+};
+
+// Запись партии: зерно генератора и все намерения по шагам. Вместе с
+// фиксированным шагом симуляции этого хватает, чтобы повторить партию
+// кадр в кадр.
+struct Replay
+{
+    std::uint32_t seed = 0;
+    bool endless = false;
+    std::vector<ReplayEvent> events;
+};
+
+// Текстовый формат: строка "bigwash-replay 1", строка "seed N",
+// необязательная строка "mode endless", дальше по событию на строку:
+// "шаг тип x y targetX targetY".
+bool loadReplay(const std::string& path, Replay& replay);
+bool saveReplay(const std::string& path, const Replay& replay);
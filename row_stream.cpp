@@ -0,0 +1,156 @@
+#include "row_stream.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Сколько раз перегенерировать ряд без хода в полосе. Если не вышло,
+    // ряд остаётся без готовых совпадений, а ход найдёт перемешивание подсказки.
+    const int MAX_ROW_ATTEMPTS = 64;
+    const int BAND_ROWS = 3;
+}
+
+RowStream::RowStream(int width, int capacity) :
+    width(width),
+    capacity(capacity),
+    ring(static_cast<std::size_t>(width) * capacity, 0),
+    band(static_cast<std::size_t>(width) * BAND_ROWS, 0),
+    scratch(band.size(), 0),
+    thread(&RowStream::run, this)
+{
+}
+
+RowStream::~RowStream()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorker.notify_one();
+    thread.join();
+}
+
+void RowStream::reset(std::uint64_t seed, int tileTypeCount)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = 0;
+        count = 0;
+        random.seed(seed);
+        tileTypes = tileTypeCount;
+        std::fill(band.begin(), band.end(), 0);
+    }
+    wakeWorker.notify_one();
+}
+
+void RowStream::takeRow(int* row)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    rowReady.wait(lock, [this] { return count > 0; });
+
+    const int* slot = &ring[static_cast<std::size_t>(head) * width];
+    std::copy(slot, slot + width, row);
+    head = (head + 1) % capacity;
+    count--;
+    lock.unlock();
+
+    wakeWorker.notify_one(); // Слот свободен под следующий ряд
+}
+
+void RowStream::run()
+{
+    std::vector<int> row(width);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeWorker.wait(lock, [this] { return stopping || (tileTypes > 0 && count < capacity); });
+        if (stopping) return;
+
+        // Генератор и полоса меняются только здесь и в reset() под тем же
+        // mutex, поэтому порядок рядов не зависит от расписания потоков
+        generateRow(row.data());
+
+        int tail = (head + count) % capacity;
+        std::copy(row.begin(), row.end(), ring.begin() + static_cast<std::size_t>(tail) * width);
+        count++;
+        rowReady.notify_one();
+    }
+}
+
+// Вызывается под mutex: ряд на 7–10 клеток считается за микросекунды
+void RowStream::generateRow(int* row)
+{
+    int* previous = &band[0];     // Ряд двумя выше
+    int* last = &band[width];     // Ряд прямо над новым
+    int* candidate = &band[2 * width];
+
+    for (int attempt = 0; attempt < MAX_ROW_ATTEMPTS; ++attempt)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            // Цвет, не собирающий тройку ни по горизонтали, ни по вертикали.
+            // Запрещено не больше двух цветов, при трёх и больше выбор есть.
+            int color = random.nextInt(1, tileTypes);
+            for (int tries = 0; tries < tileTypes; ++tries)
+            {
+                bool horizontal = x >= 2 && candidate[x - 1] == color && candidate[x - 2] == color;
+                bool vertical = previous[x] == color && last[x] == color;
+                if (!horizontal && !vertical) break;
+                color = color % tileTypes + 1;
+            }
+            candidate[x] = color;
+        }
+        if (hasMoveInBand(band.data())) break;
+    }
+
+    std::copy(candidate, candidate + width, row);
+
+    // Полоса сдвигается на ряд: новый становится последним
+    std::copy(last, last + width, previous);
+    std::copy(candidate, candidate + width, last);
+}
+
+// Есть ли обмен соседей, после которого в полосе из трёх рядов появится тройка
+bool RowStream::hasMoveInBand(const int* source)
+{
+    std::copy(source, source + BAND_ROWS * width, scratch.begin());
+    int* board = scratch.data();
+
+    for (int y = 0; y < BAND_ROWS; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            int& cell = board[y * width + x];
+            if (cell == 0) continue; // Первые ряды после reset() пустые
+
+            int* neighbours[2] = {
+                x + 1 < width ? &board[y * width + x + 1] : nullptr,
+                y + 1 < BAND_ROWS ? &board[(y + 1) * width + x] : nullptr
+            };
+            for (int* other : neighbours)
+            {
+                if (!other || *other == 0 || *other == cell) continue;
+                std::swap(cell, *other);
+                bool found = hasLineInBand(board);
+                std::swap(cell, *other);
+                if (found) return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RowStream::hasLineInBand(const int* board) const
+{
+    for (int y = 0; y < BAND_ROWS; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            int color = board[y * width + x];
+            if (color == 0) continue;
+            if (x + 2 < width && board[y * width + x + 1] == color && board[y * width + x + 2] == color) return true;
+            if (y + 2 < BAND_ROWS && board[(y + 1) * width + x] == color && board[(y + 2) * width + x] == color) return true;
+        }
+    }
+    return false;
+}
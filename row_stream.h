@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game_random.h"
+
+// Поток рядов для бесконечного режима. Рабочий поток заранее заполняет
+// кольцевой буфер из capacity рядов; симуляция забирает по ряду, когда
+// доска сдвигается вверх, и освободившийся слот сразу идёт под следующий
+// ряд. Память и работа на ряд постоянны, сколько бы ни длилась партия.
+//
+// Каждый ряд проверяется вместе с двумя предыдущими: готовых совпадений
+// нет, и в полосе из трёх рядов есть хотя бы один ход. Последовательность
+// рядов зависит только от зерна, а не от скорости рабочего потока.
+class RowStream
+{
+public:
+    RowStream(int width, int capacity);
+    ~RowStream();
+
+    RowStream(const RowStream&) = delete;
+    RowStream& operator=(const RowStream&) = delete;
+
+    // Начать новую последовательность; буфер сбрасывается
+    void reset(std::uint64_t seed, int tileTypeCount);
+
+    // Копирует следующий ряд в row (width значений). Ждёт только если
+    // рабочий поток отстал на весь буфер.
+    void takeRow(int* row);
+
+    int getWidth() const { return width; }
+
+private:
+    void run();
+    void generateRow(int* row);
+    bool hasMoveInBand(const int* band);
+    bool hasLineInBand(const int* band) const;
+
+    int width;
+    int capacity;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable rowReady;
+    std::vector<int> ring;        // capacity рядов подряд, под mutex
+    int head = 0;                 // Первый готовый ряд, под mutex
+    int count = 0;                // Сколько рядов готово, под mutex
+    bool stopping = false;        // Под mutex
+
+    // Принадлежат рабочему потоку; задаются в reset() под mutex
+    GameRandom random;
+    int tileTypes = 0;
+    std::vector<int> band;        // Два предыдущих ряда и новый, для проверок
+    std::vector<int> scratch;     // Копия полосы для пробных обменов
+
+    std::thread thread;
+};
@@ -0,0 +1,397 @@
+#include "save_game.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const std::uint8_t SAVE_MAGIC[4] = { 'B', 'W', 'S', 'V' };
+    const std::size_t CHECKSUM_SIZE = 4;
+
+    std::uint32_t fnv1a(const std::uint8_t* data, std::size_t size)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Числа пишутся в little-endian независимо от платформы
+    void writeInt(std::vector<std::uint8_t>& bytes, std::uint64_t value, int size)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    // Счётчики обычно малы: 7 бит на байт, старший бит — продолжение
+    void writeVarint(std::vector<std::uint8_t>& bytes, std::uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    class Reader
+    {
+    public:
+        Reader(const std::uint8_t* data, std::size_t size) : data(data), size(size) {}
+
+        std::uint64_t read(int bytes)
+        {
+            if (position + bytes > size)
+            {
+                failed = true;
+                return 0;
+            }
+            std::uint64_t value = 0;
+            for (int i = 0; i < bytes; ++i)
+            {
+                value |= static_cast<std::uint64_t>(data[position++]) << (8 * i);
+            }
+            return value;
+        }
+
+        std::uint32_t readVarint()
+        {
+            std::uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7)
+            {
+                std::uint64_t byte = read(1);
+                value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80) || failed) return value;
+            }
+            failed = true;
+            return 0;
+        }
+
+        bool ok() const { return !failed; }
+        std::size_t getPosition() const { return position; }
+
+    private:
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t position = 0;
+        bool failed = false;
+    };
+
+    // Файл пишется в обход буферов потоков и сбрасывается на диск до
+    // переименования: иначе после сбоя питания новое имя может указывать
+    // на пустой или недописанный файл.
+#if defined(_WIN32)
+    bool writeSynced(const std::string& path, const std::vector<std::uint8_t>& bytes)
+    {
+        int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd == -1) return false;
+
+        bool ok = _write(fd, bytes.data(), static_cast<unsigned>(bytes.size())) == static_cast<int>(bytes.size());
+        ok = ok && _commit(fd) == 0;
+        return _close(fd) == 0 && ok;
+    }
+
+    // Каталог на Windows не сбрасывается: запись переименования на диск
+    // гарантирует MOVEFILE_WRITE_THROUGH
+    bool replaceSynced(const std::string& from, const std::string& to)
+    {
+        return MoveFileExW(std::filesystem::path(from).c_str(), std::filesystem::path(to).c_str(),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+#else
+    bool writeSynced(const std::string& path, const std::vector<std::uint8_t>& bytes)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) return false;
+
+        std::size_t written = 0;
+        while (written < bytes.size())
+        {
+            ssize_t count = write(fd, bytes.data() + written, bytes.size() - written);
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) break;
+            written += static_cast<std::size_t>(count);
+        }
+        bool ok = written == bytes.size() && fsync(fd) == 0;
+        return close(fd) == 0 && ok;
+    }
+
+    // Само переименование — запись в каталоге, её тоже надо сбросить
+    bool replaceSynced(const std::string& from, const std::string& to)
+    {
+        if (rename(from.c_str(), to.c_str()) != 0) return false;
+
+        std::filesystem::path directory = std::filesystem::path(to).parent_path();
+        if (directory.empty()) directory = ".";
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1) return false;
+        bool ok = fsync(fd) == 0;
+        close(fd);
+        return ok;
+    }
+#endif
+}
+
+bool encodeSavedGame(const SavedGame& game, std::vector<std::uint8_t>& bytes)
+{
+    int cellCount = game.width * game.height;
+    // Номер клетки в списке бонусов — один байт
+    if (cellCount <= 0 || cellCount > 255 || game.goalCount > MAX_GOALS) return false;
+
+    bytes.clear();
+    for (std::uint8_t byte : SAVE_MAGIC) bytes.push_back(byte);
+    writeInt(bytes, SAVE_VERSION, 2);
+    writeInt(bytes, game.width, 1);
+    writeInt(bytes, game.height, 1);
+    writeInt(bytes, game.tileTypeCount, 1);
+    writeInt(bytes, game.goalCount, 1);
+    writeInt(bytes, game.movesLeft, 2);
+    writeInt(bytes, game.randomState, 8);
+    writeInt(bytes, game.randomIncrement, 8);
+
+    // Маска формы, по биту на клетку
+    for (int base = 0; base < cellCount; base += 8)
+    {
+        std::uint8_t packed = 0;
+        for (int bit = 0; bit < 8 && base + bit < cellCount; ++bit)
+        {
+            if (game.playable[base + bit]) packed |= 1 << bit;
+        }
+        bytes.push_back(packed);
+    }
+
+    // Цвета игровых клеток, по две на байт
+    int specialCount = 0;
+    int nibble = 0;
+    for (int cell = 0; cell < cellCount; ++cell)
+    {
+        if (!game.playable[cell]) continue;
+
+        int value = game.cells[cell];
+        if (tileSpecial(value) != SpecialTile::None) specialCount++;
+        if (nibble == 0) bytes.push_back(0);
+        bytes.back() |= static_cast<std::uint8_t>(tileColor(value) << (4 * nibble));
+        nibble ^= 1;
+    }
+
+    writeInt(bytes, specialCount, 1);
+    for (int cell = 0; cell < cellCount; ++cell)
+    {
+        SpecialTile special = tileSpecial(game.cells[cell]);
+        if (!game.playable[cell] || special == SpecialTile::None) continue;
+
+        writeInt(bytes, cell, 1);
+        writeInt(bytes, static_cast<int>(special), 1);
+    }
+
+    for (int i = 0; i < game.goalCount; ++i)
+    {
+        writeInt(bytes, static_cast<int>(game.goals[i].kind), 1);
+        writeInt(bytes, game.goals[i].param, 1);
+        writeVarint(bytes, game.goals[i].target);
+    }
+
+    const GameStats::Counters& counters = game.counters;
+    for (int value : counters.clearedByColor) writeVarint(bytes, value);
+    writeVarint(bytes, counters.totalCleared);
+    for (int value : counters.comboHistogram) writeVarint(bytes, value);
+    writeVarint(bytes, counters.maxCombo);
+    for (int value : counters.specialsCreated) writeVarint(bytes, value);
+
+    writeInt(bytes, fnv1a(bytes.data(), bytes.size()), CHECKSUM_SIZE);
+    return true;
+}
+
+bool decodeSavedGame(const std::uint8_t* data, std::size_t size, SavedGame& game)
+{
+    if (size < sizeof(SAVE_MAGIC) + CHECKSUM_SIZE) return false;
+    if (!std::equal(std::begin(SAVE_MAGIC), std::end(SAVE_MAGIC), data)) return false;
+
+    std::size_t payloadSize = size - CHECKSUM_SIZE;
+    Reader checksum(data + payloadSize, CHECKSUM_SIZE);
+    if (checksum.read(CHECKSUM_SIZE) != fnv1a(data, payloadSize)) return false;
+
+    Reader reader(data + sizeof(SAVE_MAGIC), payloadSize - sizeof(SAVE_MAGIC));
+    if (reader.read(2) != SAVE_VERSION) return false;
+
+    game.width = static_cast<int>(reader.read(1));
+    game.height = static_cast<int>(reader.read(1));
+    game.tileTypeCount = static_cast<int>(reader.read(1));
+    game.goalCount = static_cast<int>(reader.read(1));
+    game.movesLeft = static_cast<int>(reader.read(2));
+    game.randomState = reader.read(8);
+    game.randomIncrement = reader.read(8);
+
+    int cellCount = game.width * game.height;
+    if (!reader.ok() || cellCount <= 0 || game.goalCount > MAX_GOALS) return false;
+
+    game.playable.assign(cellCount, 0);
+    for (int base = 0; base < cellCount; base += 8)
+    {
+        std::uint8_t packed = static_cast<std::uint8_t>(reader.read(1));
+        for (int bit = 0; bit < 8 && base + bit < cellCount; ++bit)
+        {
+            game.playable[base + bit] = (packed >> bit) & 1;
+        }
+    }
+
+    game.cells.assign(cellCount, BLOCKED_TILE);
+    int nibble = 0;
+    std::uint8_t packed = 0;
+    for (int cell = 0; cell < cellCount; ++cell)
+    {
+        if (!game.playable[cell]) continue;
+
+        if (nibble == 0) packed = static_cast<std::uint8_t>(reader.read(1));
+        game.cells[cell] = (packed >> (4 * nibble)) & TILE_COLOR_MASK;
+        nibble ^= 1;
+    }
+
+    int specialCount = static_cast<int>(reader.read(1));
+    for (int i = 0; i < specialCount; ++i)
+    {
+        int cell = static_cast<int>(reader.read(1));
+        int special = static_cast<int>(reader.read(1));
+        if (cell >= cellCount || special >= SPECIAL_TILE_KINDS || !game.playable[cell]) return false;
+
+        game.cells[cell] = makeTile(tileColor(game.cells[cell]), static_cast<SpecialTile>(special));
+    }
+
+    for (int i = 0; i < game.goalCount; ++i)
+    {
+        int kind = static_cast<int>(reader.read(1));
+        if (kind >= GOAL_KIND_COUNT) return false;
+
+        game.goals[i].kind = static_cast<GoalKind>(kind);
+        game.goals[i].param = static_cast<int>(reader.read(1));
+        game.goals[i].target = static_cast<int>(reader.readVarint());
+    }
+
+    GameStats::Counters& counters = game.counters;
+    for (int& value : counters.clearedByColor) value = static_cast<int>(reader.readVarint());
+    counters.totalCleared = static_cast<int>(reader.readVarint());
+    for (int& value : counters.comboHistogram) value = static_cast<int>(reader.readVarint());
+    counters.maxCombo = static_cast<int>(reader.readVarint());
+    for (int& value : counters.specialsCreated) value = static_cast<int>(reader.readVarint());
+
+    // Лишние байты до контрольной суммы — признак чужого формата
+    return reader.ok() && sizeof(SAVE_MAGIC) + reader.getPosition() == payloadSize;
+}
+
+bool loadSavedGame(const std::string& path, SavedGame& game)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!decodeSavedGame(bytes.data(), bytes.size(), game))
+    {
+        std::cerr << "Save file " << path << " is corrupted or has an unknown version, ignoring it" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SaveWriter::SaveWriter(const std::string& path) :
+    path(path),
+    tempPath(path + ".tmp"),
+    thread(&SaveWriter::run, this)
+{
+}
+
+SaveWriter::~SaveWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+}
+
+void SaveWriter::submit(const std::vector<std::uint8_t>& bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Буфер переиспользуется, пока размер снимка не растёт
+        pending.assign(bytes.begin(), bytes.end());
+        pendingJob = Job::Write;
+    }
+    wakeUp.notify_one();
+}
+
+void SaveWriter::discard()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingJob = Job::Remove;
+    }
+    wakeUp.notify_one();
+}
+
+void SaveWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wakeUp.wait(lock, [this] { return stopping || pendingJob != Job::None; });
+        // При остановке последний снимок всё равно дописывается
+        if (pendingJob == Job::None) return;
+
+        Job job = pendingJob;
+        pendingJob = Job::None;
+        writing.swap(pending);
+        lock.unlock();
+
+        if (job == Job::Write)
+        {
+            writeFile(writing);
+        }
+        else
+        {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+
+        lock.lock();
+    }
+}
+
+bool SaveWriter::writeFile(const std::vector<std::uint8_t>& bytes)
+{
+    if (!writeSynced(tempPath, bytes))
+    {
+        std::cerr << "Failed to write save file " << tempPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Переименование заменяет старый файл целиком, поэтому прочитать
+    // половину сохранения нельзя
+    if (!replaceSynced(tempPath, path))
+    {
+        std::cerr << "Failed to replace save file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game_stats.h"
+
+// Всё, что нужно, чтобы продолжить партию с устоявшейся доски
+// Клетки лежат в memory: игра собирает снимок в памяти шага, без кучи.
+struct SavedGame
+{
+    explicit SavedGame(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) :
+        cells(memory),
+        playable(memory)
+    {
+    }
+
+    int width = 0;
+    int height = 0;
+    std::pmr::vector<int> cells;            // Значения клеток построчно
+    std::pmr::vector<std::uint8_t> playable; // Маска формы доски
+    std::uint64_t randomState = 0;
+    std::uint64_t randomIncrement = 0;
+    int tileTypeCount = 0;
+    int movesLeft = 0;
+    LevelGoal goals[MAX_GOALS] = {};
+    int goalCount = 0;
+    GameStats::Counters counters;
+};
+
+// Двоичный снимок версии SAVE_VERSION. Цвет игровой клетки занимает
+// 4 бита, угловые клетки задаёт битовая маска, редкие бонусы идут
+// отдельным списком, счётчики — varint. В конце — контрольная сумма FNV-1a.
+const int SAVE_VERSION = 1;
+
+bool encodeSavedGame(const SavedGame& game, std::vector<std::uint8_t>& bytes);
+bool decodeSavedGame(const std::uint8_t* data, std::size_t size, SavedGame& game);
+// false, если файла нет или он повреждён
+bool loadSavedGame(const std::string& path, SavedGame& game);
+
+// Запись сохранений в фоновом потоке. Снимок пишется во временный файл,
+// сбрасывается на диск и переименовывается поверх старого, так что при
+// падении или отключении питания на диске остаётся либо прежнее, либо
+// новое сохранение целиком. Если поток не
+// успевает, промежуточные снимки пропускаются — пишется последний.
+class SaveWriter
+{
+public:
+    explicit SaveWriter(const std::string& path);
+    // Дописывает последний снимок перед выходом
+    ~SaveWriter();
+
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+
+    void submit(const std::vector<std::uint8_t>& bytes);
+    // Партия закончилась, сохранение больше не нужно
+    void discard();
+
+private:
+    enum class Job
+    {
+        None,
+        Write,
+        Remove
+    };
+
+    void run();
+    bool writeFile(const std::vector<std::uint8_t>& bytes);
+
+    std::string path;
+    std::string tempPath;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    Job pendingJob = Job::None;          // Под mutex
+    std::vector<std::uint8_t> pending;   // Под mutex
+    bool stopping = false;               // Под mutex
+
+    std::vector<std::uint8_t> writing;   // Принадлежит потоку записи
+    std::thread thread;
+};
@@ -0,0 +1,140 @@
+// Сохранение партии: снимок после кодирования и разбора совпадает с
+// исходным, а любой испорченный или отрезанный байт отвергается
+// контрольной суммой. Последняя часть пишет снимок через SaveWriter
+// (временный файл, сброс на диск, переименование) и читает его обратно.
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "save_game.h"
+
+namespace
+{
+    const int WIDTH = 7;
+    const int HEIGHT = 6;
+
+    // Доска со срезанными углами, бонусами всех видов и непустыми счётчиками
+    SavedGame sampleGame()
+    {
+        SavedGame game;
+        game.width = WIDTH;
+        game.height = HEIGHT;
+        game.tileTypeCount = 6;
+        game.movesLeft = 23;
+        game.randomState = 0x853c49e6748fea9bull;
+        game.randomIncrement = 0xda3e39cb94b95bdbull;
+        game.cells.assign(WIDTH * HEIGHT, 0);
+        game.playable.assign(WIDTH * HEIGHT, 1);
+        for (int cell = 0; cell < WIDTH * HEIGHT; ++cell) game.cells[cell] = 1 + cell % game.tileTypeCount;
+
+        const int corners[] = { 0, WIDTH - 1, WIDTH * (HEIGHT - 1), WIDTH * HEIGHT - 1 };
+        for (int cell : corners)
+        {
+            game.playable[cell] = 0;
+            game.cells[cell] = BLOCKED_TILE;
+        }
+        game.cells[8] = makeTile(2, SpecialTile::LineHorizontal);
+        game.cells[15] = makeTile(5, SpecialTile::LineVertical);
+        game.cells[20] = makeTile(3, SpecialTile::Bomb);
+        game.cells[33] = makeTile(0, SpecialTile::ColorBomb);
+
+        game.goals[0] = { GoalKind::ClearTiles, 3, 40 };
+        game.goals[1] = { GoalKind::ReachCombo, 0, 4 };
+        game.goals[2] = { GoalKind::CreateSpecials, 0, 300 }; // varint в два байта
+        game.goalCount = 3;
+
+        GameStats::Counters& counters = game.counters;
+        for (int color = 1; color <= game.tileTypeCount; ++color) counters.clearedByColor[color] = color * 17;
+        counters.totalCleared = 357;
+        counters.comboHistogram[1] = 12;
+        counters.comboHistogram[MAX_COMBO_DEPTH] = 1;
+        counters.maxCombo = 20;
+        counters.specialsCreated[static_cast<int>(SpecialTile::Bomb)] = 2;
+        return game;
+    }
+
+    bool sameGame(const SavedGame& a, const SavedGame& b)
+    {
+        if (a.width != b.width || a.height != b.height || a.tileTypeCount != b.tileTypeCount ||
+            a.movesLeft != b.movesLeft || a.randomState != b.randomState ||
+            a.randomIncrement != b.randomIncrement || a.goalCount != b.goalCount ||
+            a.cells != b.cells || a.playable != b.playable)
+        {
+            return false;
+        }
+        for (int i = 0; i < a.goalCount; ++i)
+        {
+            if (a.goals[i].kind != b.goals[i].kind || a.goals[i].param != b.goals[i].param ||
+                a.goals[i].target != b.goals[i].target)
+            {
+                return false;
+            }
+        }
+        return a.counters.clearedByColor == b.counters.clearedByColor &&
+            a.counters.totalCleared == b.counters.totalCleared &&
+            a.counters.comboHistogram == b.counters.comboHistogram &&
+            a.counters.maxCombo == b.counters.maxCombo &&
+            a.counters.specialsCreated == b.counters.specialsCreated;
+    }
+}
+
+int main()
+{
+    SavedGame game = sampleGame();
+    std::vector<std::uint8_t> bytes;
+    if (!encodeSavedGame(game, bytes))
+    {
+        std::cerr << "Failed to encode the sample game" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SavedGame decoded;
+    if (!decodeSavedGame(bytes.data(), bytes.size(), decoded) || !sameGame(game, decoded))
+    {
+        std::cerr << "Decoded game differs from the encoded one" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // FNV-1a меняется от любого изменённого байта, включая саму сумму
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+    {
+        std::vector<std::uint8_t> corrupted = bytes;
+        corrupted[i] ^= 0x10;
+        if (decodeSavedGame(corrupted.data(), corrupted.size(), decoded))
+        {
+            std::cerr << "Save with byte " << i << " flipped was accepted" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    for (std::size_t size = 0; size < bytes.size(); ++size)
+    {
+        if (decodeSavedGame(bytes.data(), size, decoded))
+        {
+            std::cerr << "Save cut to " << size << " bytes was accepted" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "bigwash_save_check.bin";
+    {
+        // Разрушение дописывает последний снимок
+        SaveWriter writer(path.string());
+        game.movesLeft = 5;
+        encodeSavedGame(game, bytes);
+        writer.submit(bytes);
+    }
+    SavedGame loaded;
+    bool loadedBack = loadSavedGame(path.string(), loaded);
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    if (!loadedBack || !sameGame(game, loaded))
+    {
+        std::cerr << "Save written by SaveWriter did not load back" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Save round trip of " << bytes.size() << " bytes, every flipped or cut byte rejected" << std::endl;
+    return 0;
+}
@@ -0,0 +1,356 @@
+// Нагрузочный клиент сервера партий. Каждое соединение играет свою партию:
+// держит копию доски с тем же зерном, выбирает случайный легальный ход,
+// сам досчитывает каскад и заявляет серверу число удалённых тайлов, как
+// это делал бы настоящий клиент. Ответ сверяется с копией по хэшу доски.
+// С --cheat-every N каждая N-я заявка завышается на один тайл, и сервер
+// должен её поймать.
+//
+// Соединения делятся между потоками, у каждого потока свой epoll; на
+// соединении в полёте одна команда. Итог — ходы в секунду и задержка
+// ответа (запрос до ответа, со стороны клиента) p50/p99.
+//
+// Использование: bigwash_load [--host адрес] [--port N] [--sessions N]
+//                             [--threads N] [--seconds N] [--level файл]
+//                             [--tile-types N] [--cheat-every N] [--seed N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+
+#include "level_layout.h"
+#include "server_net.h"
+#include "server_session.h"
+
+namespace
+{
+    struct LoadOptions
+    {
+        std::string host = "127.0.0.1";
+        int port = SERVER_DEFAULT_PORT;
+        int sessions = 1000;
+        int threads = 2;
+        int seconds = 10;
+        std::string levelPath = "levels/level1.txt";
+        int tileTypes = 6;
+        int cheatEvery = 0;
+        std::uint32_t seed = 1;
+    };
+
+    // Итоги одного потока
+    struct LoadResult
+    {
+        std::uint64_t moves = 0;
+        std::uint64_t games = 0;
+        std::uint64_t desyncs = 0;       // Ответ сервера разошёлся с копией
+        std::uint64_t cheatsSent = 0;
+        std::uint64_t cheatsCaught = 0;
+        std::uint64_t falseAlarms = 0;   // Сервер отверг честную заявку или ход
+        bool failed = false;
+        std::vector<std::uint32_t> latencies; // Микросекунды от запроса до ответа
+    };
+
+    struct LoadClient
+    {
+        LoadClient(int fd, const LevelLayout& level, const SpawnPolicy& spawn) : connection(fd), session(level, spawn) {}
+
+        LineConnection connection;
+        BoardSession session;
+        std::uint32_t nextSeed = 0;
+        bool cheated = false;
+        int expectedCleared = 0;
+        std::chrono::steady_clock::time_point sentAt;
+    };
+
+    int connectTo(const LoadOptions& options)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) return -1;
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(options.port));
+        if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1 ||
+            connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+            !setNonBlocking(fd))
+        {
+            close(fd);
+            return -1;
+        }
+        setNoDelay(fd);
+        return fd;
+    }
+
+    // Первое поле ответа и числа за ним
+    bool parseReply(const std::string& line, std::string& kind, std::vector<std::uint64_t>& values)
+    {
+        std::istringstream fields(line);
+        values.clear();
+        if (!(fields >> kind)) return false;
+        std::uint64_t value;
+        while (fields >> value) values.push_back(value);
+        return true;
+    }
+
+    class LoadThread
+    {
+    public:
+        LoadThread(const LoadOptions& options, const LevelLayout& level, int sessionCount, std::uint32_t firstSeed) :
+            options(options),
+            level(level),
+            sessionCount(sessionCount),
+            firstSeed(firstSeed),
+            workspace(level.width, level.height),
+            spawn(level.spawn, options.tileTypes),
+            random(firstSeed)
+        {
+        }
+
+        ~LoadThread()
+        {
+            for (std::unique_ptr<LoadClient>& client : clients) close(client->connection.getFd());
+            if (epollFd != -1) close(epollFd);
+        }
+
+        void run(std::chrono::steady_clock::time_point deadline);
+        LoadResult& getResult() { return result; }
+
+    private:
+        void startGame(LoadClient& client);
+        void sendMove(LoadClient& client);
+        bool handleReply(LoadClient& client, const std::string& line);
+
+        const LoadOptions& options;
+        const LevelLayout& level;
+        int sessionCount;
+        std::uint32_t firstSeed;
+        RuleWorkspace workspace;
+        SpawnPolicy spawn;
+        GameRandom random; // Выбор ходов
+        int epollFd = -1;
+        std::vector<std::unique_ptr<LoadClient>> clients;
+        std::vector<BoardMove> moves;
+        std::vector<std::uint64_t> values;
+        std::string line;
+        std::string kind;
+        LoadResult result;
+    };
+
+    void LoadThread::run(std::chrono::steady_clock::time_point deadline)
+    {
+        epollFd = epoll_create1(0);
+        for (int i = 0; i < sessionCount; ++i)
+        {
+            int fd = connectTo(options);
+            if (fd == -1)
+            {
+                std::cerr << "Failed to connect to " << options.host << ":" << options.port << ": " << std::strerror(errno) << std::endl;
+                result.failed = true;
+                return;
+            }
+            clients.emplace_back(new LoadClient(fd, level, spawn));
+            LoadClient& client = *clients.back();
+            client.nextSeed = firstSeed + static_cast<std::uint32_t>(i) * 7919u;
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = &client;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            startGame(client);
+        }
+
+        epoll_event events[256];
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            int count = epoll_wait(epollFd, events, 256, 100);
+            for (int i = 0; i < count; ++i)
+            {
+                LoadClient& client = *static_cast<LoadClient*>(events[i].data.ptr);
+                if (!client.connection.receive())
+                {
+                    std::cerr << "Server closed a connection" << std::endl;
+                    result.failed = true;
+                    return;
+                }
+                while (client.connection.nextLine(line))
+                {
+                    if (!handleReply(client, line))
+                    {
+                        result.failed = true;
+                        return;
+                    }
+                }
+                // Запросы короткие, сокет их всегда принимает целиком
+                client.connection.flush();
+            }
+        }
+    }
+
+    void LoadThread::startGame(LoadClient& client)
+    {
+        client.session.start(client.nextSeed, workspace);
+        client.connection.send("start " + std::to_string(client.nextSeed) + "\n");
+        client.nextSeed++;
+        client.sentAt = std::chrono::steady_clock::now();
+        client.connection.flush();
+    }
+
+    void LoadThread::sendMove(LoadClient& client)
+    {
+        client.session.findMoves(moves);
+        BoardMove move = moves[random.nextInt(0, static_cast<int>(moves.size()) - 1)];
+
+        MoveOutcome outcome = client.session.applyMove(move, workspace);
+        client.expectedCleared = outcome.cleared;
+        int claimed = outcome.cleared;
+        client.cheated = options.cheatEvery > 0 && (result.moves + 1) % options.cheatEvery == 0;
+        if (client.cheated) claimed++;
+
+        std::ostringstream request;
+        request << "move " << move.fromX << ' ' << move.fromY << ' ' << move.toX << ' ' << move.toY << ' ' << claimed << '\n';
+        client.connection.send(request.str());
+        client.sentAt = std::chrono::steady_clock::now();
+    }
+
+    bool LoadThread::handleReply(LoadClient& client, const std::string& reply)
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - client.sentAt);
+        if (!parseReply(reply, kind, values))
+        {
+            std::cerr << "Malformed reply: " << reply << std::endl;
+            return false;
+        }
+
+        if (kind == "board")
+        {
+            if (values.size() < 2 || values[1] != client.session.hashBoard())
+            {
+                result.desyncs++;
+            }
+            result.games++;
+        }
+        else if (kind == "ok" || kind == "cheat")
+        {
+            result.moves++;
+            result.latencies.push_back(static_cast<std::uint32_t>(elapsed.count()));
+            if (values.size() < 3 || values[0] != static_cast<std::uint64_t>(client.expectedCleared) ||
+                values[2] != client.session.hashBoard())
+            {
+                result.desyncs++;
+            }
+            // Считаются только заявки, на которые успел прийти ответ
+            if (client.cheated) result.cheatsSent++;
+            if (kind == "cheat" && client.cheated) result.cheatsCaught++;
+            else if (kind == "cheat" || client.cheated) result.falseAlarms++;
+        }
+        else if (kind == "reject")
+        {
+            // Клиент ходит только легально, отказ — ошибка сервера
+            result.moves++;
+            result.falseAlarms++;
+        }
+        else
+        {
+            std::cerr << "Server error: " << reply << std::endl;
+            return false;
+        }
+
+        if (client.session.isOver()) startGame(client);
+        else sendMove(client);
+        return true;
+    }
+
+    std::uint32_t percentile(std::vector<std::uint32_t>& values, double fraction)
+    {
+        std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--host" && hasValue) options.host = argv[++i];
+        else if (arg == "--port" && hasValue) options.port = std::atoi(argv[++i]);
+        else if (arg == "--sessions" && hasValue) options.sessions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) options.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seconds" && hasValue) options.seconds = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--level" && hasValue) options.levelPath = argv[++i];
+        else if (arg == "--tile-types" && hasValue) options.tileTypes = std::max(3, std::atoi(argv[++i]));
+        else if (arg == "--cheat-every" && hasValue) options.cheatEvery = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            std::cerr << "Usage: bigwash_load [--host address] [--port N] [--sessions N] [--threads N] [--seconds N]"
+                " [--level file] [--tile-types N] [--cheat-every N] [--seed N]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    options.threads = std::min(options.threads, options.sessions);
+
+    LevelLayout level;
+    if (!loadLevel(options.levelPath, level))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<LoadThread>> loaders;
+    for (int i = 0; i < options.threads; ++i)
+    {
+        int sessions = options.sessions / options.threads + (i < options.sessions % options.threads ? 1 : 0);
+        loaders.emplace_back(new LoadThread(options, level, sessions, options.seed + static_cast<std::uint32_t>(i) * 1000003u));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::seconds(options.seconds);
+    std::vector<std::thread> threads;
+    for (std::unique_ptr<LoadThread>& loader : loaders)
+    {
+        threads.emplace_back(&LoadThread::run, loader.get(), deadline);
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    LoadResult total;
+    for (std::unique_ptr<LoadThread>& loader : loaders)
+    {
+        LoadResult& result = loader->getResult();
+        total.moves += result.moves;
+        total.games += result.games;
+        total.desyncs += result.desyncs;
+        total.cheatsSent += result.cheatsSent;
+        total.cheatsCaught += result.cheatsCaught;
+        total.falseAlarms += result.falseAlarms;
+        total.failed = total.failed || result.failed;
+        total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+
+    std::cout << options.sessions << " sessions, " << total.games << " games, " << total.moves << " moves, "
+        << static_cast<std::uint64_t>(total.moves / seconds) << " moves/s" << std::endl;
+    if (!total.latencies.empty())
+    {
+        std::cout << "Round trip: p50 " << percentile(total.latencies, 0.5) << " us, p99 "
+            << percentile(total.latencies, 0.99) << " us" << std::endl;
+    }
+    std::cout << "Wrong claims caught " << total.cheatsCaught << "/" << total.cheatsSent
+        << ", false alarms " << total.falseAlarms << ", desyncs " << total.desyncs << std::endl;
+
+    bool healthy = !total.failed && total.desyncs == 0 && total.falseAlarms == 0 && total.cheatsCaught == total.cheatsSent;
+    return healthy ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Общие куски сервера партий и нагрузочного клиента: неблокирующие
+// сокеты и построчный протокол поверх них. Только Linux/POSIX.
+//
+// Протокол — текстовые строки, по команде на строку:
+//   start <зерно>                        -> board <ходов> <хэш> <клетки построчно>
+//   move <x> <y> <x2> <y2> <удалено>     -> ok <удалено> <ходов> <хэш>
+//                                           cheat <удалено> <ходов> <хэш>  (ход принят, заявка неверна)
+//                                           reject                          (нелегальный ход)
+//   любая ошибка                         -> error <текст>
+// Клиент может слать несколько команд подряд, не дожидаясь ответов;
+// ответы приходят в том же порядке.
+
+const int SERVER_DEFAULT_PORT = 7777;
+const std::size_t MAX_LINE_LENGTH = 4096; // Длиннее — соединение закрывается
+const std::size_t READ_CHUNK_SIZE = 4096;
+const int MAX_READ_CHUNKS = 2;              // За одно пробуждение, остальное — на следующем
+const std::size_t MAX_PENDING_OUTPUT = 256 * 1024; // Больше не забрано — клиент не читает, закрываем
+
+inline bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+inline void setNoDelay(int fd)
+{
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// Буферы одного соединения
+class LineConnection
+{
+public:
+    explicit LineConnection(int fd) : fd(fd) {}
+
+    int getFd() const { return fd; }
+
+    // Читает не больше MAX_READ_CHUNKS кусков, чтобы один шумный клиент
+    // не держал поток. Недочитанное epoll (по уровню) отдаст снова.
+    // false — соединение закрыто или сломано.
+    bool receive()
+    {
+        char chunk[READ_CHUNK_SIZE];
+        for (int chunks = 0; chunks < MAX_READ_CHUNKS;)
+        {
+            ssize_t count = read(fd, chunk, sizeof(chunk));
+            if (count > 0)
+            {
+                input.append(chunk, static_cast<std::size_t>(count));
+                chunks++;
+                continue;
+            }
+            if (count == 0) return false;
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        return true;
+    }
+
+    // Следующая полная строка без '\n'. false — полной строки пока нет.
+    bool nextLine(std::string& line)
+    {
+        std::size_t end = input.find('\n', readOffset);
+        if (end == std::string::npos)
+        {
+            // Прочитанное выбрасывается, только когда строки кончились
+            input.erase(0, readOffset);
+            readOffset = 0;
+            return false;
+        }
+        line.assign(input, readOffset, end - readOffset);
+        readOffset = end + 1;
+        return true;
+    }
+
+    bool isOverlong() const { return input.size() - readOffset > MAX_LINE_LENGTH; }
+
+    void send(const std::string& text) { output += text; }
+    bool hasOutput() const { return writeOffset < output.size(); }
+    bool isBacklogged() const { return output.size() - writeOffset > MAX_PENDING_OUTPUT; }
+
+    // Пишет сколько примет сокет. false — соединение сломано.
+    bool flush()
+    {
+        while (writeOffset < output.size())
+        {
+            ssize_t count = write(fd, output.data() + writeOffset, output.size() - writeOffset);
+            if (count > 0)
+            {
+                writeOffset += static_cast<std::size_t>(count);
+                continue;
+            }
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            return false;
+        }
+        output.clear();
+        writeOffset = 0;
+        return true;
+    }
+
+private:
+    int fd;
+    std::string input;
+    std::size_t readOffset = 0;
+    std::string output;
+    std::size_t writeOffset = 0;
+};
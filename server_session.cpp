@@ -0,0 +1,77 @@
+#include "server_session.h"
+
+BoardSession::BoardSession(const LevelLayout& level, const SpawnPolicy& spawn) :
+    level(level),
+    spawn(spawn),
+    tileMap(level.height, std::vector<int>(level.width, 0))
+{
+}
+
+void BoardSession::start(std::uint32_t seed, RuleWorkspace& workspace)
+{
+    for (int y = 0; y < level.height; ++y)
+    {
+        for (int x = 0; x < level.width; ++x)
+        {
+            tileMap[y][x] = level.cell(x, y);
+        }
+    }
+
+    // Тот же порядок, что в игре: заполнение по столбцам, потом каскад
+    random.seed(seed);
+    spawn.setMovesMade(0);
+    refillEmpty(tileMap, spawn, random, workspace.scratch.filled);
+    settleBoard(tileMap, workspace.classifier, spawn, random, workspace.scratch);
+
+    movesLeft = level.moves;
+    started = true;
+    updateOver();
+}
+
+MoveOutcome BoardSession::applyMove(const BoardMove& move, RuleWorkspace& workspace)
+{
+    if (over) return MoveOutcome();
+
+    // Как в игре: фаза досыпания переключается до каскада хода
+    int movesMade = level.moves - movesLeft;
+    spawn.setMovesMade(movesMade + 1);
+    MoveOutcome outcome = resolveMove(tileMap, workspace.classifier, spawn, random, move, workspace.scratch);
+    if (!outcome.legal)
+    {
+        spawn.setMovesMade(movesMade);
+        return outcome;
+    }
+    movesLeft--;
+    updateOver();
+    return outcome;
+}
+
+std::uint64_t BoardSession::hashBoard() const
+{
+    // FNV-1a, как у раскладок уровней
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            hash = (hash ^ static_cast<std::uint8_t>(value >> (8 * i))) * 1099511628211ULL;
+        }
+    };
+
+    for (const std::vector<int>& row : tileMap)
+    {
+        for (int value : row) mix(static_cast<std::uint32_t>(value));
+    }
+    mix(static_cast<std::uint32_t>(movesLeft));
+    return hash;
+}
+
+void BoardSession::updateOver()
+{
+    if (movesLeft <= 0)
+    {
+        over = true;
+        return;
+    }
+    over = !hasPossibleMove(tileMap);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "board_logic.h"
+#include "level_layout.h"
+
+// Буферы правил, общие для всех партий одного потока сервера: партии
+// ходят по очереди, поэтому классификатор и буферы каскада не нужны
+// каждой свои
+struct RuleWorkspace
+{
+    RuleWorkspace(int width, int height) : classifier(width, height) {}
+
+    MatchClassifier classifier;
+    CascadeScratch scratch;
+};
+
+// Партия одного игрока на сервере: доска уровня, генератор и ходы.
+// Клиент держит такую же копию с тем же зерном и сам считает каждый
+// ход, сервер повторяет ход по тем же правилам и сверяет заявленное
+// клиентом число удалённых тайлов со своим.
+class BoardSession
+{
+public:
+    // spawn — правила досыпания уровня; таблицы общие для всех партий
+    BoardSession(const LevelLayout& level, const SpawnPolicy& spawn);
+
+    // Новая партия: поставленные тайлы уровня, остальное из генератора,
+    // готовые совпадения сняты
+    void start(std::uint32_t seed, RuleWorkspace& workspace);
+    // Ход по правилам игры; нелегальный ход или ход после конца доску не меняет
+    MoveOutcome applyMove(const BoardMove& move, RuleWorkspace& workspace);
+
+    bool isStarted() const { return started; }
+    // Ходы кончились или на доске нет ни одного хода
+    bool isOver() const { return over; }
+    int getMovesLeft() const { return movesLeft; }
+    const std::vector<std::vector<int>>& getTileMap() const { return tileMap; }
+    // Все легальные ходы текущей доски
+    void findMoves(std::vector<BoardMove>& moves) { findPossibleMoves(tileMap, moves); }
+    // Хэш доски и счётчика ходов: клиент сверяет по нему свою копию
+    std::uint64_t hashBoard() const;
+
+private:
+    void updateOver();
+
+    const LevelLayout& level;
+    SpawnPolicy spawn;
+    std::vector<std::vector<int>> tileMap;
+    GameRandom random;
+    int movesLeft = 0;
+    bool started = false;
+    bool over = true;
+};
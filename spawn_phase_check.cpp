@@ -0,0 +1,128 @@
+// Сверка досыпания сервера с игрой на уровне, где фаза досыпания
+// меняется на каждом ходу. Игра и перебор ходов переключают фазу до
+// каскада хода (countMove, board_perft), сервер должен делать так же,
+// иначе его доска расходится с клиентской с первой же границы фаз.
+// Путь игры повторён здесь на правилах board_logic, без SFML.
+//
+// Использование: spawn_phase_check [--seeds N]
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "board_logic.h"
+#include "level_layout.h"
+#include "server_session.h"
+
+namespace
+{
+    const char* const ROWS[] =
+    {
+        "##...##",
+        "#.....#",
+        ".......",
+        ".......",
+        ".......",
+        "#.....#",
+        "##...##",
+    };
+    const LevelGoal GOALS[] = { { GoalKind::ClearTiles, 1, 1000 } };
+    const int MOVES = 20;
+    const int TILE_TYPES = 6;
+
+    // Каждый ход — новая фаза, и в каждой перевешивает свой цвет
+    LevelLayout phasedLevel()
+    {
+        LevelLayout level = makeLevelLayout(7, 7, ROWS, GOALS, 1, MOVES);
+        for (int move = 0; move < MOVES; ++move)
+        {
+            SpawnPhase phase;
+            phase.fromMove = move;
+            phase.weightCount = TILE_TYPES;
+            for (int color = 0; color < TILE_TYPES; ++color) phase.weights[color] = 1.0f;
+            phase.weights[move % TILE_TYPES] = 12.0f;
+            level.spawn.phases.push_back(phase);
+        }
+        return level;
+    }
+
+    // Начало партии в порядке игры: поставленные тайлы, заполнение, снятие совпадений
+    void startGameBoard(const LevelLayout& level, SpawnPolicy& spawn, std::uint32_t seed,
+        std::vector<std::vector<int>>& tileMap, GameRandom& random)
+    {
+        tileMap.assign(level.height, std::vector<int>(level.width, 0));
+        for (int y = 0; y < level.height; ++y)
+        {
+            for (int x = 0; x < level.width; ++x) tileMap[y][x] = level.cell(x, y);
+        }
+        MatchClassifier classifier(level.width, level.height);
+        CascadeScratch scratch;
+        random.seed(seed);
+        spawn.setMovesMade(0);
+        refillEmpty(tileMap, spawn, random, scratch.filled);
+        settleBoard(tileMap, classifier, spawn, random, scratch);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int seeds = 16;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::max(1, std::atoi(argv[++i]));
+        else
+        {
+            std::cerr << "Usage: spawn_phase_check [--seeds N]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    LevelLayout level = phasedLevel();
+    SpawnPolicy levelSpawn(level.spawn, TILE_TYPES);
+    RuleWorkspace workspace(level.width, level.height);
+    MatchClassifier classifier(level.width, level.height);
+    CascadeScratch scratch;
+    std::vector<BoardMove> moves;
+    int played = 0;
+
+    for (std::uint32_t seed = 1; seed <= static_cast<std::uint32_t>(seeds); ++seed)
+    {
+        BoardSession server(level, levelSpawn);
+        server.start(seed, workspace);
+
+        SpawnPolicy spawn = levelSpawn;
+        std::vector<std::vector<int>> tileMap;
+        GameRandom random;
+        startGameBoard(level, spawn, seed, tileMap, random);
+
+        for (int made = 0; made < MOVES; ++made)
+        {
+            if (server.getTileMap() != tileMap)
+            {
+                std::cerr << "Seed " << seed << ": server board differs from the game after " << made << " moves" << std::endl;
+                return EXIT_FAILURE;
+            }
+            findPossibleMoves(tileMap, moves);
+            if (moves.empty() || server.isOver()) break;
+
+            // Отвергнутый ход не должен сдвигать фазу сервера
+            if (made % 5 == 2) server.applyMove({ 0, 0, 2, 0 }, workspace);
+
+            const BoardMove& move = moves[(seed + made) % moves.size()];
+            // Как countMove в игре: фаза по числу ходов вместе с этим
+            spawn.setMovesMade(made + 1);
+            resolveMove(tileMap, classifier, spawn, random, move, scratch);
+            if (!server.applyMove(move, workspace).legal)
+            {
+                std::cerr << "Seed " << seed << ": server rejected a legal move" << std::endl;
+                return EXIT_FAILURE;
+            }
+            played++;
+        }
+    }
+
+    std::cout << played << " moves across spawn phase boundaries, server boards match the game" << std::endl;
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "spawn_policy.h"
+
+#include <algorithm>
+
+bool sameSpawnRules(const SpawnRules& first, const SpawnRules& second)
+{
+    if (first.neighbours != second.neighbours || first.boost != second.boost) return false;
+    return std::equal(first.phases.begin(), first.phases.end(), second.phases.begin(), second.phases.end(),
+        [](const SpawnPhase& a, const SpawnPhase& b)
+        {
+            return a.fromMove == b.fromMove && a.weightCount == b.weightCount &&
+                std::equal(a.weights, a.weights + a.weightCount, b.weights);
+        });
+}
+
+SpawnPolicy::SpawnPolicy(int tileTypeCount) :
+    tileTypes(std::min(std::max(tileTypeCount, 1), MAX_TILE_TYPES))
+{
+}
+
+SpawnPolicy::SpawnPolicy(const SpawnRules& rules, int tileTypeCount) :
+    SpawnPolicy(tileTypeCount)
+{
+    uniform = rules.isUniform();
+    if (uniform) return;
+
+    neighbours = rules.neighbours;
+    boost = std::max(rules.boost, 0.0f);
+    maskCount = neighbours == SpawnNeighbours::Ignore ? 1 : 1 << tileTypes;
+
+    // До первой фазы цвета равновероятны
+    std::vector<SpawnPhase> phases = rules.phases;
+    std::stable_sort(phases.begin(), phases.end(),
+        [](const SpawnPhase& a, const SpawnPhase& b) { return a.fromMove < b.fromMove; });
+    if (phases.empty() || phases.front().fromMove > 0)
+    {
+        phases.insert(phases.begin(), SpawnPhase());
+    }
+
+    std::vector<AliasTable> built(phases.size() * maskCount);
+    for (std::size_t index = 0; index < phases.size(); ++index)
+    {
+        const SpawnPhase& rule = phases[index];
+        phaseStarts.push_back(rule.fromMove);
+
+        float base[MAX_TILE_TYPES];
+        bool anyWeight = false;
+        for (int color = 0; color < tileTypes; ++color)
+        {
+            base[color] = color < rule.weightCount ? std::max(rule.weights[color], 0.0f) : 1.0f;
+            anyWeight = anyWeight || base[color] > 0.0f;
+        }
+        if (!anyWeight) std::fill(base, base + tileTypes, 1.0f);
+
+        for (int mask = 0; mask < maskCount; ++mask)
+        {
+            float weights[MAX_TILE_TYPES];
+            bool anyLeft = false;
+            for (int color = 0; color < tileTypes; ++color)
+            {
+                bool closesLine = (mask >> color) & 1;
+                weights[color] = base[color];
+                if (closesLine && neighbours == SpawnNeighbours::Avoid) weights[color] = 0.0f;
+                if (closesLine && neighbours == SpawnNeighbours::Encourage) weights[color] *= boost;
+                anyLeft = anyLeft || weights[color] > 0.0f;
+            }
+            // Все разрешённые цвета замыкают тройку: выбор как без соседей
+            buildTable(anyLeft ? weights : base, built[index * maskCount + mask]);
+        }
+    }
+    tables = std::make_shared<const std::vector<AliasTable>>(std::move(built));
+}
+
+void SpawnPolicy::setMovesMade(int movesMade)
+{
+    phase = 0;
+    for (std::size_t i = 1; i < phaseStarts.size() && phaseStarts[i] <= movesMade; ++i)
+    {
+        phase = static_cast<int>(i);
+    }
+}
+
+// Метод Воуза: столбцы с долей меньше средней добираются из больших
+void SpawnPolicy::buildTable(const float* weights, AliasTable& table) const
+{
+    double total = 0.0;
+    for (int color = 0; color < tileTypes; ++color) total += weights[color];
+
+    double scaled[MAX_TILE_TYPES];
+    int small[MAX_TILE_TYPES], large[MAX_TILE_TYPES];
+    int smallCount = 0, largeCount = 0;
+    for (int color = 0; color < tileTypes; ++color)
+    {
+        scaled[color] = weights[color] * tileTypes / total;
+        if (scaled[color] < 1.0) small[smallCount++] = color;
+        else large[largeCount++] = color;
+    }
+
+    const double FULL = 4294967296.0; // 2^32
+    while (smallCount > 0 && largeCount > 0)
+    {
+        int less = small[--smallCount];
+        int more = large[--largeCount];
+        table.threshold[less] = static_cast<std::uint64_t>(scaled[less] * FULL);
+        table.alias[less] = static_cast<std::uint8_t>(more);
+        scaled[more] += scaled[less] - 1.0;
+        if (scaled[more] < 1.0) small[smallCount++] = more;
+        else large[largeCount++] = more;
+    }
+    // Остаток — полные столбцы; ошибки округления тоже попадают сюда
+    while (largeCount > 0) table.threshold[large[--largeCount]] = static_cast<std::uint64_t>(FULL);
+    while (smallCount > 0) table.threshold[small[--smallCount]] = static_cast<std::uint64_t>(FULL);
+    for (int color = tileTypes; color < MAX_TILE_TYPES; ++color)
+    {
+        table.threshold[color] = 0;
+        table.alias[color] = 0;
+    }
+}
+
+int SpawnPolicy::lineColors(const std::vector<std::vector<int>>& tileMap, int x, int y) const
+{
+    int height = static_cast<int>(tileMap.size());
+    int width = static_cast<int>(tileMap[0].size());
+    auto colorAt = [&tileMap, width, height](int cx, int cy)
+    {
+        if (cx < 0 || cy < 0 || cx >= width || cy >= height) return 0;
+        int value = tileMap[cy][cx];
+        return isMatchable(value) ? tileColor(value) : 0;
+    };
+
+    int mask = 0;
+    auto pair = [this, &mask](int a, int b)
+    {
+        if (a != 0 && a == b && a <= tileTypes) mask |= 1 << (a - 1);
+    };
+
+    int left = colorAt(x - 1, y), farLeft = colorAt(x - 2, y);
+    int right = colorAt(x + 1, y), farRight = colorAt(x + 2, y);
+    pair(left, farLeft);
+    pair(left, right);
+    pair(right, farRight);
+
+    int up = colorAt(x, y - 1), farUp = colorAt(x, y - 2);
+    int down = colorAt(x, y + 1), farDown = colorAt(x, y + 2);
+    pair(up, farUp);
+    pair(up, down);
+    pair(down, farDown);
+    return mask;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "game_random.h"
+#include "tile_value.h"
+
+// Как новый тайл учитывает уже стоящих соседей
+enum class SpawnNeighbours
+{
+    Ignore,
+    Avoid,     // Цвета, которые сразу замкнули бы тройку, не выпадают
+    Encourage, // Такие цвета выпадают в boost раз чаще
+};
+
+// Веса цветов с хода fromMove: weights[c - 1] — вес цвета c,
+// цвета за weightCount весят 1, вес 0 — цвет не выпадает
+struct SpawnPhase
+{
+    int fromMove = 0;
+    float weights[MAX_TILE_TYPES] = {};
+    int weightCount = 0;
+};
+
+// Правила досыпания уровня; по умолчанию — равномерно, как без них
+struct SpawnRules
+{
+    std::vector<SpawnPhase> phases; // По возрастанию fromMove
+    SpawnNeighbours neighbours = SpawnNeighbours::Ignore;
+    float boost = 4.0f;
+
+    bool isUniform() const { return phases.empty() && neighbours == SpawnNeighbours::Ignore; }
+};
+
+bool sameSpawnRules(const SpawnRules& first, const SpawnRules& second);
+
+// Цвет нового тайла за O(1) и без повторных попыток. Для каждой фазы и
+// каждого набора цветов, которые замкнули бы тройку в клетке, заранее
+// построена таблица псевдонимов (метод Уолкера–Воуза): выбор — одно число
+// генератора, столбец и сравнение с порогом. Набор цветов клетки берётся
+// из пар соседей по четырём направлениям, тоже за постоянное время.
+// Без правил остаётся прежний nextInt(1, n): тайлы старых уровней,
+// записей и сохранений выпадают те же. Копии делят таблицы, у каждой
+// своя фаза — так тысячи партий сервера держат одну таблицу уровня.
+class SpawnPolicy
+{
+public:
+    explicit SpawnPolicy(int tileTypeCount = 6);
+    SpawnPolicy(const SpawnRules& rules, int tileTypeCount);
+
+    int getTileTypeCount() const { return tileTypes; }
+    bool isUniform() const { return uniform; }
+
+    // Фаза по числу засчитанных ходов партии
+    void setMovesMade(int movesMade);
+
+    // Цвет для пустой клетки (x, y); соседи берутся из tileMap как есть
+    int draw(const std::vector<std::vector<int>>& tileMap, int x, int y, GameRandom& random) const
+    {
+        if (uniform) return random.nextInt(1, tileTypes);
+
+        int mask = neighbours == SpawnNeighbours::Ignore ? 0 : lineColors(tileMap, x, y);
+        const AliasTable& table = (*tables)[phase * maskCount + mask];
+        std::uint64_t product = static_cast<std::uint64_t>(random.next()) * static_cast<std::uint32_t>(tileTypes);
+        int column = static_cast<int>(product >> 32);
+        std::uint32_t fraction = static_cast<std::uint32_t>(product);
+        return 1 + (fraction < table.threshold[column] ? column : table.alias[column]);
+    }
+
+private:
+    struct AliasTable
+    {
+        std::uint64_t threshold[MAX_TILE_TYPES]; // Доля своего цвета в столбце, из 2^32
+        std::uint8_t alias[MAX_TILE_TYPES];      // Цвет - 1 для остатка столбца
+    };
+
+    // Биты цветов (цвет - 1), которые в клетке замкнули бы линию из трёх
+    int lineColors(const std::vector<std::vector<int>>& tileMap, int x, int y) const;
+    void buildTable(const float* weights, AliasTable& table) const;
+
+    int tileTypes;
+    bool uniform = true;
+    SpawnNeighbours neighbours = SpawnNeighbours::Ignore;
+    float boost = 1.0f;
+    int maskCount = 1;             // Таблиц на фазу: 2^tileTypes, если соседи учитываются
+    std::vector<int> phaseStarts;  // fromMove каждой фазы
+    std::shared_ptr<const std::vector<AliasTable>> tables; // phase * maskCount + mask
+    int phase = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Кольцевая очередь без блокировок для одного производителя и одного
+// потребителя. Ёмкость должна быть степенью двойки.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Вызывается только производителем. false, если очередь заполнена.
+    bool push(const T& item)
+    {
+        std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        items[tail & (Capacity - 1)] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Вызывается только потребителем. false, если очередь пуста.
+    bool pop(T& item)
+    {
+        std::size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items[head & (Capacity - 1)];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[Capacity];
+    alignas(64) std::atomic<std::size_t> headIndex{ 0 };
+    alignas(64) std::atomic<std::size_t> tailIndex{ 0 };
+};
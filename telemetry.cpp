@@ -0,0 +1,269 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    struct CounterInfo
+    {
+        const char* key;
+        const char* help;
+    };
+
+    struct HistogramInfo
+    {
+        const char* key;
+        const char* help;
+        double scale; // Множитель к единицам экспорта
+    };
+
+    const CounterInfo COUNTERS[TELEMETRY_COUNTER_COUNT] =
+    {
+        { "games_started", "Games started from a fresh board" },
+        { "games_won", "Games finished with all goals met" },
+        { "games_lost", "Games finished without moves" },
+        { "moves", "Swaps that produced a match" },
+        { "shuffles", "Boards reshuffled because no move was left" },
+        { "hints_shown", "Hints highlighted after idle time" },
+        { "hints_followed", "Moves that matched the highlighted hint" },
+    };
+
+    const HistogramInfo HISTOGRAMS[TELEMETRY_HISTOGRAM_COUNT] =
+    {
+        { "frame_seconds", "Render frame time", 1e-9 },
+        { "simulation_step_seconds", "Time spent in one fixed simulation step", 1e-9 },
+        { "cascade_depth", "Cascade steps after one move", 1.0 },
+        { "game_seconds", "Simulation time from start to end of a game", 1.0 },
+        { "game_moves", "Moves made in a finished game", 1.0 },
+        { "move_settle_seconds", "Simulation time from a move to a playable board", 1e-3 },
+        { "frame_allocations", "Heap allocations in one render frame", 1.0 },
+        { "simulation_step_allocations", "Heap allocations in one simulation step", 1.0 },
+    };
+
+    const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    // Пишет только поток-владелец, поэтому инкремент — загрузка и сохранение
+    // без lock-префикса; атомарность нужна только для чтения из collect()
+    struct TelemetryShard
+    {
+        std::atomic<std::uint64_t> counters[TELEMETRY_COUNTER_COUNT];
+        std::atomic<std::uint64_t> buckets[TELEMETRY_HISTOGRAM_COUNT][TELEMETRY_BUCKETS];
+        std::atomic<std::uint64_t> sums[TELEMETRY_HISTOGRAM_COUNT];
+        std::atomic<std::uint64_t> maxima[TELEMETRY_HISTOGRAM_COUNT];
+    };
+
+    // Счётчики потоков не освобождаются: их суммы остаются и после выхода потока
+    struct ShardRegistry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<TelemetryShard>> shards;
+    };
+
+    ShardRegistry& registry()
+    {
+        static ShardRegistry instance;
+        return instance;
+    }
+
+    thread_local TelemetryShard* currentShard = nullptr;
+
+    TelemetryShard& shard()
+    {
+        if (!currentShard)
+        {
+            ShardRegistry& shards = registry();
+            std::lock_guard<std::mutex> lock(shards.mutex);
+            shards.shards.emplace_back(new TelemetryShard()); // () обнуляет атомики
+            currentShard = shards.shards.back().get();
+        }
+        return *currentShard;
+    }
+
+    void add(std::atomic<std::uint64_t>& value, std::uint64_t amount)
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    int highestBit(std::uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    int bucketIndex(std::uint64_t value)
+    {
+        if (value < TELEMETRY_SUB_BUCKETS) return static_cast<int>(value);
+        if (value >> TELEMETRY_VALUE_BITS) return TELEMETRY_BUCKETS - 1;
+        int shift = highestBit(value) - TELEMETRY_SUB_BUCKET_BITS;
+        return TELEMETRY_SUB_BUCKETS * (shift + 1) + static_cast<int>((value >> shift) - TELEMETRY_SUB_BUCKETS);
+    }
+
+    std::uint64_t bucketHighest(int index)
+    {
+        if (index < TELEMETRY_SUB_BUCKETS) return static_cast<std::uint64_t>(index);
+        int shift = index / TELEMETRY_SUB_BUCKETS - 1;
+        std::uint64_t lowest = static_cast<std::uint64_t>(TELEMETRY_SUB_BUCKETS + index % TELEMETRY_SUB_BUCKETS) << shift;
+        return lowest + ((std::uint64_t(1) << shift) - 1);
+    }
+}
+
+void telemetryCount(TelemetryCounter counter, std::uint64_t amount)
+{
+    add(shard().counters[static_cast<int>(counter)], amount);
+}
+
+void telemetryRecord(TelemetryHistogram histogram, std::uint64_t value)
+{
+    TelemetryShard& own = shard();
+    int kind = static_cast<int>(histogram);
+    add(own.buckets[kind][bucketIndex(value)], 1);
+    add(own.sums[kind], value);
+    std::atomic<std::uint64_t>& maximum = own.maxima[kind];
+    if (value > maximum.load(std::memory_order_relaxed)) maximum.store(value, std::memory_order_relaxed);
+}
+
+TelemetrySnapshot::TelemetrySnapshot()
+    : counters(TELEMETRY_COUNTER_COUNT, 0),
+    buckets(TELEMETRY_HISTOGRAM_COUNT * TELEMETRY_BUCKETS, 0),
+    sums(TELEMETRY_HISTOGRAM_COUNT, 0),
+    maxima(TELEMETRY_HISTOGRAM_COUNT, 0)
+{
+}
+
+void TelemetrySnapshot::collect()
+{
+    std::fill(counters.begin(), counters.end(), 0);
+    std::fill(buckets.begin(), buckets.end(), 0);
+    std::fill(sums.begin(), sums.end(), 0);
+    std::fill(maxima.begin(), maxima.end(), 0);
+
+    ShardRegistry& shards = registry();
+    std::lock_guard<std::mutex> lock(shards.mutex);
+    for (const std::unique_ptr<TelemetryShard>& shard : shards.shards)
+    {
+        for (int i = 0; i < TELEMETRY_COUNTER_COUNT; ++i)
+        {
+            counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+        }
+        for (int kind = 0; kind < TELEMETRY_HISTOGRAM_COUNT; ++kind)
+        {
+            std::uint64_t* target = &buckets[kind * TELEMETRY_BUCKETS];
+            for (int i = 0; i < TELEMETRY_BUCKETS; ++i)
+            {
+                target[i] += shard->buckets[kind][i].load(std::memory_order_relaxed);
+            }
+            sums[kind] += shard->sums[kind].load(std::memory_order_relaxed);
+            maxima[kind] = std::max(maxima[kind], shard->maxima[kind].load(std::memory_order_relaxed));
+        }
+    }
+}
+
+std::uint64_t TelemetrySnapshot::getCounter(TelemetryCounter counter) const
+{
+    return counters[static_cast<int>(counter)];
+}
+
+std::uint64_t TelemetrySnapshot::getCount(TelemetryHistogram histogram) const
+{
+    const std::uint64_t* first = &buckets[static_cast<int>(histogram) * TELEMETRY_BUCKETS];
+    std::uint64_t count = 0;
+    for (int i = 0; i < TELEMETRY_BUCKETS; ++i) count += first[i];
+    return count;
+}
+
+std::uint64_t TelemetrySnapshot::getSum(TelemetryHistogram histogram) const
+{
+    return sums[static_cast<int>(histogram)];
+}
+
+std::uint64_t TelemetrySnapshot::getMax(TelemetryHistogram histogram) const
+{
+    return maxima[static_cast<int>(histogram)];
+}
+
+std::uint64_t TelemetrySnapshot::getQuantile(TelemetryHistogram histogram, double q) const
+{
+    std::uint64_t count = getCount(histogram);
+    if (count == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * count));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    const std::uint64_t* first = &buckets[static_cast<int>(histogram) * TELEMETRY_BUCKETS];
+    std::uint64_t seen = 0;
+    for (int i = 0; i < TELEMETRY_BUCKETS; ++i)
+    {
+        seen += first[i];
+        if (seen >= rank) return std::min(bucketHighest(i), getMax(histogram));
+    }
+    return getMax(histogram);
+}
+
+std::string TelemetrySnapshot::toPrometheus() const
+{
+    std::ostringstream out;
+    out.precision(9);
+    for (int i = 0; i < TELEMETRY_COUNTER_COUNT; ++i)
+    {
+        std::string name = std::string("bigwash_") + COUNTERS[i].key + "_total";
+        out << "# HELP " << name << ' ' << COUNTERS[i].help << '\n';
+        out << "# TYPE " << name << " counter\n";
+        out << name << ' ' << counters[i] << '\n';
+    }
+    for (int kind = 0; kind < TELEMETRY_HISTOGRAM_COUNT; ++kind)
+    {
+        const HistogramInfo& info = HISTOGRAMS[kind];
+        TelemetryHistogram histogram = static_cast<TelemetryHistogram>(kind);
+        std::string name = std::string("bigwash_") + info.key;
+        out << "# HELP " << name << ' ' << info.help << '\n';
+        out << "# TYPE " << name << " summary\n";
+        for (double q : QUANTILES)
+        {
+            out << name << "{quantile=\"" << q << "\"} " << getQuantile(histogram, q) * info.scale << '\n';
+        }
+        out << name << "_sum " << sums[kind] * info.scale << '\n';
+        out << name << "_count " << getCount(histogram) << '\n';
+        out << "# TYPE " << name << "_max gauge\n";
+        out << name << "_max " << maxima[kind] * info.scale << '\n';
+    }
+    return out.str();
+}
+
+std::string TelemetrySnapshot::toJsonLine(double unixSeconds) const
+{
+    std::ostringstream out;
+    out.precision(9);
+    out << "{\"time\":" << static_cast<long long>(unixSeconds) << ",\"counters\":{";
+    for (int i = 0; i < TELEMETRY_COUNTER_COUNT; ++i)
+    {
+        out << (i > 0 ? "," : "") << '"' << COUNTERS[i].key << "\":" << counters[i];
+    }
+    out << "},\"histograms\":{";
+    for (int kind = 0; kind < TELEMETRY_HISTOGRAM_COUNT; ++kind)
+    {
+        const HistogramInfo& info = HISTOGRAMS[kind];
+        TelemetryHistogram histogram = static_cast<TelemetryHistogram>(kind);
+        std::uint64_t count = getCount(histogram);
+        double mean = count > 0 ? static_cast<double>(sums[kind]) / count : 0.0;
+        out << (kind > 0 ? "," : "") << '"' << info.key << "\":{\"count\":" << count
+            << ",\"mean\":" << mean * info.scale
+            << ",\"p50\":" << getQuantile(histogram, 0.5) * info.scale
+            << ",\"p99\":" << getQuantile(histogram, 0.99) * info.scale
+            << ",\"max\":" << maxima[kind] * info.scale << '}';
+    }
+    out << "}}";
+    return out.str();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Счётчики партии. Порядок совпадает с таблицей имён в telemetry.cpp.
+enum class TelemetryCounter
+{
+    GamesStarted,
+    GamesWon,
+    GamesLost,
+    MovesMade,
+    Shuffles,
+    HintsShown,
+    HintsFollowed, // Игрок сделал подсвеченный ход
+};
+const int TELEMETRY_COUNTER_COUNT = 7;
+
+// Распределения. Значения — целые в единицах из названия.
+enum class TelemetryHistogram
+{
+    FrameNanoseconds,
+    SimulationStepNanoseconds,
+    CascadeDepth,
+    GameSeconds,
+    GameMoves,
+    MoveSettleMilliseconds, // От засчитанного хода до доски, готовой к следующему
+    FrameAllocations,       // Выделений кучи за кадр отрисовки, только со счётчиком выделений
+    SimulationStepAllocations,
+};
+const int TELEMETRY_HISTOGRAM_COUNT = 8;
+
+// Лог-линейные корзины: до 32 значения точные, дальше на каждую степень
+// двойки 32 корзины, ошибка квантиля не больше 1/32. Всё, что больше
+// 2^40, попадает в последнюю корзину.
+const int TELEMETRY_SUB_BUCKET_BITS = 5;
+const int TELEMETRY_SUB_BUCKETS = 1 << TELEMETRY_SUB_BUCKET_BITS;
+const int TELEMETRY_VALUE_BITS = 40;
+const int TELEMETRY_BUCKETS = TELEMETRY_SUB_BUCKETS * (TELEMETRY_VALUE_BITS - TELEMETRY_SUB_BUCKET_BITS + 1);
+
+// Запись из любого потока без блокировок: у каждого потока свои счётчики,
+// в которые пишет только он. Первая запись потока регистрирует его
+// счётчики под мьютексом, дальше — только обычные загрузки и сохранения.
+void telemetryCount(TelemetryCounter counter, std::uint64_t amount = 1);
+void telemetryRecord(TelemetryHistogram histogram, std::uint64_t value);
+
+// Сумма по всем потокам на момент collect(). Значения одного потока могут
+// отставать на несколько записей — для метрик это неважно.
+class TelemetrySnapshot
+{
+public:
+    TelemetrySnapshot();
+
+    void collect();
+
+    std::uint64_t getCounter(TelemetryCounter counter) const;
+    std::uint64_t getCount(TelemetryHistogram histogram) const;
+    std::uint64_t getSum(TelemetryHistogram histogram) const;
+    std::uint64_t getMax(TelemetryHistogram histogram) const;
+    // Верхняя граница корзины, в которую попал квантиль q из 0..1
+    std::uint64_t getQuantile(TelemetryHistogram histogram, double q) const;
+
+    // Текстовый формат Prometheus 0.0.4: счётчики и сводки с квантилями
+    std::string toPrometheus() const;
+    // Одна строка JSON для журнала: время, счётчики, число/среднее/p50/p99/максимум
+    std::string toJsonLine(double unixSeconds) const;
+
+private:
+    std::vector<std::uint64_t> counters;
+    std::vector<std::uint64_t> buckets; // TELEMETRY_HISTOGRAM_COUNT * TELEMETRY_BUCKETS
+    std::vector<std::uint64_t> sums;
+    std::vector<std::uint64_t> maxima;
+};
@@ -0,0 +1,121 @@
+#include "telemetry_exporter.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    const std::size_t MAX_REQUEST_BYTES = 4096;
+    const sf::Time POLL_INTERVAL = sf::milliseconds(100);
+    const sf::Time CLIENT_TIMEOUT = sf::seconds(1.0f);
+
+    std::string httpResponse(const char* status, const std::string& body)
+    {
+        return std::string("HTTP/1.0 ") + status + "\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+    }
+}
+
+TelemetryExporter::TelemetryExporter(unsigned short port, const std::string& logPath, float flushSeconds)
+    : logPath(logPath), flushSeconds(flushSeconds)
+{
+    if (port != 0)
+    {
+        // Только петля: метрики не должны торчать в локальную сеть
+        if (listener.listen(port, sf::IpAddress::LocalHost) == sf::Socket::Done)
+        {
+            serving = true;
+            std::cout << "Metrics: http://127.0.0.1:" << port << "/metrics" << std::endl;
+        }
+        else
+        {
+            std::cerr << "Failed to listen for metrics on port " << port << std::endl;
+        }
+    }
+    thread = std::thread(&TelemetryExporter::run, this);
+}
+
+TelemetryExporter::~TelemetryExporter()
+{
+    running.store(false, std::memory_order_release);
+    thread.join();
+    flush();
+}
+
+void TelemetryExporter::run()
+{
+    sf::SocketSelector selector;
+    if (serving) selector.add(listener);
+
+    sf::Clock sinceFlush;
+    while (running.load(std::memory_order_acquire))
+    {
+        if (!serving)
+        {
+            sf::sleep(POLL_INTERVAL);
+        }
+        else if (selector.wait(POLL_INTERVAL) && selector.isReady(listener))
+        {
+            sf::TcpSocket client;
+            if (listener.accept(client) == sf::Socket::Done)
+            {
+                serveClient(client);
+            }
+        }
+
+        if (sinceFlush.getElapsedTime().asSeconds() >= flushSeconds)
+        {
+            flush();
+            sinceFlush.restart();
+        }
+    }
+}
+
+void TelemetryExporter::serveClient(sf::TcpSocket& client)
+{
+    // Заголовки читаются до пустой строки; медленный клиент не держит поток дольше таймаута
+    sf::SocketSelector selector;
+    selector.add(client);
+    std::string request;
+    char buffer[512];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES)
+    {
+        std::size_t received = 0;
+        if (!selector.wait(CLIENT_TIMEOUT) || client.receive(buffer, sizeof(buffer), received) != sf::Socket::Done)
+        {
+            return;
+        }
+        request.append(buffer, received);
+    }
+
+    std::string response;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0)
+    {
+        snapshot.collect();
+        response = httpResponse("200 OK", snapshot.toPrometheus());
+    }
+    else
+    {
+        response = httpResponse("404 Not Found", "Only GET /metrics is served\n");
+    }
+    client.send(response.data(), response.size());
+    client.disconnect();
+}
+
+void TelemetryExporter::flush()
+{
+    if (logPath.empty()) return;
+
+    std::ofstream log(logPath, std::ios::app);
+    if (!log)
+    {
+        std::cerr << "Failed to open " << logPath << std::endl;
+        return;
+    }
+    snapshot.collect();
+    double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    log << snapshot.toJsonLine(now) << '\n';
+}
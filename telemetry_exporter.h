@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "telemetry.h"
+
+// Порт по умолчанию для сбора метрик Prometheus
+const unsigned short TELEMETRY_DEFAULT_PORT = 9464;
+
+// Свой поток, который раз в flushSeconds дописывает строку JSON в журнал
+// и отвечает на GET /metrics только с localhost. Порт 0 — без HTTP,
+// пустой путь — без журнала. Запись метрик его не ждёт: поток только
+// читает счётчики потоков через TelemetrySnapshot.
+class TelemetryExporter
+{
+public:
+    TelemetryExporter(unsigned short port, const std::string& logPath, float flushSeconds = 10.0f);
+    ~TelemetryExporter(); // Останавливает поток и дописывает последнюю строку
+
+    TelemetryExporter(const TelemetryExporter&) = delete;
+    TelemetryExporter& operator=(const TelemetryExporter&) = delete;
+
+    bool isServing() const { return serving; }
+
+private:
+    void run();
+    void serveClient(sf::TcpSocket& client);
+    void flush();
+
+    sf::TcpListener listener;
+    bool serving = false;
+    std::string logPath;
+    float flushSeconds;
+    TelemetrySnapshot snapshot; // Только для потока экспорта
+    std::atomic<bool> running{ true };
+    std::thread thread;
+};
@@ -0,0 +1,106 @@
+#include "texture_atlas.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool TextureAtlas::loadFromFile(const std::string& texturePath, const std::string& tablePath)
+{
+    if (!texture.loadFromFile(texturePath))
+    {
+        return false;
+    }
+
+    std::ifstream table(tablePath);
+    if (!table)
+    {
+        std::cerr << "Failed to open atlas table " << tablePath << std::endl;
+        return false;
+    }
+
+    regions.clear();
+    std::string line;
+    while (std::getline(table, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string name;
+        sf::IntRect rect;
+        if (fields >> name >> rect.left >> rect.top >> rect.width >> rect.height)
+        {
+            regions[name] = rect;
+        }
+    }
+
+    // Типы тайлов идут подряд: tile1, tile2, ... до первого пропуска
+    tileRegions.assign(1, sf::IntRect());
+    for (int type = 1; type <= MAX_TILE_TYPES; ++type)
+    {
+        auto it = regions.find("tile" + std::to_string(type));
+        if (it == regions.end()) break;
+        tileRegions.push_back(it->second);
+    }
+
+    if (getTileTypeCount() < 3)
+    {
+        std::cerr << "Atlas " << tablePath << " has fewer than 3 tile types" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const sf::IntRect& TextureAtlas::getRegion(const std::string& name) const
+{
+    static const sf::IntRect empty;
+    auto it = regions.find(name);
+    if (it == regions.end())
+    {
+        std::cerr << "Warning: No atlas region " << name << std::endl;
+        return empty;
+    }
+    return it->second;
+}
+
+const sf::IntRect* TextureAtlas::getTileRegion(int value) const
+{
+    if (value < 1 || value >= static_cast<int>(tileRegions.size()))
+    {
+        return nullptr;
+    }
+    return &tileRegions[value];
+}
+
+void SpriteBatch::add(const sf::IntRect& region, sf::Vector2f position, sf::Vector2f scale, sf::Color color, bool rotated)
+{
+    float width = region.width * scale.x;
+    float height = region.height * scale.y;
+    float left = static_cast<float>(region.left);
+    float top = static_cast<float>(region.top);
+    float right = left + region.width;
+    float bottom = top + region.height;
+
+    sf::Vector2f uv[4] = {
+        sf::Vector2f(left, top), sf::Vector2f(right, top),
+        sf::Vector2f(right, bottom), sf::Vector2f(left, bottom)
+    };
+    if (rotated)
+    {
+        // Сдвигаем текстурные координаты по кругу на один угол
+        sf::Vector2f first = uv[3];
+        uv[3] = uv[2];
+        uv[2] = uv[1];
+        uv[1] = uv[0];
+        uv[0] = first;
+    }
+
+    vertices.append(sf::Vertex(position, color, uv[0]));
+    vertices.append(sf::Vertex(sf::Vector2f(position.x + width, position.y), color, uv[1]));
+    vertices.append(sf::Vertex(sf::Vector2f(position.x + width, position.y + height), color, uv[2]));
+    vertices.append(sf::Vertex(sf::Vector2f(position.x, position.y + height), color, uv[3]));
+}
+
+void SpriteBatch::draw(sf::RenderTarget& target) const
+{
+    target.draw(vertices, sf::RenderStates(&atlas.getTexture()));
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tile_value.h"
+
+// Атлас, собранный atlas_packer: одна текстура и таблица областей по именам.
+// Тайлы игрового поля — области tile1..tileN.
+class TextureAtlas
+{
+public:
+    bool loadFromFile(const std::string& texturePath, const std::string& tablePath);
+
+    const sf::Texture& getTexture() const { return texture; }
+
+    bool hasRegion(const std::string& name) const { return regions.count(name) != 0; }
+    const sf::IntRect& getRegion(const std::string& name) const;
+
+    // Количество типов тайлов, найденных в таблице (tile1..tileN подряд)
+    int getTileTypeCount() const { return static_cast<int>(tileRegions.size()) - 1; }
+    // Область тайла или nullptr для пустых и угловых ячеек
+    const sf::IntRect* getTileRegion(int value) const;
+
+private:
+    sf::Texture texture;
+    std::unordered_map<std::string, sf::IntRect> regions;
+    std::vector<sf::IntRect> tileRegions; // Индекс — значение тайла, [0] не используется
+};
+
+// Накопитель четырёхугольников из одного атласа: всё, что в нём лежит,
+// рисуется одним вызовом draw с одной привязкой текстуры
+class SpriteBatch
+{
+public:
+    explicit SpriteBatch(const TextureAtlas& atlas) : atlas(atlas), vertices(sf::Quads) {}
+
+    void clear() { vertices.clear(); }
+    // rotated — повернуть картинку на 90° по часовой стрелке внутри того же квадрата
+    void add(const sf::IntRect& region, sf::Vector2f position,
+        sf::Vector2f scale = sf::Vector2f(1.0f, 1.0f), sf::Color color = sf::Color::White, bool rotated = false);
+    void draw(sf::RenderTarget& target) const;
+
+private:
+    const TextureAtlas& atlas;
+    sf::VertexArray vertices;
+};
@@ -0,0 +1,222 @@
+#include "tile_shader.h"
+
+#include <iostream>
+
+namespace
+{
+    // Минимум OpenGL 2.1 — 128 vec4 в вершинном шейдере. На клетку уходит
+    // два, остальное — области атласа, стрелки и три числа (по слоту на каждое).
+    const int MAX_VERTEX_UNIFORM_VECTORS = 128;
+    const int SHARED_UNIFORM_VECTORS = 4;
+    const int REGION_COUNT = MAX_TILE_TYPES + 2; // 0 — пусто, 1..8 — тайлы, 9 — угол
+
+    const char* const VERTEX_SHADER = R"(
+uniform vec4 u_motion[CELL_COUNT];        // from.xy, to.xy
+uniform vec4 u_timing[CELL_COUNT];        // начало, длительность, вид*256+значение, начало выделения
+uniform vec4 u_regions[REGION_COUNT];     // Область атласа по цвету, пиксели
+uniform vec4 u_arrows;
+uniform float u_time;
+uniform float u_effectTime;
+uniform float u_tileTypes;
+
+float hash(float n)
+{
+    return fract(sin(n) * 43758.5453);
+}
+
+void main()
+{
+    int cell = int(floor(gl_Color.a * 255.0 + 0.5));
+    bool overlay = gl_Color.r > 0.5;
+    vec2 corner = gl_Vertex.xy;
+
+    vec4 motion = u_motion[cell];
+    vec4 timing = u_timing[cell];
+    float kind = floor(timing.z / 256.0);
+    float value = timing.z - kind * 256.0;
+    float special = floor(value / 16.0);
+    float color = value - special * 16.0;
+
+    float progress = timing.y > 0.0 ? clamp((u_time - timing.x) / timing.y, 0.0, 1.0) : 1.0;
+    vec2 position = motion.zw;
+    float alpha = 1.0;
+    vec2 scale = vec2(1.0);
+    // Удаляемый сжимается, появляющийся растёт — к левому верхнему углу, как спрайт на CPU
+    if (kind == 1.0 || kind == 4.0) position = mix(motion.xy, motion.zw, progress);
+    else if (kind == 2.0)
+    {
+        alpha = 1.0 - progress;
+        scale = vec2(1.0 - progress);
+    }
+    else if (kind == 3.0)
+    {
+        alpha = progress;
+        scale = vec2(progress);
+    }
+
+    if (timing.w >= 0.0)
+    {
+        // Пульсация и дрожь выделенного тайла
+        scale *= 1.0 + 0.1 * sin((u_time - timing.w) * 10.0);
+        float tick = floor(u_time * 120.0) + float(cell) * 7.0;
+        position += (floor(vec2(hash(tick), hash(tick + 3.1)) * 5.0) - 2.0) * 0.5;
+    }
+
+    vec3 tint = vec3(1.0);
+    if (special == 4.0) color = 1.0 + mod(floor(u_effectTime * 6.0), u_tileTypes);
+    if (special == 3.0)
+    {
+        float pulse = (170.0 + 85.0 * sin(u_effectTime * 6.0)) / 255.0;
+        tint = vec3(1.0, pulse, pulse);
+    }
+
+    vec4 region = u_regions[int(min(color, float(REGION_COUNT - 1)))];
+    vec2 size = region.zw * scale;
+    vec2 uv = corner;
+    if (overlay)
+    {
+        // Стрелки линейного бонуса поверх тайла, для столбца повёрнуты
+        bool line = special == 1.0 || special == 2.0;
+        alpha *= line ? 0.5 : 0.0;
+        tint = vec3(1.0);
+        if (special == 2.0) uv = vec2(corner.y, 1.0 - corner.x);
+        region = line ? u_arrows : vec4(0.0);
+        if (!line) size = vec2(0.0);
+    }
+
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(position + corner * size, 0.0, 1.0);
+    gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(region.xy + uv * region.zw, 0.0, 1.0);
+    gl_FrontColor = vec4(tint, alpha);
+}
+)";
+
+    const char* const FRAGMENT_SHADER = R"(
+uniform sampler2D u_texture;
+
+void main()
+{
+    gl_FragColor = texture2D(u_texture, gl_TexCoord[0].xy) * gl_Color;
+}
+)";
+
+    sf::Glsl::Vec4 toVec4(const sf::IntRect* region)
+    {
+        if (!region) return sf::Glsl::Vec4(0, 0, 0, 0);
+        return sf::Glsl::Vec4(static_cast<float>(region->left), static_cast<float>(region->top),
+            static_cast<float>(region->width), static_cast<float>(region->height));
+    }
+}
+
+TileShaderRenderer::TileShaderRenderer(const TextureAtlas& atlas, int cellCount) :
+    atlas(atlas),
+    cellCount(cellCount),
+    vertices(sf::Quads, sf::VertexBuffer::Static)
+{
+}
+
+bool TileShaderRenderer::isAvailable()
+{
+    return sf::Shader::isAvailable() && sf::VertexBuffer::isAvailable();
+}
+
+bool TileShaderRenderer::load(int tileTypeCount)
+{
+    loaded = false;
+    if (!isAvailable())
+    {
+        std::cerr << "Shaders or vertex buffers are not supported, drawing tiles on the CPU" << std::endl;
+        return false;
+    }
+    // Номер клетки идёт в альфа-канале вершины
+    if (cellCount > 255 || 2 * cellCount + REGION_COUNT + SHARED_UNIFORM_VECTORS > MAX_VERTEX_UNIFORM_VECTORS)
+    {
+        std::cerr << "Board of " << cellCount << " cells does not fit the tile shader" << std::endl;
+        return false;
+    }
+
+    std::string header = "#version 120\n#define CELL_COUNT " + std::to_string(cellCount) +
+        "\n#define REGION_COUNT " + std::to_string(REGION_COUNT) + "\n";
+    if (!shader.loadFromMemory(header + VERTEX_SHADER, std::string("#version 120\n") + FRAGMENT_SHADER))
+    {
+        std::cerr << "Failed to compile tile shader" << std::endl;
+        return false;
+    }
+
+    // По два квадрата на клетку: тайл и слой стрелок. Углы — 0/1,
+    // номер клетки — в альфе, слой — в красном канале.
+    std::vector<sf::Vertex> quads;
+    quads.reserve(cellCount * 8);
+    const sf::Vector2f corners[4] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+    for (int cell = 0; cell < cellCount; ++cell)
+    {
+        for (int layer = 0; layer < 2; ++layer)
+        {
+            sf::Color marker(layer ? 255 : 0, 0, 0, static_cast<sf::Uint8>(cell));
+            for (const auto& corner : corners) quads.emplace_back(corner, marker);
+        }
+    }
+    if (!vertices.create(quads.size()) || !vertices.update(quads.data()))
+    {
+        std::cerr << "Failed to create tile vertex buffer" << std::endl;
+        return false;
+    }
+
+    sf::Glsl::Vec4 regions[REGION_COUNT];
+    for (int color = 0; color < REGION_COUNT; ++color)
+    {
+        regions[color] = toVec4(color >= 1 && color <= tileTypeCount ? atlas.getTileRegion(color) : nullptr);
+    }
+    shader.setUniformArray("u_regions", regions, REGION_COUNT);
+    shader.setUniform("u_arrows", toVec4(atlas.hasRegion("arrows") ? &atlas.getRegion("arrows") : nullptr));
+    shader.setUniform("u_tileTypes", static_cast<float>(tileTypeCount));
+    shader.setUniform("u_texture", sf::Shader::CurrentTexture);
+
+    motionNames.clear();
+    timingNames.clear();
+    for (int cell = 0; cell < cellCount; ++cell)
+    {
+        motionNames.push_back("u_motion[" + std::to_string(cell) + "]");
+        timingNames.push_back("u_timing[" + std::to_string(cell) + "]");
+    }
+
+    // Заведомо отличается от любого настоящего трека: первый setTracks зальёт всё
+    TileTrack invalid;
+    invalid.kind = -1;
+    uploaded.assign(cellCount, invalid);
+
+    loaded = true;
+    return true;
+}
+
+void TileShaderRenderer::setTracks(const TileTrack* tracks, int count)
+{
+    if (!loaded) return;
+
+    for (int cell = 0; cell < count && cell < cellCount; ++cell)
+    {
+        const TileTrack& track = tracks[cell];
+        if (track == uploaded[cell]) continue;
+
+        uploaded[cell] = track;
+        shader.setUniform(motionNames[cell], sf::Glsl::Vec4(track.from.x, track.from.y, track.to.x, track.to.y));
+        shader.setUniform(timingNames[cell], sf::Glsl::Vec4(track.startTime, track.duration,
+            static_cast<float>(track.kind * 256 + track.value), track.selectStart));
+    }
+}
+
+void TileShaderRenderer::setTime(float animationTime, float effectTime)
+{
+    if (!loaded) return;
+
+    shader.setUniform("u_time", animationTime);
+    shader.setUniform("u_effectTime", effectTime);
+}
+
+void TileShaderRenderer::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    if (!loaded) return;
+
+    states.texture = &atlas.getTexture();
+    states.shader = &shader;
+    target.draw(vertices, states);
+}
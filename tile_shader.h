@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+#include "texture_atlas.h"
+
+// Анимация тайла в замкнутой форме: по виду, концам, времени начала и
+// длительности её состояние в любой момент вычисляется без пошагового
+// интегрирования. Виды совпадают с TileState: 0 — покой, 1 — движение,
+// 2 — исчезновение, 3 — появление, 4 — падение.
+struct TileTrack
+{
+    int value = 0;          // Значение клетки: цвет и бонус
+    int kind = 0;
+    sf::Vector2f from;
+    sf::Vector2f to;        // В покое — текущая позиция
+    float startTime = 0.0f; // Время симуляции, секунды
+    float duration = 0.0f;
+    float selectStart = -1.0f; // Начало пульсации выделения, -1 — не выделен
+
+    bool operator==(const TileTrack& other) const
+    {
+        return value == other.value && kind == other.kind && from == other.from && to == other.to &&
+            startTime == other.startTime && duration == other.duration && selectStart == other.selectStart;
+    }
+    bool operator!=(const TileTrack& other) const { return !(*this == other); }
+};
+
+// Отрисовка тайлов вершинным шейдером. Геометрия в буфере вершин
+// статична: каждая вершина знает только номер клетки и угол квадрата.
+// Позицию, прозрачность, масштаб, пульсацию бонусов и выбор картинки шейдер
+// вычисляет из времени и параметров анимации в uniform-массивах, которые
+// обновляются только для клеток, где началась новая анимация. Кадр стоит
+// две uniform-переменные и один вызов draw, сколько бы тайлов ни двигалось.
+// Шейдеры — GLSL 1.20, массивы укладываются в минимальные 128 vec4
+// OpenGL 2.1, поэтому режим работает и на программном Mesa (llvmpipe).
+class TileShaderRenderer : public sf::Drawable
+{
+public:
+    TileShaderRenderer(const TextureAtlas& atlas, int cellCount);
+
+    // Поддерживает ли драйвер шейдеры и буферы вершин
+    static bool isAvailable();
+
+    // Компилирует шейдер и строит буфер вершин. false — остаёмся на CPU.
+    bool load(int tileTypeCount);
+
+    // Обновляет параметры только изменившихся клеток
+    void setTracks(const TileTrack* tracks, int count);
+    // animationTime — время симуляции снимка, effectTime — для пульсации бонусов
+    void setTime(float animationTime, float effectTime);
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    const TextureAtlas& atlas;
+    int cellCount;
+    bool loaded = false;
+
+    sf::Shader shader;
+    sf::VertexBuffer vertices;
+    std::vector<TileTrack> uploaded;
+    std::vector<std::string> motionNames;
+    std::vector<std::string> timingNames;
+};
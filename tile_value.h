@@ -0,0 +1,28 @@
+#pragma once
+
+// Значение ячейки: младшие 4 бита — цвет (1..8, 0 — пусто, 9 — угол),
+// следующие — вид бонусного тайла. Цветная бомба не имеет цвета.
+
+// Максимум типов тайлов: значения 1..8, 9 занято угловыми ячейками
+const int MAX_TILE_TYPES = 8;
+
+const int TILE_COLOR_MASK = 0xF;
+const int SPECIAL_SHIFT = 4;
+const int BLOCKED_TILE = 9;
+
+enum class SpecialTile
+{
+    None = 0,
+    LineHorizontal = 1, // Очищает строку
+    LineVertical = 2,   // Очищает столбец
+    Bomb = 3,           // Очищает квадрат 3x3
+    ColorBomb = 4       // Очищает все тайлы одного цвета
+};
+
+const int SPECIAL_TILE_KINDS = 5;
+
+inline int tileColor(int value) { return value & TILE_COLOR_MASK; }
+inline SpecialTile tileSpecial(int value) { return static_cast<SpecialTile>(value >> SPECIAL_SHIFT); }
+inline int makeTile(int color, SpecialTile special) { return color | (static_cast<int>(special) << SPECIAL_SHIFT); }
+// Участвует ли тайл в совпадениях по цвету
+inline bool isMatchable(int value) { return tileColor(value) != 0 && tileColor(value) != BLOCKED_TILE; }
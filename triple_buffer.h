@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+// Тройной буфер без блокировок: один писатель (поток симуляции)
+// и один читатель (поток отрисовки). Писатель всегда пишет в свой
+// задний буфер, читатель всегда читает свой передний, средний буфер
+// передаётся между ними атомарным обменом индекса.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : backIndex(0), middle(1), frontIndex(2)
+    {
+    }
+
+    // Буфер, который заполняет писатель перед publish()
+    T& writeBuffer() { return buffers[backIndex]; }
+
+    // Отдаёт заполненный буфер читателю. Если читатель не успел забрать
+    // предыдущий снимок, тот просто перезаписывается следующим.
+    void publish()
+    {
+        int previous = middle.exchange(backIndex | DIRTY_BIT, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Забирает самый свежий снимок. Возвращает false, если нового нет.
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & DIRTY_BIT) == 0)
+        {
+            return false;
+        }
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Снимок, который сейчас принадлежит читателю
+    const T& readBuffer() const { return buffers[frontIndex]; }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int DIRTY_BIT = 0x4;
+
+    T buffers[3];
+    alignas(64) int backIndex;          // Только для писателя
+    alignas(64) std::atomic<int> middle; // Общий индекс + флаг нового снимка
+    alignas(64) int frontIndex;         // Только для читателя
+};